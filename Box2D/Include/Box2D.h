@@ -22,9 +22,11 @@
 // These include files constitute the main Box2D API
 
 #include "../Source/Common/b2Settings.h"
+#include "../Source/Common/b2Simd.h"
 
 #include "../Source/Collision/b2Shape.h"
 #include "../Source/Collision/b2BroadPhase.h"
+#include "../Source/Collision/b2TreeBroadPhase.h"
 #include "../Source/Dynamics/b2WorldCallbacks.h"
 #include "../Source/Dynamics/b2World.h"
 #include "../Source/Dynamics/b2Body.h"
@@ -69,12 +69,23 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 
 	b2Assert(worldAABB.IsValid());
 	m_worldAABB = worldAABB;
-	m_proxyCount = 0;
 
 	b2Vec2 d = worldAABB.maxVertex - worldAABB.minVertex;
 	m_quantizationFactor.x = USHRT_MAX / d.x;
 	m_quantizationFactor.y = USHRT_MAX / d.y;
 
+	Reset();
+}
+
+b2BroadPhase::~b2BroadPhase()
+{
+}
+
+void b2BroadPhase::Reset()
+{
+	m_pairManager.Reset();
+	m_proxyCount = 0;
+
 	for (uint16 i = 0; i < b2_maxProxies - 1; ++i)
 	{
 		m_proxyPool[i].SetNext(i + 1);
@@ -82,7 +93,7 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 		m_proxyPool[i].overlapCount = b2_invalid;
 		m_proxyPool[i].userData = NULL;
 	}
-	m_proxyPool[b2_maxProxies-1].SetNext(b2_nullProxy);
+	m_proxyPool[b2_maxProxies-1].SetNext(b2_invalid);
 	m_proxyPool[b2_maxProxies-1].timeStamp = 0;
 	m_proxyPool[b2_maxProxies-1].overlapCount = b2_invalid;
 	m_proxyPool[b2_maxProxies-1].userData = NULL;
@@ -92,10 +103,6 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 	m_queryResultCount = 0;
 }
 
-b2BroadPhase::~b2BroadPhase()
-{
-}
-
 // This one is only used for validation.
 bool b2BroadPhase::TestOverlap(b2Proxy* p1, b2Proxy* p2)
 {
@@ -234,10 +241,10 @@ void b2BroadPhase::Query(int32* lowerQueryOut, int32* upperQueryOut,
 	*upperQueryOut = upperQuery;
 }
 
-uint16 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
 	b2Assert(m_proxyCount < b2_maxProxies);
-	b2Assert(m_freeProxy != b2_nullProxy);
+	b2Assert(m_freeProxy != b2_invalid);
 
 	uint16 proxyId = m_freeProxy;
 	b2Proxy* proxy = m_proxyPool + proxyId;
@@ -605,6 +612,16 @@ void b2BroadPhase::Commit()
 	m_pairManager.Commit();
 }
 
+int32 b2BroadPhase::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
+int32 b2BroadPhase::GetPairCount() const
+{
+	return m_pairManager.m_pairCount;
+}
+
 int32 b2BroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
 {
 	uint16 lowerValues[2];
@@ -647,7 +664,7 @@ void b2BroadPhase::Validate()
 		{
 			b2Bound* bound = bounds + i;
 			b2Assert(i == 0 || bounds[i-1].value <= bound->value);
-			b2Assert(bound->proxyId != b2_nullProxy);
+			b2Assert(bound->proxyId != b2_invalid);
 			b2Assert(m_proxyPool[bound->proxyId].IsValid());
 
 			if (bound->IsLower() == true)
@@ -29,6 +29,7 @@ Bullet (http:/www.bulletphysics.com).
 #include "../Common/b2Settings.h"
 #include "b2Collision.h"
 #include "b2PairManager.h"
+#include "b2BroadPhaseInterface.h"
 #include <climits>
 #include <cstring>
 
@@ -58,7 +59,7 @@ struct b2Proxy
 	void* userData;
 };
 
-class b2BroadPhase
+class b2BroadPhase : public b2BroadPhaseInterface
 {
 public:
 	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
@@ -70,7 +71,7 @@ public:
 	bool InRange(const b2AABB& aabb) const;
 
 	// Create and destroy proxies. These call Flush first.
-	uint16 CreateProxy(const b2AABB& aabb, void* userData);
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
 	void DestroyProxy(int32 proxyId);
 
 	// Call MoveProxy as many times as you like, then when you are done
@@ -78,6 +79,11 @@ public:
 	void MoveProxy(int32 proxyId, const b2AABB& aabb);
 	void Commit();
 
+	int32 GetProxyCount() const;
+	int32 GetPairCount() const;
+
+	void Reset();
+
 	// Get a single proxy. Returns NULL if the id is invalid.
 	b2Proxy* GetProxy(int32 proxyId);
 
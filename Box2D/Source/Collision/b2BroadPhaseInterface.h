@@ -0,0 +1,63 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BROAD_PHASE_INTERFACE_H
+#define B2_BROAD_PHASE_INTERFACE_H
+
+#include "b2Collision.h"
+
+const int32 b2_nullProxy = -1;
+
+enum b2BroadPhaseType
+{
+	b2_sweepAndPrune,	// b2BroadPhase: quantized bounds, at most b2_maxProxies
+	b2_dynamicTree,		// b2TreeBroadPhase: no proxy cap, no quantization
+};
+
+// What b2World and b2Shape need from a broad-phase. Proxy ids are never
+// negative; b2_nullProxy marks a shape without a proxy.
+class b2BroadPhaseInterface
+{
+public:
+	virtual ~b2BroadPhaseInterface() {}
+
+	// Use this to see if your proxy is in range. If it is not in range,
+	// it should be destroyed.
+	virtual bool InRange(const b2AABB& aabb) const = 0;
+
+	virtual int32 CreateProxy(const b2AABB& aabb, void* userData) = 0;
+	virtual void DestroyProxy(int32 proxyId) = 0;
+
+	// Call MoveProxy as many times as you like, then when you are done
+	// call Commit to finalized the proxy pairs (for your time step).
+	virtual void MoveProxy(int32 proxyId, const b2AABB& aabb) = 0;
+	virtual void Commit() = 0;
+
+	// Query an AABB for overlapping proxies, returns the user data and
+	// the count, up to the supplied maximum count.
+	virtual int32 Query(const b2AABB& aabb, void** userData, int32 maxCount) = 0;
+
+	virtual int32 GetProxyCount() const = 0;
+	virtual int32 GetPairCount() const = 0;
+
+	// Drop every proxy and pair at once. Nothing is reported to the pair
+	// callback; allocated capacity is kept.
+	virtual void Reset() = 0;
+};
+
+#endif
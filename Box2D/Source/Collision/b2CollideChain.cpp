@@ -0,0 +1,307 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2Collision.h"
+#include "b2Shape.h"
+
+// Chain segments collide as capsules: the segment grown by the chain radius.
+// Polygons and segments are handled together as rounded polygons in world
+// coordinates, a segment being a two sided polygon with two vertices.
+
+struct b2RoundPoly
+{
+	b2Vec2 vertices[b2_maxPolyVertices];
+	b2Vec2 normals[b2_maxPolyVertices];
+	int32 count;
+	float32 radius;
+};
+
+struct ClipVertex
+{
+	b2Vec2 v;
+	b2ContactID id;
+};
+
+static int32 ClipSegmentToLine(ClipVertex vOut[2], ClipVertex vIn[2],
+					  const b2Vec2& normal, float32 offset)
+{
+	// Start with no output points
+	int32 numOut = 0;
+
+	// Calculate the distance of end points to the line
+	float32 distance0 = b2Dot(normal, vIn[0].v) - offset;
+	float32 distance1 = b2Dot(normal, vIn[1].v) - offset;
+
+	// If the points are behind the plane
+	if (distance0 <= 0.0f) vOut[numOut++] = vIn[0];
+	if (distance1 <= 0.0f) vOut[numOut++] = vIn[1];
+
+	// If the points are on different sides of the plane
+	if (distance0 * distance1 < 0.0f)
+	{
+		// Find intersection point of edge and plane
+		float32 interp = distance0 / (distance0 - distance1);
+		vOut[numOut].v = vIn[0].v + interp * (vIn[1].v - vIn[0].v);
+		if (distance0 > 0.0f)
+		{
+			vOut[numOut].id = vIn[0].id;
+		}
+		else
+		{
+			vOut[numOut].id = vIn[1].id;
+		}
+		++numOut;
+	}
+
+	return numOut;
+}
+
+static void SetSegment(b2RoundPoly* poly, const b2ChainShape* chain, int32 segment)
+{
+	b2Vec2 v1 = chain->GetVertex(segment);
+	b2Vec2 v2 = chain->GetVertex(segment + 1);
+	b2Vec2 normal = b2Cross(v2 - v1, 1.0f);
+	normal.Normalize();
+
+	poly->vertices[0] = v1;
+	poly->vertices[1] = v2;
+	poly->normals[0] = normal;
+	poly->normals[1] = -normal;
+	poly->count = 2;
+	poly->radius = chain->m_radius;
+}
+
+static void SetPoly(b2RoundPoly* poly, const b2PolyShape* shape)
+{
+	for (int32 i = 0; i < shape->m_vertexCount; ++i)
+	{
+		poly->vertices[i] = shape->m_position + b2Mul(shape->m_R, shape->m_vertices[i]);
+		poly->normals[i] = b2Mul(shape->m_R, shape->m_normals[i]);
+	}
+	poly->count = shape->m_vertexCount;
+	poly->radius = 0.0f;
+}
+
+// Find the max separation between poly1 and poly2 using edge normals from
+// poly1, ignoring the radii. The polygons are small, so every edge is tried.
+static float32 FindMaxSeparation(int32* edgeIndex, const b2RoundPoly& poly1, const b2RoundPoly& poly2)
+{
+	int32 bestEdge = 0;
+	float32 bestSeparation = -FLT_MAX;
+	for (int32 i = 0; i < poly1.count; ++i)
+	{
+		b2Vec2 normal = poly1.normals[i];
+		float32 separation = FLT_MAX;
+		for (int32 j = 0; j < poly2.count; ++j)
+		{
+			separation = b2Min(separation, b2Dot(normal, poly2.vertices[j] - poly1.vertices[i]));
+		}
+
+		if (separation > bestSeparation)
+		{
+			bestEdge = i;
+			bestSeparation = separation;
+		}
+	}
+
+	*edgeIndex = bestEdge;
+	return bestSeparation;
+}
+
+// The normal points from A to B. Contact points lie on the incident surface.
+static void CollideRoundPolys(b2Manifold* manifold, const b2RoundPoly& polyA, const b2RoundPoly& polyB)
+{
+	manifold->pointCount = 0;
+	float32 totalRadius = polyA.radius + polyB.radius;
+
+	int32 edgeA = 0;
+	float32 separationA = FindMaxSeparation(&edgeA, polyA, polyB);
+	if (separationA > totalRadius)
+		return;
+
+	int32 edgeB = 0;
+	float32 separationB = FindMaxSeparation(&edgeB, polyB, polyA);
+	if (separationB > totalRadius)
+		return;
+
+	const b2RoundPoly* poly1;	// reference poly
+	const b2RoundPoly* poly2;	// incident poly
+	int32 edge1;		// reference edge
+	uint8 flip;
+	const float32 k_relativeTol = 0.98f;
+	const float32 k_absoluteTol = 0.001f;
+
+	if (separationB > k_relativeTol * separationA + k_absoluteTol)
+	{
+		poly1 = &polyB;
+		poly2 = &polyA;
+		edge1 = edgeB;
+		flip = 1;
+	}
+	else
+	{
+		poly1 = &polyA;
+		poly2 = &polyB;
+		edge1 = edgeA;
+		flip = 0;
+	}
+
+	// Find the incident edge on poly2.
+	b2Vec2 normal1 = poly1->normals[edge1];
+	int32 vertex21 = 0;
+	float32 minDot = FLT_MAX;
+	for (int32 i = 0; i < poly2->count; ++i)
+	{
+		float32 dot = b2Dot(normal1, poly2->normals[i]);
+		if (dot < minDot)
+		{
+			minDot = dot;
+			vertex21 = i;
+		}
+	}
+	int32 vertex22 = vertex21 + 1 < poly2->count ? vertex21 + 1 : 0;
+
+	ClipVertex incidentEdge[2];
+	incidentEdge[0].v = poly2->vertices[vertex21];
+	incidentEdge[0].id.features.referenceFace = (uint8)edge1;
+	incidentEdge[0].id.features.incidentEdge = (uint8)vertex21;
+	incidentEdge[0].id.features.incidentVertex = (uint8)vertex21;
+	incidentEdge[1].v = poly2->vertices[vertex22];
+	incidentEdge[1].id.features.referenceFace = (uint8)edge1;
+	incidentEdge[1].id.features.incidentEdge = (uint8)vertex21;
+	incidentEdge[1].id.features.incidentVertex = (uint8)vertex22;
+
+	b2Vec2 v11 = poly1->vertices[edge1];
+	b2Vec2 v12 = edge1 + 1 < poly1->count ? poly1->vertices[edge1+1] : poly1->vertices[0];
+
+	b2Vec2 sideNormal = v12 - v11;
+	sideNormal.Normalize();
+	b2Vec2 frontNormal = b2Cross(sideNormal, 1.0f);
+
+	// The side planes are pushed out by the radii so the rounded ends of a
+	// segment still get contact points.
+	float32 frontOffset = b2Dot(frontNormal, v11);
+	float32 sideOffset1 = -b2Dot(sideNormal, v11) + totalRadius;
+	float32 sideOffset2 = b2Dot(sideNormal, v12) + totalRadius;
+
+	ClipVertex clipPoints1[2];
+	ClipVertex clipPoints2[2];
+	int32 np;
+
+	np = ClipSegmentToLine(clipPoints1, incidentEdge, -sideNormal, sideOffset1);
+
+	if (np < 2)
+		return;
+
+	np = ClipSegmentToLine(clipPoints2, clipPoints1, sideNormal, sideOffset2);
+
+	if (np < 2)
+		return;
+
+	manifold->normal = flip ? -frontNormal : frontNormal;
+
+	int32 pointCount = 0;
+	for (int32 i = 0; i < b2_maxManifoldPoints; ++i)
+	{
+		float32 separation = b2Dot(frontNormal, clipPoints2[i].v) - frontOffset - totalRadius;
+
+		if (separation <= 0.0f)
+		{
+			b2ContactPoint* cp = manifold->points + pointCount;
+			cp->separation = separation;
+			cp->position = clipPoints2[i].v - poly2->radius * frontNormal;
+			cp->id = clipPoints2[i].id;
+			cp->id.features.flip = flip;
+			++pointCount;
+		}
+	}
+
+	manifold->pointCount = pointCount;
+}
+
+void b2CollideChainAndCircle(b2Manifold* manifold, const b2ChainShape* chain, int32 segment, const b2CircleShape* circle)
+{
+	manifold->pointCount = 0;
+
+	b2Vec2 v1 = chain->GetVertex(segment);
+	b2Vec2 v2 = chain->GetVertex(segment + 1);
+	b2Vec2 e = v2 - v1;
+	b2Vec2 c = circle->m_position;
+
+	// Project the circle center onto the segment.
+	b2ContactID id;
+	id.features.referenceFace = b2_nullFeature;
+	id.features.incidentEdge = b2_nullFeature;
+	id.features.incidentVertex = b2_nullFeature;
+	id.features.flip = 0;
+	float32 u = b2Dot(c - v1, e) / b2Dot(e, e);
+	b2Vec2 p;
+	if (u <= 0.0f)
+	{
+		p = v1;
+		id.features.incidentVertex = 0;
+	}
+	else if (u >= 1.0f)
+	{
+		p = v2;
+		id.features.incidentVertex = 1;
+	}
+	else
+	{
+		p = v1 + u * e;
+		id.features.incidentEdge = 0;
+	}
+
+	b2Vec2 d = c - p;
+	float32 dist = d.Normalize();
+	float32 radius = chain->m_radius + circle->m_radius;
+	if (dist > radius)
+	{
+		return;
+	}
+
+	// The center is on the segment, push it out along the segment normal.
+	if (dist < FLT_EPSILON)
+	{
+		d = b2Cross(e, 1.0f);
+		d.Normalize();
+	}
+
+	manifold->pointCount = 1;
+	manifold->normal = d;
+	manifold->points[0].id = id;
+	manifold->points[0].position = c - circle->m_radius * d;
+	manifold->points[0].separation = dist - radius;
+}
+
+void b2CollideChainAndPoly(b2Manifold* manifold, const b2ChainShape* chain, int32 segment, const b2PolyShape* poly)
+{
+	b2RoundPoly polyA, polyB;
+	SetSegment(&polyA, chain, segment);
+	SetPoly(&polyB, poly);
+	CollideRoundPolys(manifold, polyA, polyB);
+}
+
+void b2CollideChains(b2Manifold* manifold, const b2ChainShape* chain1, int32 segment1,
+					 const b2ChainShape* chain2, int32 segment2)
+{
+	b2RoundPoly polyA, polyB;
+	SetSegment(&polyA, chain1, segment1);
+	SetSegment(&polyB, chain2, segment2);
+	CollideRoundPolys(manifold, polyA, polyB);
+}
@@ -25,6 +25,7 @@
 class b2Shape;
 class b2CircleShape;
 class b2PolyShape;
+class b2ChainShape;
 
 // We use contact ids to facilitate warm starting.
 const uint8 b2_nullFeature = UCHAR_MAX;
@@ -76,6 +77,13 @@ void b2CollideCircle(b2Manifold* manifold, b2CircleShape* circle1, b2CircleShape
 void b2CollidePolyAndCircle(b2Manifold* manifold, const b2PolyShape* poly, const b2CircleShape* circle, bool conservative);
 void b2CollidePoly(b2Manifold* manifold, const b2PolyShape* poly1, const b2PolyShape* poly2, bool conservative);
 
+// Collide one segment of a chain. The normal points from the chain to the
+// other shape.
+void b2CollideChainAndCircle(b2Manifold* manifold, const b2ChainShape* chain, int32 segment, const b2CircleShape* circle);
+void b2CollideChainAndPoly(b2Manifold* manifold, const b2ChainShape* chain, int32 segment, const b2PolyShape* poly);
+void b2CollideChains(b2Manifold* manifold, const b2ChainShape* chain1, int32 segment1,
+					 const b2ChainShape* chain2, int32 segment2);
+
 float32 b2Distance(b2Vec2* x1, b2Vec2* x2, const b2Shape* shape1, const b2Shape* shape2);
 
 inline bool b2AABB::IsValid() const
@@ -0,0 +1,469 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2DynamicTree.h"
+#include <cstring>
+
+static inline b2AABB b2Combine(const b2AABB& a, const b2AABB& b)
+{
+	b2AABB c;
+	c.minVertex = b2Min(a.minVertex, b.minVertex);
+	c.maxVertex = b2Max(a.maxVertex, b.maxVertex);
+	return c;
+}
+
+static inline float32 b2Perimeter(const b2AABB& a)
+{
+	return 2.0f * (a.maxVertex.x - a.minVertex.x + a.maxVertex.y - a.minVertex.y);
+}
+
+static inline bool b2Contains(const b2AABB& outer, const b2AABB& inner)
+{
+	return outer.minVertex.x <= inner.minVertex.x && outer.minVertex.y <= inner.minVertex.y &&
+		inner.maxVertex.x <= outer.maxVertex.x && inner.maxVertex.y <= outer.maxVertex.y;
+}
+
+b2DynamicTree::b2DynamicTree()
+{
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+	m_nodeCapacity = 0;
+	m_nodes = NULL;
+	m_freeList = b2_nullNode;
+}
+
+b2DynamicTree::~b2DynamicTree()
+{
+	b2Free(m_nodes);
+}
+
+int32 b2DynamicTree::AllocateNode()
+{
+	if (m_freeList == b2_nullNode)
+	{
+		b2Assert(m_nodeCount == m_nodeCapacity);
+
+		// Grow the pool and thread the new nodes onto the free list.
+		int32 capacity = b2Max(16, 2 * m_nodeCapacity);
+		b2TreeNode* nodes = (b2TreeNode*)b2Alloc(capacity * sizeof(b2TreeNode));
+		if (m_nodes)
+		{
+			memcpy(nodes, m_nodes, m_nodeCount * sizeof(b2TreeNode));
+			b2Free(m_nodes);
+		}
+		m_nodes = nodes;
+
+		for (int32 i = m_nodeCount; i < capacity - 1; ++i)
+		{
+			m_nodes[i].next = i + 1;
+			m_nodes[i].height = -1;
+		}
+		m_nodes[capacity - 1].next = b2_nullNode;
+		m_nodes[capacity - 1].height = -1;
+
+		m_freeList = m_nodeCount;
+		m_nodeCapacity = capacity;
+	}
+
+	int32 index = m_freeList;
+	b2TreeNode* node = m_nodes + index;
+	m_freeList = node->next;
+
+	node->parent = b2_nullNode;
+	node->child1 = b2_nullNode;
+	node->child2 = b2_nullNode;
+	node->height = 0;
+	node->userData = NULL;
+	node->moved = false;
+	++m_nodeCount;
+	return index;
+}
+
+void b2DynamicTree::FreeNode(int32 index)
+{
+	b2Assert(0 <= index && index < m_nodeCapacity);
+	b2Assert(0 < m_nodeCount);
+	m_nodes[index].next = m_freeList;
+	m_nodes[index].height = -1;
+	m_freeList = index;
+	--m_nodeCount;
+}
+
+void b2DynamicTree::Reset()
+{
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		m_nodes[i].next = i + 1 < m_nodeCapacity ? i + 1 : b2_nullNode;
+		m_nodes[i].height = -1;
+	}
+	m_freeList = m_nodeCapacity > 0 ? 0 : b2_nullNode;
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+}
+
+int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = AllocateNode();
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b2TreeNode* node = m_nodes + proxyId;
+	node->aabb.minVertex = aabb.minVertex - r;
+	node->aabb.maxVertex = aabb.maxVertex + r;
+	node->userData = userData;
+	node->moved = true;
+
+	InsertLeaf(proxyId);
+	return proxyId;
+}
+
+void b2DynamicTree::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	b2Assert(m_nodes[proxyId].IsLeaf());
+
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+}
+
+bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	b2Assert(m_nodes[proxyId].IsLeaf());
+
+	b2TreeNode* node = m_nodes + proxyId;
+	if (b2Contains(node->aabb, aabb))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxyId);
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	node = m_nodes + proxyId;
+	node->aabb.minVertex = aabb.minVertex - r;
+	node->aabb.maxVertex = aabb.maxVertex + r;
+	node->moved = true;
+
+	InsertLeaf(proxyId);
+	return true;
+}
+
+void b2DynamicTree::InsertLeaf(int32 leaf)
+{
+	if (m_root == b2_nullNode)
+	{
+		m_root = leaf;
+		m_nodes[m_root].parent = b2_nullNode;
+		return;
+	}
+
+	// Walk down to the cheapest sibling. The cost of a node is the perimeter
+	// it would grow to, plus what its ancestors already grew by.
+	b2AABB leafAABB = m_nodes[leaf].aabb;
+	int32 index = m_root;
+	while (m_nodes[index].IsLeaf() == false)
+	{
+		const b2TreeNode* node = m_nodes + index;
+		int32 child1 = node->child1;
+		int32 child2 = node->child2;
+
+		float32 area = b2Perimeter(node->aabb);
+		float32 combinedArea = b2Perimeter(b2Combine(node->aabb, leafAABB));
+
+		// Cost of making a new parent for this node and the new leaf.
+		float32 cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree.
+		float32 inheritanceCost = 2.0f * (combinedArea - area);
+
+		float32 cost1 = b2Perimeter(b2Combine(leafAABB, m_nodes[child1].aabb)) + inheritanceCost;
+		if (m_nodes[child1].IsLeaf() == false)
+		{
+			cost1 -= b2Perimeter(m_nodes[child1].aabb);
+		}
+
+		float32 cost2 = b2Perimeter(b2Combine(leafAABB, m_nodes[child2].aabb)) + inheritanceCost;
+		if (m_nodes[child2].IsLeaf() == false)
+		{
+			cost2 -= b2Perimeter(m_nodes[child2].aabb);
+		}
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int32 sibling = index;
+
+	// Create a new parent in place of the sibling.
+	int32 oldParent = m_nodes[sibling].parent;
+	int32 newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].aabb = b2Combine(leafAABB, m_nodes[sibling].aabb);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != b2_nullNode)
+	{
+		if (m_nodes[oldParent].child1 == sibling)
+		{
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	// Refit and rebalance the ancestors.
+	index = m_nodes[leaf].parent;
+	while (index != b2_nullNode)
+	{
+		index = Balance(index);
+
+		int32 child1 = m_nodes[index].child1;
+		int32 child2 = m_nodes[index].child2;
+		m_nodes[index].height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+		m_nodes[index].aabb = b2Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+void b2DynamicTree::RemoveLeaf(int32 leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = b2_nullNode;
+		return;
+	}
+
+	int32 parent = m_nodes[leaf].parent;
+	int32 grandParent = m_nodes[parent].parent;
+	int32 sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	// Replace the parent by the sibling.
+	FreeNode(parent);
+	if (grandParent == b2_nullNode)
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = b2_nullNode;
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent)
+	{
+		m_nodes[grandParent].child1 = sibling;
+	}
+	else
+	{
+		m_nodes[grandParent].child2 = sibling;
+	}
+	m_nodes[sibling].parent = grandParent;
+
+	int32 index = grandParent;
+	while (index != b2_nullNode)
+	{
+		index = Balance(index);
+
+		int32 child1 = m_nodes[index].child1;
+		int32 child2 = m_nodes[index].child2;
+		m_nodes[index].aabb = b2Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+		m_nodes[index].height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+// If the subtree at iA is out of balance, rotate its taller child up.
+// Returns the index of the subtree's new root.
+int32 b2DynamicTree::Balance(int32 iA)
+{
+	b2Assert(iA != b2_nullNode);
+
+	b2TreeNode* A = m_nodes + iA;
+	if (A->IsLeaf() || A->height < 2)
+	{
+		return iA;
+	}
+
+	int32 iB = A->child1;
+	int32 iC = A->child2;
+	b2TreeNode* B = m_nodes + iB;
+	b2TreeNode* C = m_nodes + iC;
+
+	int32 balance = C->height - B->height;
+
+	// Rotate C up.
+	if (balance > 1)
+	{
+		int32 iF = C->child1;
+		int32 iG = C->child2;
+		b2TreeNode* F = m_nodes + iF;
+		b2TreeNode* G = m_nodes + iG;
+
+		// Swap A and C.
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		if (C->parent != b2_nullNode)
+		{
+			if (m_nodes[C->parent].child1 == iA)
+			{
+				m_nodes[C->parent].child1 = iC;
+			}
+			else
+			{
+				m_nodes[C->parent].child2 = iC;
+			}
+		}
+		else
+		{
+			m_root = iC;
+		}
+
+		// Keep the taller of F and G under C.
+		if (F->height > G->height)
+		{
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->aabb = b2Combine(B->aabb, G->aabb);
+			C->aabb = b2Combine(A->aabb, F->aabb);
+			A->height = 1 + b2Max(B->height, G->height);
+			C->height = 1 + b2Max(A->height, F->height);
+		}
+		else
+		{
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->aabb = b2Combine(B->aabb, F->aabb);
+			C->aabb = b2Combine(A->aabb, G->aabb);
+			A->height = 1 + b2Max(B->height, F->height);
+			C->height = 1 + b2Max(A->height, G->height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up.
+	if (balance < -1)
+	{
+		int32 iD = B->child1;
+		int32 iE = B->child2;
+		b2TreeNode* D = m_nodes + iD;
+		b2TreeNode* E = m_nodes + iE;
+
+		// Swap A and B.
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		if (B->parent != b2_nullNode)
+		{
+			if (m_nodes[B->parent].child1 == iA)
+			{
+				m_nodes[B->parent].child1 = iB;
+			}
+			else
+			{
+				m_nodes[B->parent].child2 = iB;
+			}
+		}
+		else
+		{
+			m_root = iB;
+		}
+
+		// Keep the taller of D and E under B.
+		if (D->height > E->height)
+		{
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->aabb = b2Combine(C->aabb, E->aabb);
+			B->aabb = b2Combine(A->aabb, D->aabb);
+			A->height = 1 + b2Max(C->height, E->height);
+			B->height = 1 + b2Max(A->height, D->height);
+		}
+		else
+		{
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->aabb = b2Combine(C->aabb, D->aabb);
+			B->aabb = b2Combine(A->aabb, E->aabb);
+			A->height = 1 + b2Max(C->height, D->height);
+			B->height = 1 + b2Max(A->height, E->height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void b2DynamicTree::Validate() const
+{
+	if (m_root != b2_nullNode)
+	{
+		b2Assert(m_nodes[m_root].parent == b2_nullNode);
+		ValidateNode(m_root);
+	}
+
+	int32 freeCount = 0;
+	for (int32 index = m_freeList; index != b2_nullNode; index = m_nodes[index].next)
+	{
+		b2Assert(0 <= index && index < m_nodeCapacity);
+		++freeCount;
+	}
+	b2Assert(m_nodeCount + freeCount == m_nodeCapacity);
+}
+
+void b2DynamicTree::ValidateNode(int32 index) const
+{
+	const b2TreeNode* node = m_nodes + index;
+	if (node->IsLeaf())
+	{
+		b2Assert(node->height == 0);
+		return;
+	}
+
+	int32 child1 = node->child1;
+	int32 child2 = node->child2;
+	b2Assert(m_nodes[child1].parent == index);
+	b2Assert(m_nodes[child2].parent == index);
+	b2Assert(node->height == 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height));
+	b2Assert(b2Contains(node->aabb, m_nodes[child1].aabb));
+	b2Assert(b2Contains(node->aabb, m_nodes[child2].aabb));
+
+	ValidateNode(child1);
+	ValidateNode(child2);
+}
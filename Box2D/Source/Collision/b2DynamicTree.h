@@ -0,0 +1,156 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_DYNAMIC_TREE_H
+#define B2_DYNAMIC_TREE_H
+
+#include "b2Collision.h"
+
+const int32 b2_nullNode = -1;
+
+// Leaves are fattened by this much so that small movements do not
+// reinsert them.
+const float32 b2_aabbExtension = 0.1f * b2_lengthUnitsPerMeter;
+
+struct b2TreeNode
+{
+	bool IsLeaf() const { return child1 == b2_nullNode; }
+
+	b2AABB aabb;
+	void* userData;
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	int32 child1;
+	int32 child2;
+
+	// Leaf = 0, free node = -1.
+	int32 height;
+
+	// Set when a leaf was created or reinserted since the last commit.
+	bool moved;
+};
+
+// A dynamic AABB tree. Leaves are proxies holding a fattened AABB and user
+// data, internal nodes hold the union of their children. The tree is kept
+// balanced with rotations and the node pool grows as needed, so there is no
+// cap on the proxy count. Proxy ids are node indices and stay valid until
+// the proxy is destroyed.
+class b2DynamicTree
+{
+public:
+	b2DynamicTree();
+	~b2DynamicTree();
+
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	void DestroyProxy(int32 proxyId);
+
+	// Returns true if the proxy was reinserted because aabb left its fat AABB.
+	bool MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	void* GetUserData(int32 proxyId) const;
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+
+	// Call callback->QueryCallback(proxyId) for every proxy whose fat AABB
+	// overlaps aabb. The query stops when the callback returns false.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	int32 GetHeight() const;
+	void Validate() const;
+
+	// Free every node, keeping the pool.
+	void Reset();
+
+	b2TreeNode* m_nodes;
+	int32 m_root;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+	int32 m_freeList;
+
+private:
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	void InsertLeaf(int32 leaf);
+	void RemoveLeaf(int32 leaf);
+	int32 Balance(int32 index);
+
+	void ValidateNode(int32 index) const;
+};
+
+inline void* b2DynamicTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].userData;
+}
+
+inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].aabb;
+}
+
+inline int32 b2DynamicTree::GetHeight() const
+{
+	return m_root == b2_nullNode ? 0 : m_nodes[m_root].height;
+}
+
+template <typename T>
+inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
+{
+	// The tree is balanced, so a small fixed stack covers any practical size.
+	const int32 k_stackSize = 128;
+	int32 stack[k_stackSize];
+	int32 count = 0;
+
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	stack[count++] = m_root;
+	while (count > 0)
+	{
+		const b2TreeNode* node = m_nodes + stack[--count];
+		if (b2TestOverlap(node->aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			if (callback->QueryCallback((int32)(node - m_nodes)) == false)
+			{
+				return;
+			}
+		}
+		else
+		{
+			b2Assert(count + 2 <= k_stackSize);
+			stack[count++] = node->child1;
+			stack[count++] = node->child2;
+		}
+	}
+}
+
+#endif
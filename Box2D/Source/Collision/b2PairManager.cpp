@@ -20,12 +20,13 @@
 #include "b2BroadPhase.h"
 
 #include <algorithm>
+#include <string.h>
 
 // Thomas Wang's hash, see: http://www.concentric.net/~Ttwang/tech/inthash.htm
-// This assumes proxyId1 and proxyId2 are 16-bit.
+// Ids above 16 bits fold into the key instead of being cut off.
 inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
 {
-	uint32 key = (proxyId2 << 16) | proxyId1;
+	uint32 key = (proxyId2 << 16) ^ proxyId1;
 	key = ~key + (key << 15);
 	key = key ^ (key >> 12);
 	key = key + (key << 2);
@@ -64,23 +65,149 @@ inline bool operator < (const b2BufferedPair& pair1, const b2BufferedPair& pair2
 
 b2PairManager::b2PairManager()
 {
-	b2Assert(b2IsPowerOfTwo(b2_tableCapacity) == true);
-	b2Assert(b2_tableCapacity >= b2_maxPairs);
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	b2Assert(b2IsPowerOfTwo(b2_initialPairCapacity) == true);
+
+	m_tableCapacity = b2_initialPairCapacity;
+	m_tableMask = m_tableCapacity - 1;
+	m_hashTable = (int32*)b2Alloc(m_tableCapacity * sizeof(int32));
+	for (int32 i = 0; i < m_tableCapacity; ++i)
 	{
 		m_hashTable[i] = b2_nullPair;
 	}
-	m_freePair = 0;
-	for (int32 i = 0; i < b2_maxPairs; ++i)
+
+	m_pairCapacity = 0;
+	m_pairs = NULL;
+	m_pairBuffer = NULL;
+	m_freePair = b2_nullPair;
+	m_pairCount = 0;
+	m_pairBufferCount = 0;
+	GrowPairs();
+	m_growCount = 0;
+}
+
+b2PairManager::~b2PairManager()
+{
+	b2Free(m_hashTable);
+	b2Free(m_pairs);
+	b2Free(m_pairBuffer);
+}
+
+// Double the pair pool and the pair buffer. The new pairs go on the free list.
+void b2PairManager::GrowPairs()
+{
+	int32 oldCapacity = m_pairCapacity;
+	m_pairCapacity = oldCapacity == 0 ? b2_initialPairCapacity : 2 * oldCapacity;
+
+	b2Pair* oldPairs = m_pairs;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	if (oldPairs != NULL)
+	{
+		memcpy(m_pairs, oldPairs, oldCapacity * sizeof(b2Pair));
+		b2Free(oldPairs);
+	}
+
+	b2BufferedPair* oldBuffer = m_pairBuffer;
+	m_pairBuffer = (b2BufferedPair*)b2Alloc(m_pairCapacity * sizeof(b2BufferedPair));
+	if (oldBuffer != NULL)
+	{
+		memcpy(m_pairBuffer, oldBuffer, m_pairBufferCount * sizeof(b2BufferedPair));
+		b2Free(oldBuffer);
+	}
+
+	for (int32 i = oldCapacity; i < m_pairCapacity; ++i)
 	{
 		m_pairs[i].proxyId1 = b2_nullProxy;
 		m_pairs[i].proxyId2 = b2_nullProxy;
 		m_pairs[i].userData = NULL;
 		m_pairs[i].status = 0;
-		m_pairs[i].next = uint16(i + 1);
+		m_pairs[i].next = i + 1;
+	}
+	m_pairs[m_pairCapacity-1].next = m_freePair;
+	m_freePair = oldCapacity;
+
+	if (oldCapacity > 0)
+	{
+		++m_growCount;
+	}
+}
+
+// Double the hash table and rechain every live pair.
+void b2PairManager::GrowTable()
+{
+	b2Free(m_hashTable);
+	m_tableCapacity *= 2;
+	m_tableMask = m_tableCapacity - 1;
+	m_hashTable = (int32*)b2Alloc(m_tableCapacity * sizeof(int32));
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_hashTable[i] = b2_nullPair;
+	}
+
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		b2Pair* pair = m_pairs + i;
+		if (pair->proxyId1 == b2_nullProxy)
+		{
+			continue;
+		}
+
+		int32 hash = Hash(pair->proxyId1, pair->proxyId2) & m_tableMask;
+		pair->next = m_hashTable[hash];
+		m_hashTable[hash] = i;
 	}
-	m_pairs[b2_maxPairs-1].next = b2_nullPair;
+
+	++m_growCount;
+}
+
+void b2PairManager::Reset()
+{
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_hashTable[i] = b2_nullPair;
+	}
+
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+		m_pairs[i].proxyId2 = b2_nullProxy;
+		m_pairs[i].userData = NULL;
+		m_pairs[i].status = 0;
+		m_pairs[i].next = i + 1 < m_pairCapacity ? i + 1 : b2_nullPair;
+	}
+	m_freePair = 0;
 	m_pairCount = 0;
+	m_pairBufferCount = 0;
+}
+
+void b2PairManager::GetStats(b2PairStats* stats) const
+{
+	stats->pairCount = m_pairCount;
+	stats->pairCapacity = m_pairCapacity;
+	stats->tableCapacity = m_tableCapacity;
+	stats->usedBuckets = 0;
+	stats->maxProbes = 0;
+	stats->growCount = m_growCount;
+	stats->byteCount = m_pairCapacity * (sizeof(b2Pair) + sizeof(b2BufferedPair)) + m_tableCapacity * sizeof(int32);
+
+	// Finding the k-th pair of a chain takes k probes.
+	int32 probes = 0;
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		int32 length = 0;
+		for (int32 index = m_hashTable[i]; index != b2_nullPair; index = m_pairs[index].next)
+		{
+			++length;
+			probes += length;
+		}
+
+		if (length > 0)
+		{
+			++stats->usedBuckets;
+		}
+		stats->maxProbes = b2Max(stats->maxProbes, length);
+	}
+
+	stats->meanProbes = m_pairCount > 0 ? float32(probes) / m_pairCount : 0.0f;
 }
 
 void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback)
@@ -103,7 +230,7 @@ b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2, uint32 hash)
 		return NULL;
 	}
 
-	b2Assert(index < b2_maxPairs);
+	b2Assert(index < m_pairCapacity);
 
 	return m_pairs + index;
 }
@@ -112,7 +239,7 @@ b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
 	return Find(proxyId1, proxyId2, hash);
 }
@@ -122,7 +249,7 @@ b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
 	b2Pair* pair = Find(proxyId1, proxyId2, hash);
 	if (pair != NULL)
@@ -130,14 +257,23 @@ b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
 		return pair;
 	}
 
-	b2Assert(m_pairCount < b2_maxPairs && m_freePair != b2_nullPair);
+	if (m_freePair == b2_nullPair)
+	{
+		GrowPairs();
+	}
+
+	if (m_pairCount == m_tableCapacity)
+	{
+		GrowTable();
+		hash = Hash(proxyId1, proxyId2) & m_tableMask;
+	}
 
-	uint16 pairIndex = m_freePair;
+	int32 pairIndex = m_freePair;
 	pair = m_pairs + pairIndex;
 	m_freePair = pair->next;
 
-	pair->proxyId1 = (uint16)proxyId1;
-	pair->proxyId2 = (uint16)proxyId2;
+	pair->proxyId1 = proxyId1;
+	pair->proxyId2 = proxyId2;
 	pair->status = 0;
 	pair->userData = NULL;
 	pair->next = m_hashTable[hash];
@@ -156,14 +292,14 @@ void* b2PairManager::RemovePair(int32 proxyId1, int32 proxyId2)
 
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 hash = Hash(proxyId1, proxyId2) & m_tableMask;
 
-	uint16* node = &m_hashTable[hash];
+	int32* node = &m_hashTable[hash];
 	while (*node != b2_nullPair)
 	{
 		if (Equals(m_pairs[*node], proxyId1, proxyId2))
 		{
-			uint16 index = *node;
+			int32 index = *node;
 			*node = m_pairs[*node].next;
 			
 			b2Pair* pair = m_pairs + index;
@@ -208,8 +344,7 @@ If the added pair is not a new pair, then it must be in the pair buffer (because
 */
 void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 {
-	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
+	b2Assert(0 <= id1 && 0 <= id2);
 
 	b2Pair* pair = AddPair(id1, id2);
 
@@ -240,8 +375,7 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 // Buffer a pair for removal.
 void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 {
-	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
+	b2Assert(0 <= id1 && 0 <= id2);
 
 	b2Pair* pair = Find(id1, id2);
 
@@ -366,9 +500,9 @@ void b2PairManager::ValidateBuffer()
 void b2PairManager::ValidateTable()
 {
 #ifdef _DEBUG
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	for (int32 i = 0; i < m_tableCapacity; ++i)
 	{
-		uint16 index = m_hashTable[i];
+		int32 index = m_hashTable[i];
 		while (index != b2_nullPair)
 		{
 			b2Pair* pair = m_pairs + index;
@@ -31,10 +31,7 @@
 class b2BroadPhase;
 struct b2Proxy;
 
-const uint16 b2_nullPair = USHRT_MAX;
-const uint16 b2_nullProxy = USHRT_MAX;
-const int32 b2_tableCapacity = b2_maxPairs;	// must be a power of two
-const int32 b2_tableMask = b2_tableCapacity - 1;
+const int32 b2_nullPair = -1;
 
 struct b2Pair
 {
@@ -57,16 +54,30 @@ struct b2Pair
 	bool IsFinal()		{ return (status & e_pairFinal) == e_pairFinal; }
 
 	void* userData;
-	uint16 proxyId1;
-	uint16 proxyId2;
-	uint16 next;
-	uint16 status;
+	int32 proxyId1;
+	int32 proxyId2;
+	int32 next;
+	uint32 status;
 };
 
 struct b2BufferedPair
 {
-	uint16 proxyId1;
-	uint16 proxyId2;
+	int32 proxyId1;
+	int32 proxyId2;
+};
+
+// Occupancy of the pair pool and hash table. A probe is one pair visited
+// while walking a hash chain.
+struct b2PairStats
+{
+	int32 pairCount;
+	int32 pairCapacity;
+	int32 tableCapacity;
+	int32 usedBuckets;
+	int32 maxProbes;		// longest hash chain
+	float32 meanProbes;		// average probes to find a stored pair
+	int32 growCount;		// times the pool or the table was enlarged
+	int32 byteCount;
 };
 
 class b2PairCallback
@@ -87,6 +98,7 @@ class b2PairManager
 {
 public:
 	b2PairManager();
+	~b2PairManager();
 
 	void Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback);
 
@@ -95,6 +107,11 @@ public:
 
 	void Commit();
 
+	void GetStats(b2PairStats* stats) const;
+
+	// Put every pair back on the free list without calling the callback.
+	void Reset();
+
 private:
 	b2Pair* Find(int32 proxyId1, int32 proxyId2);
 	b2Pair* Find(int32 proxyId1, int32 proxyId2, uint32 hashValue);
@@ -102,20 +119,32 @@ private:
 	b2Pair* AddPair(int32 proxyId1, int32 proxyId2);
 	void* RemovePair(int32 proxyId1, int32 proxyId2);
 
+	void GrowPairs();
+	void GrowTable();
+
 	void ValidateBuffer();
 	void ValidateTable();
 
 public:
 	b2BroadPhase *m_broadPhase;
 	b2PairCallback *m_callback;
-	b2Pair m_pairs[b2_maxPairs];
-	uint16 m_freePair;
+
+	// The pair pool and the pair buffer share a capacity since a pair is
+	// buffered at most once. Both double when the pool is full.
+	b2Pair* m_pairs;
+	int32 m_pairCapacity;
+	int32 m_freePair;
 	int32 m_pairCount;
 
-	b2BufferedPair m_pairBuffer[b2_maxPairs];
+	b2BufferedPair* m_pairBuffer;
 	int32 m_pairBufferCount;
 
-	uint16 m_hashTable[b2_tableCapacity];
+	// Chained hash table, kept at least as large as the pair count.
+	int32* m_hashTable;
+	int32 m_tableCapacity;
+	int32 m_tableMask;
+
+	int32 m_growCount;
 };
 
 #endif
@@ -155,6 +155,39 @@ static b2Vec2 PolyCentroid(const b2Vec2* vs, int32 count)
 	return c;
 }
 
+// Each segment weighs like a box of the segment length and 2 * radius,
+// centered on the segment.
+static void ChainMass(b2MassData* massData, const b2Vec2* vs, int32 count, float32 radius, float32 rho)
+{
+	b2Assert(count >= 2);
+
+	float32 mass = 0.0f;
+	b2Vec2 center; center.Set(0.0f, 0.0f);
+	float32 I = 0.0f;
+	float32 thickness = 2.0f * radius;
+
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = 0.5f * (vs[i-1] + vs[i]);
+		float32 length = (vs[i] - vs[i-1]).Length();
+		float32 m = rho * length * thickness;
+
+		mass += m;
+		center += m * c;
+		I += m * ((length * length + thickness * thickness) / 12.0f + b2Dot(c, c));
+	}
+
+	massData->mass = mass;
+	if (mass > 0.0f)
+	{
+		center *= 1.0f / mass;
+	}
+	massData->center = center;
+
+	// Inertia tensor relative to the center.
+	massData->I = I - mass * b2Dot(center, center);
+}
+
 void b2ShapeDef::ComputeMass(b2MassData* massData) const
 {
 	if (density == 0.0f)
@@ -191,6 +224,14 @@ void b2ShapeDef::ComputeMass(b2MassData* massData) const
 		}
 		break;
 
+	case e_chainShape:
+		{
+			b2ChainDef* chain = (b2ChainDef*)this;
+			ChainMass(massData, chain->vertices, chain->vertexCount, chain->radius, density);
+			massData->center = b2Mul(b2Mat22(localRotation), massData->center);
+		}
+		break;
+
 	default:
 		massData->mass = 0.0f;
 		massData->center.Set(0.0f, 0.0f);
@@ -216,6 +257,12 @@ b2Shape* b2Shape::Create(const b2ShapeDef* def,
 			void* mem = body->m_world->m_blockAllocator.Allocate(sizeof(b2PolyShape));
 			return new (mem) b2PolyShape(def, body, center);
 		}
+
+	case e_chainShape:
+		{
+			void* mem = body->m_world->m_blockAllocator.Allocate(sizeof(b2ChainShape));
+			return new (mem) b2ChainShape(def, body, center);
+		}
 	}
 
 	b2Assert(false);
@@ -237,6 +284,10 @@ void b2Shape::Destroy(b2Shape*& shape)
 		allocator.Free(shape, sizeof(b2PolyShape));
 		break;
 
+	case e_chainShape:
+		allocator.Free(shape, sizeof(b2ChainShape));
+		break;
+
 	default:
 		b2Assert(false);
 	}
@@ -296,7 +347,7 @@ b2CircleShape::b2CircleShape(const b2ShapeDef* def, b2Body* body, const b2Vec2&
 	aabb.minVertex.Set(m_position.x - m_radius, m_position.y - m_radius);
 	aabb.maxVertex.Set(m_position.x + m_radius, m_position.y + m_radius);
 
-	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
 		m_proxyId = broadPhase->CreateProxy(aabb, this);
@@ -332,7 +383,7 @@ void b2CircleShape::Synchronize(const b2Vec2& position1, const b2Mat22& R1,
 	aabb.minVertex.Set(lower.x - m_radius, lower.y - m_radius);
 	aabb.maxVertex.Set(upper.x + m_radius, upper.y + m_radius);
 
-	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
 		broadPhase->MoveProxy(m_proxyId, aabb);
@@ -363,17 +414,14 @@ bool b2CircleShape::TestPoint(const b2Vec2& p)
 	return b2Dot(d, d) <= m_radius * m_radius;
 }
 
-void b2CircleShape::ResetProxy(b2BroadPhase* broadPhase)
+void b2CircleShape::ResetProxy(b2BroadPhaseInterface* broadPhase)
 {
 	if (m_proxyId == b2_nullProxy)
 	{	
 		return;
 	}
 
-	b2Proxy* proxy = broadPhase->GetProxy(m_proxyId);
-
 	broadPhase->DestroyProxy(m_proxyId);
-	proxy = NULL;
 
 	b2AABB aabb;
 	aabb.minVertex.Set(m_position.x - m_radius, m_position.y - m_radius);
@@ -510,7 +558,7 @@ b2PolyShape::b2PolyShape(const b2ShapeDef* def, b2Body* body,
 	aabb.minVertex = position - h;
 	aabb.maxVertex = position + h;
 
-	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
 		m_proxyId = broadPhase->CreateProxy(aabb, this);
@@ -562,7 +610,7 @@ void b2PolyShape::Synchronize(	const b2Vec2& position1, const b2Mat22& R1,
 	aabb.minVertex = b2Min(aabb1.minVertex, aabb2.minVertex);
 	aabb.maxVertex = b2Max(aabb1.maxVertex, aabb2.maxVertex);
 
-	b2BroadPhase* broadPhase = m_body->m_world->m_broadPhase;
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
 	if (broadPhase->InRange(aabb))
 	{
 		broadPhase->MoveProxy(m_proxyId, aabb);
@@ -614,17 +662,14 @@ bool b2PolyShape::TestPoint(const b2Vec2& p)
 	return true;
 }
 
-void b2PolyShape::ResetProxy(b2BroadPhase* broadPhase)
+void b2PolyShape::ResetProxy(b2BroadPhaseInterface* broadPhase)
 {
 	if (m_proxyId == b2_nullProxy)
 	{	
 		return;
 	}
 
-	b2Proxy* proxy = broadPhase->GetProxy(m_proxyId);
-
 	broadPhase->DestroyProxy(m_proxyId);
-	proxy = NULL;
 
 	b2Mat22 R = b2Mul(m_R, m_localOBB.R);
 	b2Mat22 absR = b2Abs(R);
@@ -649,4 +694,275 @@ void b2PolyShape::ResetProxy(b2BroadPhase* broadPhase)
 	}
 }
 
+static void BuildChainNodes(b2ChainNode* nodes, int32 index, const b2Vec2* vs, int32 begin, int32 end, float32 radius)
+{
+	b2ChainNode* node = nodes + index;
+	if (end - begin == 1)
+	{
+		b2Vec2 r(radius, radius);
+		node->aabb.minVertex = b2Min(vs[begin], vs[end]) - r;
+		node->aabb.maxVertex = b2Max(vs[begin], vs[end]) + r;
+		return;
+	}
+
+	int32 mid = (begin + end) >> 1;
+	int32 child1 = index + 1;
+	int32 child2 = index + 2 * (mid - begin);
+	BuildChainNodes(nodes, child1, vs, begin, mid, radius);
+	BuildChainNodes(nodes, child2, vs, mid, end, radius);
+
+	node->aabb.minVertex = b2Min(nodes[child1].aabb.minVertex, nodes[child2].aabb.minVertex);
+	node->aabb.maxVertex = b2Max(nodes[child1].aabb.maxVertex, nodes[child2].aabb.maxVertex);
+}
+
+b2ChainShape::b2ChainShape(const b2ShapeDef* def, b2Body* body, const b2Vec2& newOrigin)
+: b2Shape(def, body)
+{
+	b2Assert(def->type == e_chainShape);
+	const b2ChainDef* chain = (const b2ChainDef*)def;
+	b2Assert(chain->vertexCount >= 2 && chain->radius > b2_toiSlop);
+
+	m_type = e_chainShape;
+	m_radius = chain->radius;
+	m_supportSegment = -1;
+
+	// Get the vertices transformed into the body frame, welding any that
+	// are closer than the linear slop.
+	b2Mat22 localR(def->localRotation);
+	m_vertices = (b2Vec2*)b2Alloc(chain->vertexCount * sizeof(b2Vec2));
+	m_vertexCount = 0;
+	for (int32 i = 0; i < chain->vertexCount; ++i)
+	{
+		b2Vec2 v = def->localPosition + b2Mul(localR, chain->vertices[i]) - newOrigin;
+		if (m_vertexCount > 0)
+		{
+			b2Vec2 d = v - m_vertices[m_vertexCount - 1];
+			if (b2Dot(d, d) < b2_linearSlop * b2_linearSlop)
+			{
+				continue;
+			}
+		}
+		m_vertices[m_vertexCount++] = v;
+	}
+
+	if (m_vertexCount == 1)
+	{
+		m_vertices[1] = m_vertices[0] + b2Vec2(b2_linearSlop, 0.0f);
+		m_vertexCount = 2;
+	}
+
+	int32 segmentCount = m_vertexCount - 1;
+	m_nodes = (b2ChainNode*)b2Alloc((2 * segmentCount - 1) * sizeof(b2ChainNode));
+	BuildChainNodes(m_nodes, 0, m_vertices, 0, segmentCount, m_radius);
+
+	m_minRadius = m_radius;
+	m_maxRadius = 0.0f;
+	for (int32 i = 0; i < m_vertexCount; ++i)
+	{
+		m_maxRadius = b2Max(m_maxRadius, m_vertices[i].Length());
+	}
+	m_maxRadius += m_radius;
+
+	m_R = m_body->m_R;
+	m_position = m_body->m_position;
+
+	b2AABB aabb;
+	ComputeAABB(&aabb, m_position, m_R);
+
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
+	if (broadPhase->InRange(aabb))
+	{
+		m_proxyId = broadPhase->CreateProxy(aabb, this);
+	}
+	else
+	{
+		m_proxyId = b2_nullProxy;
+	}
+
+	if (m_proxyId == b2_nullProxy)
+	{
+		m_body->Freeze();
+	}
+}
+
+b2ChainShape::~b2ChainShape()
+{
+	b2Free(m_vertices);
+	b2Free(m_nodes);
+}
+
+void b2ChainShape::ComputeAABB(b2AABB* aabb, const b2Vec2& position, const b2Mat22& R) const
+{
+	const b2AABB& box = m_nodes[0].aabb;
+	b2Vec2 center = position + b2Mul(R, 0.5f * (box.minVertex + box.maxVertex));
+	b2Vec2 h = b2Mul(b2Abs(R), 0.5f * (box.maxVertex - box.minVertex));
+	aabb->minVertex = center - h;
+	aabb->maxVertex = center + h;
+}
+
+void b2ChainShape::Synchronize(	const b2Vec2& position1, const b2Mat22& R1,
+								const b2Vec2& position2, const b2Mat22& R2)
+{
+	// The body transform is copied for convenience.
+	m_R = R2;
+	m_position = position2;
+
+	if (m_proxyId == b2_nullProxy)
+	{	
+		return;
+	}
+
+	b2AABB aabb1, aabb2;
+	ComputeAABB(&aabb1, position1, R1);
+	ComputeAABB(&aabb2, position2, R2);
+
+	b2AABB aabb;
+	aabb.minVertex = b2Min(aabb1.minVertex, aabb2.minVertex);
+	aabb.maxVertex = b2Max(aabb1.maxVertex, aabb2.maxVertex);
+
+	b2BroadPhaseInterface* broadPhase = m_body->m_world->m_broadPhase;
+	if (broadPhase->InRange(aabb))
+	{
+		broadPhase->MoveProxy(m_proxyId, aabb);
+	}
+	else
+	{
+		m_body->Freeze();
+	}
+}
+
+void b2ChainShape::QuickSync(const b2Vec2& position, const b2Mat22& R)
+{
+	m_R = R;
+	m_position = position;
+}
+
+b2Vec2 b2ChainShape::Support(const b2Vec2& d) const
+{
+	b2Vec2 dLocal = b2MulT(m_R, d);
+
+	int32 first = 0;
+	int32 last = m_vertexCount - 1;
+	if (m_supportSegment != -1)
+	{
+		first = m_supportSegment;
+		last = m_supportSegment + 1;
+	}
+
+	int32 bestIndex = first;
+	float32 bestValue = b2Dot(m_vertices[first], dLocal);
+	for (int32 i = first + 1; i <= last; ++i)
+	{
+		float32 value = b2Dot(m_vertices[i], dLocal);
+		if (value > bestValue)
+		{
+			bestIndex = i;
+			bestValue = value;
+		}
+	}
+
+	b2Vec2 u = d;
+	u.Normalize();
+	float32 r = b2Max(0.0f, m_radius - b2_toiSlop);
+	return m_position + b2Mul(m_R, m_vertices[bestIndex]) + r * u;
+}
+
+int32 b2ChainShape::Query(const b2AABB& aabb, int32* segments, int32 maxCount) const
+{
+	// Depth is log2 of the segment count, so this covers any chain.
+	const int32 k_stackSize = 64;
+	int32 stack[k_stackSize][3];
+	int32 stackCount = 0;
+	int32 count = 0;
+
+	stack[stackCount][0] = 0;
+	stack[stackCount][1] = 0;
+	stack[stackCount][2] = m_vertexCount - 1;
+	++stackCount;
+
+	while (stackCount > 0 && count < maxCount)
+	{
+		--stackCount;
+		int32 index = stack[stackCount][0];
+		int32 begin = stack[stackCount][1];
+		int32 end = stack[stackCount][2];
+
+		if (b2TestOverlap(m_nodes[index].aabb, aabb) == false)
+		{
+			continue;
+		}
+
+		if (end - begin == 1)
+		{
+			segments[count++] = begin;
+			continue;
+		}
+
+		// Push the second half first so segments come out in order.
+		int32 mid = (begin + end) >> 1;
+		b2Assert(stackCount + 2 <= k_stackSize);
+		stack[stackCount][0] = index + 2 * (mid - begin);
+		stack[stackCount][1] = mid;
+		stack[stackCount][2] = end;
+		++stackCount;
+		stack[stackCount][0] = index + 1;
+		stack[stackCount][1] = begin;
+		stack[stackCount][2] = mid;
+		++stackCount;
+	}
+
+	return count;
+}
+
+bool b2ChainShape::TestPoint(const b2Vec2& p)
+{
+	b2Vec2 pLocal = b2MulT(m_R, p - m_position);
 
+	b2AABB aabb;
+	aabb.minVertex = pLocal;
+	aabb.maxVertex = pLocal;
+
+	const int32 k_maxSegments = 32;
+	int32 segments[k_maxSegments];
+	int32 count = Query(aabb, segments, k_maxSegments);
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 v1 = m_vertices[segments[i]];
+		b2Vec2 e = m_vertices[segments[i] + 1] - v1;
+		float32 u = b2Clamp(b2Dot(pLocal - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+		b2Vec2 d = pLocal - (v1 + u * e);
+		if (b2Dot(d, d) <= m_radius * m_radius)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void b2ChainShape::ResetProxy(b2BroadPhaseInterface* broadPhase)
+{
+	if (m_proxyId == b2_nullProxy)
+	{	
+		return;
+	}
+
+	broadPhase->DestroyProxy(m_proxyId);
+
+	b2AABB aabb;
+	ComputeAABB(&aabb, m_position, m_R);
+
+	if (broadPhase->InRange(aabb))
+	{
+		m_proxyId = broadPhase->CreateProxy(aabb, this);
+	}
+	else
+	{
+		m_proxyId = b2_nullProxy;
+	}
+
+	if (m_proxyId == b2_nullProxy)
+	{
+		m_body->Freeze();
+	}
+}
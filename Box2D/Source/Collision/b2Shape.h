@@ -23,7 +23,7 @@
 #include "b2Collision.h"
 
 class b2Body;
-class b2BroadPhase;
+class b2BroadPhaseInterface;
 
 struct b2MassData
 {
@@ -39,6 +39,7 @@ enum b2ShapeType
 	e_boxShape,
 	e_polyShape,
 	e_meshShape,
+	e_chainShape,
 	e_shapeTypeCount,
 };
 
@@ -118,6 +119,26 @@ struct b2PolyDef : public b2ShapeDef
 	int32 vertexCount;
 };
 
+// A chain of segments grown by a common radius, so each segment is a
+// capsule. The vertices are copied when the shape is created. The whole
+// chain has one broad-phase proxy; its segments are found through a
+// bounding volume hierarchy built once in the shape frame. Each segment
+// weighs like a box of the segment length and twice the radius.
+struct b2ChainDef : public b2ShapeDef
+{
+	b2ChainDef()
+	{
+		type = e_chainShape;
+		vertices = NULL;
+		vertexCount = 0;
+		radius = 0.1f;
+	}
+
+	const b2Vec2* vertices;
+	int32 vertexCount;
+	float32 radius;
+};
+
 // Shapes are created automatically when a body is created.
 // Client code does not normally interact with shapes.
 class b2Shape
@@ -140,7 +161,7 @@ public:
 
 	// Remove and then add proxy from the broad-phase.
 	// This is used to refresh the collision filters.
-	virtual void ResetProxy(b2BroadPhase* broadPhase) = 0;
+	virtual void ResetProxy(b2BroadPhaseInterface* broadPhase) = 0;
 
 	// Get the next shape in the parent body's shape list.
 	b2Shape* GetNext();
@@ -182,7 +203,7 @@ public:
 	float32 m_minRadius;
 	float32 m_maxRadius;
 
-	uint16 m_proxyId;
+	int32 m_proxyId;
 	uint16 m_categoryBits;
 	uint16 m_maskBits;
 	int16 m_groupIndex;
@@ -193,7 +214,7 @@ class b2CircleShape : public b2Shape
 public:
 	bool TestPoint(const b2Vec2& p);
 
-	void ResetProxy(b2BroadPhase* broadPhase);
+	void ResetProxy(b2BroadPhaseInterface* broadPhase);
 
 	//--------------- Internals Below -------------------
 
@@ -222,7 +243,7 @@ class b2PolyShape : public b2Shape
 public:
 	bool TestPoint(const b2Vec2& p);
 	
-	void ResetProxy(b2BroadPhase* broadPhase);
+	void ResetProxy(b2BroadPhaseInterface* broadPhase);
 
 	//--------------- Internals Below -------------------
 	
@@ -246,6 +267,54 @@ public:
 	b2Vec2 m_normals[b2_maxPolyVertices];
 };
 
+// Bounding box of a range of chain segments, radius included. The nodes
+// are stored depth first: the node for segments [begin, end) is followed
+// by its first half [begin, mid), then its second half [mid, end), with
+// mid = (begin + end) / 2. A range of n segments takes 2n - 1 nodes.
+struct b2ChainNode
+{
+	b2AABB aabb;
+};
+
+class b2ChainShape : public b2Shape
+{
+public:
+	bool TestPoint(const b2Vec2& p);
+
+	void ResetProxy(b2BroadPhaseInterface* broadPhase);
+
+	// Get the segments whose capsules may overlap aabb, which is given in
+	// the body frame. Returns the count, up to maxCount.
+	int32 Query(const b2AABB& aabb, int32* segments, int32 maxCount) const;
+
+	// Segment end points in world coordinates.
+	b2Vec2 GetVertex(int32 index) const;
+	int32 GetSegmentCount() const;
+
+	//--------------- Internals Below -------------------
+
+	b2ChainShape(const b2ShapeDef* def, b2Body* body, const b2Vec2& newOrigin);
+	~b2ChainShape();
+
+	void Synchronize(	const b2Vec2& position1, const b2Mat22& R1,
+						const b2Vec2& position2, const b2Mat22& R2);
+	void QuickSync(const b2Vec2& position, const b2Mat22& R);
+
+	// The support of segment m_supportSegment, or of the whole chain when
+	// that is -1. Conservative advancement sets it to walk the segments.
+	b2Vec2 Support(const b2Vec2& d) const;
+
+	void ComputeAABB(b2AABB* aabb, const b2Vec2& position, const b2Mat22& R) const;
+
+	// Vertices in the body frame, relative to the center of mass.
+	b2Vec2* m_vertices;
+	int32 m_vertexCount;
+	float32 m_radius;
+
+	b2ChainNode* m_nodes;
+	int32 m_supportSegment;
+};
+
 inline b2ShapeType b2Shape::GetType() const
 {
 	return m_type;
@@ -281,5 +350,16 @@ inline float32 b2Shape::GetMaxRadius() const
 	return m_maxRadius;
 }
 
+inline b2Vec2 b2ChainShape::GetVertex(int32 index) const
+{
+	b2Assert(0 <= index && index < m_vertexCount);
+	return m_position + b2Mul(m_R, m_vertices[index]);
+}
+
+inline int32 b2ChainShape::GetSegmentCount() const
+{
+	return m_vertexCount - 1;
+}
+
 
 #endif
@@ -0,0 +1,410 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2TreeBroadPhase.h"
+#include <string.h>
+
+// Pair keys are ordered so (a, b) and (b, a) land in the same slot.
+static inline uint32 b2HashPair(int32 proxyId1, int32 proxyId2)
+{
+	uint32 key = (uint32)proxyId1 * 0x9e3779b1u ^ (uint32)proxyId2 * 0x85ebca77u;
+	return key ^ (key >> 15);
+}
+
+struct b2TreeQueryWrapper
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		if (m_count == m_maxCount)
+		{
+			return false;
+		}
+
+		m_userData[m_count++] = m_tree->GetUserData(proxyId);
+		return true;
+	}
+
+	const b2DynamicTree* m_tree;
+	void** m_userData;
+	int32 m_count;
+	int32 m_maxCount;
+};
+
+b2TreeBroadPhase::b2TreeBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
+{
+	b2Assert(worldAABB.IsValid());
+	m_worldAABB = worldAABB;
+	m_callback = callback;
+	m_proxyCount = 0;
+
+	m_moveCapacity = 64;
+	m_moveCount = 0;
+	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_pairCapacity = 64;
+	m_pairCount = 0;
+	m_pairs = (b2TreePair*)b2Alloc(m_pairCapacity * sizeof(b2TreePair));
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+	}
+
+	m_removeCapacity = 16;
+	m_removeCount = 0;
+	m_removeBuffer = (b2TreePair*)b2Alloc(m_removeCapacity * sizeof(b2TreePair));
+	m_queryProxyId = b2_nullProxy;
+	m_queryRemove = false;
+}
+
+b2TreeBroadPhase::~b2TreeBroadPhase()
+{
+	b2Free(m_moveBuffer);
+	b2Free(m_pairs);
+	b2Free(m_removeBuffer);
+}
+
+int32 b2TreeBroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	BufferMove(proxyId);
+	++m_proxyCount;
+	return proxyId;
+}
+
+void b2TreeBroadPhase::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 < m_proxyCount && m_proxyCount <= m_tree.m_nodeCapacity);
+
+	// After a commit every pair of this proxy has overlapping fat AABBs, so
+	// querying its own fat AABB finds all of them.
+	Commit();
+
+	m_queryProxyId = proxyId;
+	m_queryRemove = true;
+	m_removeCount = 0;
+	m_tree.Query(this, m_tree.GetFatAABB(proxyId));
+	m_queryRemove = false;
+
+	for (int32 i = 0; i < m_removeCount; ++i)
+	{
+		b2TreePair* pair = m_removeBuffer + i;
+		m_callback->PairRemoved(m_tree.GetUserData(pair->proxyId1), m_tree.GetUserData(pair->proxyId2), pair->userData);
+		RemovePair(pair->proxyId1, pair->proxyId2);
+	}
+
+	m_queryProxyId = b2_nullProxy;
+	m_tree.DestroyProxy(proxyId);
+	--m_proxyCount;
+}
+
+void b2TreeBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	if (proxyId == b2_nullProxy)
+	{
+		return;
+	}
+
+	bool buffered = m_tree.m_nodes[proxyId].moved;
+	if (m_tree.MoveProxy(proxyId, aabb) && buffered == false)
+	{
+		BufferMove(proxyId);
+	}
+}
+
+void b2TreeBroadPhase::BufferMove(int32 proxyId)
+{
+	if (m_moveCount == m_moveCapacity)
+	{
+		int32* oldBuffer = m_moveBuffer;
+		m_moveCapacity *= 2;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
+		b2Free(oldBuffer);
+	}
+
+	m_moveBuffer[m_moveCount++] = proxyId;
+}
+
+void b2TreeBroadPhase::BufferRemove(const b2TreePair& pair)
+{
+	if (m_removeCount == m_removeCapacity)
+	{
+		b2TreePair* oldBuffer = m_removeBuffer;
+		m_removeCapacity *= 2;
+		m_removeBuffer = (b2TreePair*)b2Alloc(m_removeCapacity * sizeof(b2TreePair));
+		memcpy(m_removeBuffer, oldBuffer, m_removeCount * sizeof(b2TreePair));
+		b2Free(oldBuffer);
+	}
+
+	m_removeBuffer[m_removeCount++] = pair;
+}
+
+void b2TreeBroadPhase::Commit()
+{
+	if (m_moveCount == 0)
+	{
+		return;
+	}
+
+	const b2TreeNode* nodes = m_tree.m_nodes;
+
+	// Drop the pairs of moved proxies whose fat AABBs came apart. Collect
+	// them first since RemovePair shuffles the table.
+	m_removeCount = 0;
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		const b2TreePair* pair = m_pairs + i;
+		if (pair->proxyId1 == b2_nullProxy)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node1 = nodes + pair->proxyId1;
+		const b2TreeNode* node2 = nodes + pair->proxyId2;
+		if ((node1->moved || node2->moved) && b2TestOverlap(node1->aabb, node2->aabb) == false)
+		{
+			BufferRemove(*pair);
+		}
+	}
+
+	for (int32 i = 0; i < m_removeCount; ++i)
+	{
+		b2TreePair* pair = m_removeBuffer + i;
+		m_callback->PairRemoved(m_tree.GetUserData(pair->proxyId1), m_tree.GetUserData(pair->proxyId2), pair->userData);
+		RemovePair(pair->proxyId1, pair->proxyId2);
+	}
+
+	// Find the new pairs. A proxy can sit in the buffer twice if it was
+	// destroyed and its id reused; AddPair ignores known pairs. Stale
+	// entries for destroyed proxies are skipped.
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 proxyId = m_moveBuffer[i];
+		if (nodes[proxyId].height != 0 || nodes[proxyId].moved == false)
+		{
+			continue;
+		}
+
+		m_queryProxyId = proxyId;
+		m_tree.Query(this, m_tree.GetFatAABB(proxyId));
+	}
+
+	m_queryProxyId = b2_nullProxy;
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		m_tree.m_nodes[m_moveBuffer[i]].moved = false;
+	}
+
+	m_moveCount = 0;
+}
+
+bool b2TreeBroadPhase::QueryCallback(int32 proxyId)
+{
+	if (proxyId == m_queryProxyId)
+	{
+		return true;
+	}
+
+	if (m_queryRemove)
+	{
+		b2TreePair* pair = FindPair(m_queryProxyId, proxyId);
+		if (pair != NULL)
+		{
+			BufferRemove(*pair);
+		}
+		return true;
+	}
+
+	// Two moved proxies find each other twice; report the pair once.
+	if (m_tree.m_nodes[proxyId].moved && proxyId < m_queryProxyId)
+	{
+		return true;
+	}
+
+	AddPair(m_queryProxyId, proxyId);
+	return true;
+}
+
+int32 b2TreeBroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
+{
+	b2TreeQueryWrapper wrapper;
+	wrapper.m_tree = &m_tree;
+	wrapper.m_userData = userData;
+	wrapper.m_count = 0;
+	wrapper.m_maxCount = maxCount;
+	m_tree.Query(&wrapper, aabb);
+	return wrapper.m_count;
+}
+
+void b2TreeBroadPhase::Reset()
+{
+	m_tree.Reset();
+	m_proxyCount = 0;
+	m_moveCount = 0;
+	m_removeCount = 0;
+
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+	}
+	m_pairCount = 0;
+}
+
+int32 b2TreeBroadPhase::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
+int32 b2TreeBroadPhase::GetPairCount() const
+{
+	return m_pairCount;
+}
+
+b2TreePair* b2TreeBroadPhase::FindPair(int32 proxyId1, int32 proxyId2)
+{
+	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
+
+	int32 mask = m_pairCapacity - 1;
+	int32 index = b2HashPair(proxyId1, proxyId2) & mask;
+	while (m_pairs[index].proxyId1 != b2_nullProxy)
+	{
+		if (m_pairs[index].proxyId1 == proxyId1 && m_pairs[index].proxyId2 == proxyId2)
+		{
+			return m_pairs + index;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	return NULL;
+}
+
+void b2TreeBroadPhase::AddPair(int32 proxyId1, int32 proxyId2)
+{
+	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
+
+	if (FindPair(proxyId1, proxyId2) != NULL)
+	{
+		return;
+	}
+
+	void* userData = m_callback->PairAdded(m_tree.GetUserData(proxyId1), m_tree.GetUserData(proxyId2));
+
+	if (2 * (m_pairCount + 1) > m_pairCapacity)
+	{
+		GrowPairs();
+	}
+
+	int32 mask = m_pairCapacity - 1;
+	int32 index = b2HashPair(proxyId1, proxyId2) & mask;
+	while (m_pairs[index].proxyId1 != b2_nullProxy)
+	{
+		index = (index + 1) & mask;
+	}
+
+	m_pairs[index].proxyId1 = proxyId1;
+	m_pairs[index].proxyId2 = proxyId2;
+	m_pairs[index].userData = userData;
+	++m_pairCount;
+}
+
+void b2TreeBroadPhase::RemovePair(int32 proxyId1, int32 proxyId2)
+{
+	b2TreePair* pair = FindPair(proxyId1, proxyId2);
+	b2Assert(pair != NULL);
+
+	// Backward shift deletion keeps probe chains intact without tombstones.
+	int32 mask = m_pairCapacity - 1;
+	int32 hole = (int32)(pair - m_pairs);
+	int32 index = hole;
+	for (;;)
+	{
+		index = (index + 1) & mask;
+		b2TreePair* next = m_pairs + index;
+		if (next->proxyId1 == b2_nullProxy)
+		{
+			break;
+		}
+
+		int32 home = b2HashPair(next->proxyId1, next->proxyId2) & mask;
+		bool shift = hole <= index ? (home <= hole || index < home) : (home <= hole && index < home);
+		if (shift)
+		{
+			m_pairs[hole] = *next;
+			hole = index;
+		}
+	}
+
+	m_pairs[hole].proxyId1 = b2_nullProxy;
+	--m_pairCount;
+}
+
+void b2TreeBroadPhase::GrowPairs()
+{
+	b2TreePair* oldPairs = m_pairs;
+	int32 oldCapacity = m_pairCapacity;
+
+	m_pairCapacity *= 2;
+	m_pairs = (b2TreePair*)b2Alloc(m_pairCapacity * sizeof(b2TreePair));
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+	}
+
+	int32 mask = m_pairCapacity - 1;
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldPairs[i].proxyId1 == b2_nullProxy)
+		{
+			continue;
+		}
+
+		int32 index = b2HashPair(oldPairs[i].proxyId1, oldPairs[i].proxyId2) & mask;
+		while (m_pairs[index].proxyId1 != b2_nullProxy)
+		{
+			index = (index + 1) & mask;
+		}
+
+		m_pairs[index] = oldPairs[i];
+	}
+
+	b2Free(oldPairs);
+}
+
+void b2TreeBroadPhase::Validate()
+{
+	m_tree.Validate();
+
+	int32 count = 0;
+	for (int32 i = 0; i < m_pairCapacity; ++i)
+	{
+		const b2TreePair* pair = m_pairs + i;
+		if (pair->proxyId1 == b2_nullProxy)
+		{
+			continue;
+		}
+
+		b2Assert(pair->proxyId1 < pair->proxyId2);
+		b2Assert(m_tree.m_nodes[pair->proxyId1].height == 0);
+		b2Assert(m_tree.m_nodes[pair->proxyId2].height == 0);
+		++count;
+	}
+
+	b2Assert(count == m_pairCount);
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TREE_BROAD_PHASE_H
+#define B2_TREE_BROAD_PHASE_H
+
+/*
+This broad phase keeps the proxies in a dynamic AABB tree (b2DynamicTree).
+Proxies store fattened AABBs, so a proxy is only reinserted when its shape
+leaves the fat box. Pairs are found at Commit by querying the tree with
+each reinserted proxy, and live in a hash set that grows on demand. Unlike
+b2BroadPhase there is no proxy cap and no quantization to the world AABB;
+the world AABB is only used by InRange.
+*/
+
+#include "b2BroadPhaseInterface.h"
+#include "b2DynamicTree.h"
+#include "b2PairManager.h"
+
+struct b2TreePair
+{
+	int32 proxyId1;		// b2_nullProxy for an empty slot
+	int32 proxyId2;
+	void* userData;
+};
+
+class b2TreeBroadPhase : public b2BroadPhaseInterface
+{
+public:
+	b2TreeBroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
+	~b2TreeBroadPhase();
+
+	bool InRange(const b2AABB& aabb) const;
+
+	// Pairs of a new proxy are reported at the next Commit. DestroyProxy
+	// commits first, then reports the removal of the proxy's pairs.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	void DestroyProxy(int32 proxyId);
+
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+	void Commit();
+
+	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
+
+	int32 GetProxyCount() const;
+	int32 GetPairCount() const;
+
+	void Reset();
+
+	void Validate();
+
+	// Tree query callback used by Commit and DestroyProxy.
+	bool QueryCallback(int32 proxyId);
+
+private:
+	b2TreePair* FindPair(int32 proxyId1, int32 proxyId2);
+	void AddPair(int32 proxyId1, int32 proxyId2);
+	void RemovePair(int32 proxyId1, int32 proxyId2);
+	void GrowPairs();
+	void BufferMove(int32 proxyId);
+	void BufferRemove(const b2TreePair& pair);
+
+public:
+	b2DynamicTree m_tree;
+	b2AABB m_worldAABB;
+	b2PairCallback* m_callback;
+	int32 m_proxyCount;
+
+	// Proxies created or reinserted since the last commit.
+	int32* m_moveBuffer;
+	int32 m_moveCount;
+	int32 m_moveCapacity;
+
+	// Open addressing with linear probing, at most half full.
+	b2TreePair* m_pairs;
+	int32 m_pairCount;
+	int32 m_pairCapacity;
+
+	// Scratch for Commit and DestroyProxy.
+	b2TreePair* m_removeBuffer;
+	int32 m_removeCount;
+	int32 m_removeCapacity;
+	int32 m_queryProxyId;
+	bool m_queryRemove;
+};
+
+inline bool b2TreeBroadPhase::InRange(const b2AABB& aabb) const
+{
+	b2Vec2 d = b2Max(aabb.minVertex - m_worldAABB.maxVertex, m_worldAABB.minVertex - aabb.maxVertex);
+	return b2Max(d.x, d.y) < 0.0f;
+}
+
+#endif
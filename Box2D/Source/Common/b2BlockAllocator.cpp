@@ -191,6 +191,28 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	m_freeLists[index] = block;
 }
 
+void b2BlockAllocator::Reset()
+{
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Chunk* chunk = m_chunks + i;
+		int32 blockSize = chunk->blockSize;
+		int32 index = s_blockSizeLookup[blockSize];
+		int32 blockCount = b2_chunkSize / blockSize;
+		for (int32 j = 0; j < blockCount - 1; ++j)
+		{
+			b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * j);
+			b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (j + 1));
+			block->next = next;
+		}
+		b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
+		last->next = m_freeLists[index];
+		m_freeLists[index] = chunk->blocks;
+	}
+}
+
 void b2BlockAllocator::Clear()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
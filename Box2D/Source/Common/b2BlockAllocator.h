@@ -44,6 +44,10 @@ public:
 
 	void Clear();
 
+	// Return every block to the free lists at once, keeping the chunks.
+	// Anything still allocated is abandoned without being freed.
+	void Reset();
+
 private:
 
 	b2Chunk* m_chunks;
@@ -25,7 +25,7 @@ int32 b2_byteCount = 0;
 void* b2Alloc(int32 size)
 {
 	size += 4;
-	b2_byteCount += size;
+	__atomic_add_fetch(&b2_byteCount, size, __ATOMIC_RELAXED);
 	char* bytes = (char*)malloc(size);
 	*(int32*)bytes = size;
 	return bytes + 4;
@@ -42,6 +42,6 @@ void b2Free(void* mem)
 	bytes -= 4;
 	int32 size = *(int32*)bytes;
 	b2Assert(b2_byteCount >= size);
-	b2_byteCount -= size;
+	__atomic_sub_fetch(&b2_byteCount, size, __ATOMIC_RELAXED);
 	free(bytes);
 }
\ No newline at end of file
@@ -51,11 +51,12 @@ const float32 b2_timeUnitsPerSecond = 1.0f;
 
 // Collision
 const int32 b2_maxManifoldPoints = 2;
+const int32 b2_maxChainManifolds = 6;			// touching segments kept per chain contact
 const int32 b2_maxShapesPerBody = 64;
 const int32 b2_maxPolyVertices = 8;
 //TMEconst int32 b2_maxProxies = 512;				// this must be a power of two
 const int32 b2_maxProxies = 2048;				// this must be a power of two
-const int32 b2_maxPairs = 8 * b2_maxProxies;	// this must be a power of two
+const int32 b2_initialPairCapacity = 1024;		// pair pool grows from here, must be a power of two
 
 // Dynamics
 const float32 b2_linearSlop = 0.005f * b2_lengthUnitsPerMeter;	// 0.5 cm
@@ -66,6 +67,10 @@ const float32 b2_maxLinearCorrection = 0.2f * b2_lengthUnitsPerMeter;	// 20 cm
 const float32 b2_maxAngularCorrection = 8.0f / 180.0f * b2_pi;			// 8 degrees
 const float32 b2_contactBaumgarte = 0.2f;
 
+// Islands are handed to worker threads in groups holding at least this many
+// bodies, contacts and joints.
+const int32 b2_minIslandTaskCost = 64;
+
 // Sleep
 const float32 b2_timeToSleep = 0.5f * b2_timeUnitsPerSecond;	// half a second
 const float32 b2_linearSleepTolerance = 0.01f * b2_lengthUnitsPerMeter / b2_timeUnitsPerSecond;	// 1 cm/s
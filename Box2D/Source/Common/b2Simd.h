@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include "b2Settings.h"
+
+// Float lanes for the SIMD contact solver. The width follows the target:
+// 8 lanes with AVX, 4 with SSE2 or NEON, and 4 plain floats otherwise so
+// the solver still builds everywhere. Loads and stores are unaligned.
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+const int32 b2_simdWidth = 8;
+typedef __m256 b2FloatW;
+
+inline b2FloatW b2ZeroW() { return _mm256_setzero_ps(); }
+inline b2FloatW b2SplatW(float32 a) { return _mm256_set1_ps(a); }
+inline b2FloatW b2LoadW(const float32* p) { return _mm256_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+const int32 b2_simdWidth = 4;
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2ZeroW() { return _mm_setzero_ps(); }
+inline b2FloatW b2SplatW(float32 a) { return _mm_set1_ps(a); }
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+const int32 b2_simdWidth = 4;
+typedef float32x4_t b2FloatW;
+
+inline b2FloatW b2ZeroW() { return vdupq_n_f32(0.0f); }
+inline b2FloatW b2SplatW(float32 a) { return vdupq_n_f32(a); }
+inline b2FloatW b2LoadW(const float32* p) { return vld1q_f32(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { vst1q_f32(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return vaddq_f32(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return vsubq_f32(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return vmulq_f32(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return vminq_f32(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return vmaxq_f32(a, b); }
+
+#else
+
+const int32 b2_simdWidth = 4;
+struct b2FloatW { float32 v[4]; };
+
+inline b2FloatW b2SplatW(float32 a) { b2FloatW r = {{a, a, a, a}}; return r; }
+inline b2FloatW b2ZeroW() { return b2SplatW(0.0f); }
+inline b2FloatW b2LoadW(const float32* p) { b2FloatW r = {{p[0], p[1], p[2], p[3]}}; return r; }
+inline void b2StoreW(float32* p, b2FloatW a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+
+#define B2_LANEWISE(name, expr) \
+	inline b2FloatW name(b2FloatW a, b2FloatW b) \
+	{ \
+		b2FloatW r; \
+		for (int32 i = 0; i < 4; ++i) { float32 x = a.v[i], y = b.v[i]; r.v[i] = (expr); } \
+		return r; \
+	}
+
+B2_LANEWISE(b2AddW, x + y)
+B2_LANEWISE(b2SubW, x - y)
+B2_LANEWISE(b2MulW, x * y)
+B2_LANEWISE(b2MinW, x < y ? x : y)
+B2_LANEWISE(b2MaxW, x > y ? x : y)
+
+#undef B2_LANEWISE
+
+#endif
+
+#endif
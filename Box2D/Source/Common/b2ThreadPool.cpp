@@ -0,0 +1,196 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2ThreadPool.h"
+
+static inline unsigned long long b2PackSlice(int32 front, int32 end)
+{
+	return (unsigned long long)(uint32)front | ((unsigned long long)(uint32)end << 32);
+}
+
+b2ThreadPool::b2ThreadPool(int32 workerCount)
+{
+	b2Assert(1 <= workerCount && workerCount <= b2_maxWorkers);
+	m_workerCount = workerCount;
+	m_callback = NULL;
+	m_context = NULL;
+	m_generation = 0;
+	m_busy = 0;
+	m_quit = false;
+
+	for (int32 i = 0; i < b2_maxWorkers; ++i)
+	{
+		m_slices[i].range = 0;
+	}
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_wake, NULL);
+	pthread_cond_init(&m_done, NULL);
+
+	for (int32 i = 1; i < m_workerCount; ++i)
+	{
+		m_threads[i].pool = this;
+		m_threads[i].index = i;
+		pthread_create(&m_threads[i].thread, NULL, ThreadMain, m_threads + i);
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&m_wake);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (int32 i = 1; i < m_workerCount; ++i)
+	{
+		pthread_join(m_threads[i].thread, NULL);
+	}
+
+	pthread_cond_destroy(&m_done);
+	pthread_cond_destroy(&m_wake);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void* b2ThreadPool::ThreadMain(void* arg)
+{
+	b2WorkerThread* self = (b2WorkerThread*)arg;
+	b2ThreadPool* pool = self->pool;
+
+	int32 generation = 0;
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->m_mutex);
+		while (pool->m_generation == generation && pool->m_quit == false)
+		{
+			pthread_cond_wait(&pool->m_wake, &pool->m_mutex);
+		}
+		generation = pool->m_generation;
+		bool quit = pool->m_quit;
+		pthread_mutex_unlock(&pool->m_mutex);
+
+		if (quit)
+		{
+			break;
+		}
+
+		pool->Work(self->index);
+
+		pthread_mutex_lock(&pool->m_mutex);
+		if (--pool->m_busy == 0)
+		{
+			pthread_cond_signal(&pool->m_done);
+		}
+		pthread_mutex_unlock(&pool->m_mutex);
+	}
+
+	return NULL;
+}
+
+void b2ThreadPool::Run(b2TaskCallback* callback, void* context, int32 taskCount)
+{
+	if (m_workerCount == 1 || taskCount <= 1)
+	{
+		for (int32 i = 0; i < taskCount; ++i)
+		{
+			callback(context, i, 0);
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < m_workerCount; ++i)
+	{
+		int32 front = (int32)((long long)taskCount * i / m_workerCount);
+		int32 end = (int32)((long long)taskCount * (i + 1) / m_workerCount);
+		m_slices[i].range = b2PackSlice(front, end);
+	}
+
+	// The mutex publishes the slices and the callback to the workers.
+	pthread_mutex_lock(&m_mutex);
+	m_callback = callback;
+	m_context = context;
+	m_busy = m_workerCount - 1;
+	++m_generation;
+	pthread_cond_broadcast(&m_wake);
+	pthread_mutex_unlock(&m_mutex);
+
+	Work(0);
+
+	pthread_mutex_lock(&m_mutex);
+	while (m_busy > 0)
+	{
+		pthread_cond_wait(&m_done, &m_mutex);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void b2ThreadPool::Work(int32 worker)
+{
+	int32 task;
+	while (Pop(worker, &task) || Steal(worker, &task))
+	{
+		m_callback(m_context, task, worker);
+	}
+}
+
+bool b2ThreadPool::Pop(int32 worker, int32* task)
+{
+	unsigned long long* range = &m_slices[worker].range;
+	unsigned long long old = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+	for (;;)
+	{
+		int32 front = (int32)(uint32)old;
+		int32 end = (int32)(uint32)(old >> 32);
+		if (front >= end)
+		{
+			return false;
+		}
+
+		if (__atomic_compare_exchange_n(range, &old, b2PackSlice(front + 1, end), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			*task = front;
+			return true;
+		}
+	}
+}
+
+bool b2ThreadPool::Steal(int32 worker, int32* task)
+{
+	for (int32 i = 1; i < m_workerCount; ++i)
+	{
+		unsigned long long* range = &m_slices[(worker + i) % m_workerCount].range;
+		unsigned long long old = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+		for (;;)
+		{
+			int32 front = (int32)(uint32)old;
+			int32 end = (int32)(uint32)(old >> 32);
+			if (front >= end)
+			{
+				break;
+			}
+
+			if (__atomic_compare_exchange_n(range, &old, b2PackSlice(front, end - 1), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				*task = end - 1;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
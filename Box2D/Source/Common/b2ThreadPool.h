@@ -0,0 +1,89 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include "b2Settings.h"
+#include <pthread.h>
+
+const int32 b2_maxWorkers = 16;
+
+// Called once per task. worker is in [0, GetWorkerCount()) and is stable for
+// the duration of the call, so it can pick per-worker scratch memory.
+typedef void b2TaskCallback(void* context, int32 task, int32 worker);
+
+// A fixed set of worker threads. Run deals the tasks out as one contiguous
+// slice per worker. A worker takes tasks from the front of its own slice and,
+// once that is empty, steals single tasks from the back of the others. The
+// calling thread takes part as worker 0, so a pool of one starts no threads.
+class b2ThreadPool
+{
+public:
+	b2ThreadPool(int32 workerCount);
+	~b2ThreadPool();
+
+	int32 GetWorkerCount() const;
+
+	// Run callback for every task in [0, taskCount) and wait for all of them.
+	void Run(b2TaskCallback* callback, void* context, int32 taskCount);
+
+private:
+	static void* ThreadMain(void* arg);
+
+	void Work(int32 worker);
+	bool Pop(int32 worker, int32* task);
+	bool Steal(int32 worker, int32* task);
+
+	// Remaining slice of one worker, front in the low word and end in the
+	// high word so that both ends move with one compare and swap. Padded to
+	// keep each slice on its own cache line.
+	struct b2TaskSlice
+	{
+		unsigned long long range;
+		char padding[56];
+	};
+
+	struct b2WorkerThread
+	{
+		b2ThreadPool* pool;
+		int32 index;
+		pthread_t thread;
+	};
+
+	b2TaskSlice m_slices[b2_maxWorkers];
+	b2WorkerThread m_threads[b2_maxWorkers];
+	int32 m_workerCount;
+
+	b2TaskCallback* m_callback;
+	void* m_context;
+
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_wake;
+	pthread_cond_t m_done;
+	int32 m_generation;
+	int32 m_busy;
+	bool m_quit;
+};
+
+inline int32 b2ThreadPool::GetWorkerCount() const
+{
+	return m_workerCount;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2Timer.h"
+
+// b2GetTicks returns nanoseconds on a monotonic clock.
+#if defined(__vita__)
+
+#include <psp2/kernel/processmgr.h>
+
+static unsigned long long b2GetTicks()
+{
+	return sceKernelGetProcessTimeWide() * 1000ULL;
+}
+
+#else
+
+#include <time.h>
+
+static unsigned long long b2GetTicks()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+#endif
+
+b2Timer::b2Timer()
+{
+	Reset();
+}
+
+void b2Timer::Reset()
+{
+	m_start = b2GetTicks();
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	return (b2GetTicks() - m_start) * 1.0e-6f;
+}
@@ -0,0 +1,295 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2ChainContact.h"
+#include "b2Conservative.h"
+#include "../b2Body.h"
+#include "../../Common/b2BlockAllocator.h"
+
+#include <memory>
+#include <new>
+
+// Enough for a shape resting across a finely drawn chain.
+const int32 k_maxSegments = 64;
+
+// Bounds of shape in the frame of the chain's body.
+static void ComputeLocalAABB(b2AABB* aabb, const b2ChainShape* chain, const b2Shape* shape)
+{
+	switch (shape->m_type)
+	{
+	case e_circleShape:
+		{
+			const b2CircleShape* circle = (const b2CircleShape*)shape;
+			b2Vec2 c = b2MulT(chain->m_R, circle->m_position - chain->m_position);
+			b2Vec2 r(circle->m_radius, circle->m_radius);
+			aabb->minVertex = c - r;
+			aabb->maxVertex = c + r;
+		}
+		break;
+
+	case e_polyShape:
+		{
+			const b2PolyShape* poly = (const b2PolyShape*)shape;
+			b2Mat22 R = b2MulT(chain->m_R, poly->m_R);
+			b2Vec2 p = b2MulT(chain->m_R, poly->m_position - chain->m_position);
+			aabb->minVertex = aabb->maxVertex = p + b2Mul(R, poly->m_vertices[0]);
+			for (int32 i = 1; i < poly->m_vertexCount; ++i)
+			{
+				b2Vec2 v = p + b2Mul(R, poly->m_vertices[i]);
+				aabb->minVertex = b2Min(aabb->minVertex, v);
+				aabb->maxVertex = b2Max(aabb->maxVertex, v);
+			}
+		}
+		break;
+
+	case e_chainShape:
+		{
+			const b2ChainShape* other = (const b2ChainShape*)shape;
+			const b2AABB& box = other->m_nodes[0].aabb;
+			b2Mat22 R = b2MulT(chain->m_R, other->m_R);
+			b2Vec2 p = b2MulT(chain->m_R, other->m_position - chain->m_position);
+			b2Vec2 center = p + b2Mul(R, 0.5f * (box.minVertex + box.maxVertex));
+			b2Vec2 h = b2Mul(b2Abs(R), 0.5f * (box.maxVertex - box.minVertex));
+			aabb->minVertex = center - h;
+			aabb->maxVertex = center + h;
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+b2Contact* b2ChainContact::Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2ChainContact));
+	return new (mem) b2ChainContact(shape1, shape2);
+}
+
+void b2ChainContact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
+{
+	((b2ChainContact*)contact)->~b2ChainContact();
+	allocator->Free(contact, sizeof(b2ChainContact));
+}
+
+b2ChainContact::b2ChainContact(b2Shape* s1, b2Shape* s2)
+: b2Contact(s1, s2)
+{
+	b2Assert(m_shape1->m_type == e_chainShape);
+	for (int32 i = 0; i < b2_maxChainManifolds; ++i)
+	{
+		m_manifolds[i].pointCount = 0;
+		m_keys[i] = 0;
+	}
+}
+
+void b2ChainContact::AddManifold(const b2Manifold& manifold, uint32 key)
+{
+	if (manifold.pointCount == 0)
+	{
+		return;
+	}
+
+	int32 index = m_manifoldCount;
+	if (index == b2_maxChainManifolds)
+	{
+		// Full: replace the shallowest manifold if this one is deeper.
+		float32 depth = b2Min(manifold.points[0].separation, manifold.points[manifold.pointCount - 1].separation);
+		float32 maxDepth = depth;
+		for (int32 i = 0; i < m_manifoldCount; ++i)
+		{
+			const b2Manifold* m = m_manifolds + i;
+			float32 d = b2Min(m->points[0].separation, m->points[m->pointCount - 1].separation);
+			if (d > maxDepth)
+			{
+				maxDepth = d;
+				index = i;
+			}
+		}
+
+		if (index == b2_maxChainManifolds)
+		{
+			return;
+		}
+	}
+	else
+	{
+		++m_manifoldCount;
+	}
+
+	m_manifolds[index] = manifold;
+	m_keys[index] = key;
+}
+
+void b2ChainContact::Evaluate()
+{
+	b2ChainShape* chain = (b2ChainShape*)m_shape1;
+
+	b2Manifold m0[b2_maxChainManifolds];
+	uint32 keys0[b2_maxChainManifolds];
+	int32 count0 = m_manifoldCount;
+	memcpy(m0, m_manifolds, count0 * sizeof(b2Manifold));
+	memcpy(keys0, m_keys, count0 * sizeof(uint32));
+
+	b2AABB aabb;
+	ComputeLocalAABB(&aabb, chain, m_shape2);
+
+	int32 segments[k_maxSegments];
+	int32 count = chain->Query(aabb, segments, k_maxSegments);
+
+	m_manifoldCount = 0;
+	b2Manifold manifold;
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 segment = segments[i];
+		switch (m_shape2->m_type)
+		{
+		case e_circleShape:
+			b2CollideChainAndCircle(&manifold, chain, segment, (b2CircleShape*)m_shape2);
+			AddManifold(manifold, segment);
+			break;
+
+		case e_polyShape:
+			b2CollideChainAndPoly(&manifold, chain, segment, (b2PolyShape*)m_shape2);
+			AddManifold(manifold, segment);
+			break;
+
+		case e_chainShape:
+			{
+				// Find the segments of chain 2 near this segment.
+				b2ChainShape* other = (b2ChainShape*)m_shape2;
+				b2Vec2 v1 = b2MulT(other->m_R, chain->GetVertex(segment) - other->m_position);
+				b2Vec2 v2 = b2MulT(other->m_R, chain->GetVertex(segment + 1) - other->m_position);
+				b2Vec2 r(chain->m_radius, chain->m_radius);
+				b2AABB box;
+				box.minVertex = b2Min(v1, v2) - r;
+				box.maxVertex = b2Max(v1, v2) + r;
+
+				int32 others[k_maxSegments];
+				int32 otherCount = other->Query(box, others, k_maxSegments);
+				for (int32 j = 0; j < otherCount; ++j)
+				{
+					b2CollideChains(&manifold, chain, segment, other, others[j]);
+					AddManifold(manifold, (uint32)segment | ((uint32)others[j] << 16));
+				}
+			}
+			break;
+
+		default:
+			b2Assert(false);
+			break;
+		}
+	}
+
+	// Match old contact ids to new contact ids and copy the
+	// stored impulses to warm start the solver.
+	for (int32 i = 0; i < m_manifoldCount; ++i)
+	{
+		b2Manifold* m = m_manifolds + i;
+		const b2Manifold* old = NULL;
+		for (int32 j = 0; j < count0; ++j)
+		{
+			if (keys0[j] == m_keys[i])
+			{
+				old = m0 + j;
+				break;
+			}
+		}
+
+		bool match[b2_maxManifoldPoints] = {false, false};
+		for (int32 k = 0; k < m->pointCount; ++k)
+		{
+			b2ContactPoint* cp = m->points + k;
+			cp->normalImpulse = 0.0f;
+			cp->tangentImpulse = 0.0f;
+
+			if (old == NULL)
+			{
+				continue;
+			}
+
+			for (int32 l = 0; l < old->pointCount; ++l)
+			{
+				if (match[l] == true)
+					continue;
+
+				if (old->points[l].id.key == cp->id.key)
+				{
+					match[l] = true;
+					cp->normalImpulse = old->points[l].normalImpulse;
+					cp->tangentImpulse = old->points[l].tangentImpulse;
+					break;
+				}
+			}
+		}
+	}
+}
+
+// Conservative advancement of the other shape against each segment it can
+// reach during the step. The segments are found with a box around both
+// ends of the other body's sweep in the chain's frame, grown by how far
+// the chain's rotation can swing it.
+float32 b2ChainContact::ComputeTOI()
+{
+	b2ChainShape* chain = (b2ChainShape*)m_shape1;
+	b2Body* body1 = chain->m_body;
+	b2Body* body2 = m_shape2->m_body;
+
+	b2Mat22 R1Start(body1->m_rotation0);
+	b2Vec2 pStart = b2MulT(R1Start, body2->m_position0 - body1->m_position0);
+	b2Vec2 pEnd = b2MulT(body1->m_R, body2->m_position - body1->m_position);
+
+	float32 swing = b2Abs(body1->m_rotation - body1->m_rotation0) * b2Max(pStart.Length(), pEnd.Length());
+	float32 extent = m_shape2->GetMaxRadius() + swing;
+	b2Vec2 r(extent, extent);
+
+	b2AABB aabb;
+	aabb.minVertex = b2Min(pStart, pEnd) - r;
+	aabb.maxVertex = b2Max(pStart, pEnd) + r;
+
+	int32 segments[k_maxSegments];
+	int32 count = chain->Query(aabb, segments, k_maxSegments);
+
+	float32 toi = 1.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		chain->m_supportSegment = segments[i];
+		toi = b2Min(toi, b2Conservative(chain, m_shape2));
+	}
+	chain->m_supportSegment = -1;
+
+	return toi;
+}
+
+int32 b2ChainContact::GetStateSize() const
+{
+	return b2Contact::GetStateSize() + m_manifoldCount * sizeof(uint32);
+}
+
+void b2ChainContact::SaveState(void* buffer)
+{
+	b2Contact::SaveState(buffer);
+	memcpy((int8*)buffer + b2Contact::GetStateSize(), m_keys, m_manifoldCount * sizeof(uint32));
+}
+
+void b2ChainContact::RestoreState(const void* buffer)
+{
+	b2Contact::RestoreState(buffer);
+	memcpy(m_keys, (const int8*)buffer + b2Contact::GetStateSize(), m_manifoldCount * sizeof(uint32));
+}
@@ -0,0 +1,59 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef CHAIN_CONTACT_H
+#define CHAIN_CONTACT_H
+
+#include "b2Contact.h"
+
+class b2BlockAllocator;
+
+// A chain against a circle, a polygon or another chain. Every touching
+// segment (or segment pair) gets its own manifold; when more than
+// b2_maxChainManifolds touch, the deepest are kept. The chain is always
+// shape1.
+class b2ChainContact : public b2Contact
+{
+public:
+	static b2Contact* Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator);
+	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
+
+	b2ChainContact(b2Shape* shape1, b2Shape* shape2);
+	~b2ChainContact() {}
+
+	void Evaluate();
+	float32 ComputeTOI();
+	b2Manifold* GetManifolds()
+	{
+		return m_manifolds;
+	}
+
+	void AddManifold(const b2Manifold& manifold, uint32 key);
+
+	int32 GetStateSize() const;
+	void SaveState(void* buffer);
+	void RestoreState(const void* buffer);
+
+	b2Manifold m_manifolds[b2_maxChainManifolds];
+
+	// The segment (and segment of chain 2) behind each manifold, used to
+	// carry impulses over for warm starting.
+	uint32 m_keys[b2_maxChainManifolds];
+};
+
+#endif
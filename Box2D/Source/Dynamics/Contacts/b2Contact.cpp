@@ -20,6 +20,7 @@
 #include "b2CircleContact.h"
 #include "b2PolyAndCircleContact.h"
 #include "b2PolyContact.h"
+#include "b2ChainContact.h"
 #include "b2Conservative.h"
 #include "../../Collision/b2Collision.h"
 #include "../../Collision/b2Shape.h"
@@ -35,6 +36,9 @@ void b2Contact::InitializeRegisters()
 	AddType(b2CircleContact::Create, b2CircleContact::Destroy, e_circleShape, e_circleShape);
 	AddType(b2PolyAndCircleContact::Create, b2PolyAndCircleContact::Destroy, e_polyShape, e_circleShape);
 	AddType(b2PolyContact::Create, b2PolyContact::Destroy, e_polyShape, e_polyShape);
+	AddType(b2ChainContact::Create, b2ChainContact::Destroy, e_chainShape, e_circleShape);
+	AddType(b2ChainContact::Create, b2ChainContact::Destroy, e_chainShape, e_polyShape);
+	AddType(b2ChainContact::Create, b2ChainContact::Destroy, e_chainShape, e_chainShape);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -113,6 +117,25 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 	destroyFcn(contact, allocator);
 }
 
+int32 b2Contact::GetStateSize() const
+{
+	return sizeof(int32) + m_manifoldCount * sizeof(b2Manifold);
+}
+
+void b2Contact::SaveState(void* buffer)
+{
+	int32* count = (int32*)buffer;
+	*count = m_manifoldCount;
+	memcpy(count + 1, GetManifolds(), m_manifoldCount * sizeof(b2Manifold));
+}
+
+void b2Contact::RestoreState(const void* buffer)
+{
+	const int32* count = (const int32*)buffer;
+	m_manifoldCount = *count;
+	memcpy(GetManifolds(), count + 1, m_manifoldCount * sizeof(b2Manifold));
+}
+
 b2Contact::b2Contact(b2Shape* s1, b2Shape* s2)
 {
 	m_flags = 0;
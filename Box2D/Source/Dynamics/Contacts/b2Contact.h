@@ -80,8 +80,15 @@ public:
 	b2Contact(b2Shape* shape1, b2Shape* shape2);
 	virtual ~b2Contact() {}
 
-	float32 ComputeTOI();
+	virtual float32 ComputeTOI();
 	virtual void Evaluate() = 0;
+
+	// State kept by world snapshots: the manifolds, plus whatever else the
+	// contact uses to match old manifolds to new ones.
+	virtual int32 GetStateSize() const;
+	virtual void SaveState(void* buffer);
+	virtual void RestoreState(const void* buffer);
+
 	static b2ContactRegister s_registers[e_shapeTypeCount][e_shapeTypeCount];
 	static bool s_initialized;
 
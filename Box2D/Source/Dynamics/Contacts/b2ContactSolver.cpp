@@ -153,10 +153,16 @@ void b2ContactSolver::InitVelocityConstraints()
 				b2Vec2 P = ccp->normalImpulse * normal + ccp->tangentImpulse * tangent;
 				b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
 				b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
-				b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
-				b1->m_linearVelocity -= invMass1 * P;
-				b2->m_angularVelocity += invI2 * b2Cross(r2, P);
-				b2->m_linearVelocity += invMass2 * P;
+				if (!b1->IsStatic())
+				{
+					b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+					b1->m_linearVelocity -= invMass1 * P;
+				}
+				if (!b2->IsStatic())
+				{
+					b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+					b2->m_linearVelocity += invMass2 * P;
+				}
 			}
 		}
 		else
@@ -207,11 +213,16 @@ void b2ContactSolver::SolveVelocityConstraints()
 			// Apply contact impulse
 			b2Vec2 P = lambda * normal;
 
-			b1->m_linearVelocity -= invMass1 * P;
-			b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
-
-			b2->m_linearVelocity += invMass2 * P;
-			b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+			if (!b1->IsStatic())
+			{
+				b1->m_linearVelocity -= invMass1 * P;
+				b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+			}
+			if (!b2->IsStatic())
+			{
+				b2->m_linearVelocity += invMass2 * P;
+				b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+			}
 
 			ccp->normalImpulse = newImpulse;
 		}
@@ -239,11 +250,16 @@ void b2ContactSolver::SolveVelocityConstraints()
 			// Apply contact impulse
 			b2Vec2 P = lambda * tangent;
 
-			b1->m_linearVelocity -= invMass1 * P;
-			b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
-
-			b2->m_linearVelocity += invMass2 * P;
-			b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+			if (!b1->IsStatic())
+			{
+				b1->m_linearVelocity -= invMass1 * P;
+				b1->m_angularVelocity -= invI1 * b2Cross(r1, P);
+			}
+			if (!b2->IsStatic())
+			{
+				b2->m_linearVelocity += invMass2 * P;
+				b2->m_angularVelocity += invI2 * b2Cross(r2, P);
+			}
 
 			ccp->tangentImpulse = newImpulse;
 		}
@@ -317,13 +333,18 @@ bool b2ContactSolver::SolvePositionConstraints()
 
 			b2Vec2 impulse = dImpulse * normal;
 
-			b1->m_position -= invMass1 * impulse;
-			b1->m_rotation -= invI1 * b2Cross(r1, impulse);
-			b1->m_R.Set(b1->m_rotation);
-
-			b2->m_position += invMass2 * impulse;
-			b2->m_rotation += invI2 * b2Cross(r2, impulse);
-			b2->m_R.Set(b2->m_rotation);
+			if (!b1->IsStatic())
+			{
+				b1->m_position -= invMass1 * impulse;
+				b1->m_rotation -= invI1 * b2Cross(r1, impulse);
+				b1->m_R.Set(b1->m_rotation);
+			}
+			if (!b2->IsStatic())
+			{
+				b2->m_position += invMass2 * impulse;
+				b2->m_rotation += invI2 * b2Cross(r2, impulse);
+				b2->m_R.Set(b2->m_rotation);
+			}
 		}
 	}
 
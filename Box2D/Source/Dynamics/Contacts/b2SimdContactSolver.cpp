@@ -0,0 +1,683 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2SimdContactSolver.h"
+#include "b2Contact.h"
+#include "../b2Body.h"
+#include "../b2World.h"
+#include "../../Common/b2StackAllocator.h"
+
+// Separation given to unused manifold points and padding lanes. It keeps
+// them out of the position solver and the minimum separation.
+const float32 b2_unusedSeparation = 1.0e30f;
+
+b2SimdContactSolver::b2SimdContactSolver(b2Body** bodies, int32 bodyCount, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator)
+: b2ContactSolver(contacts, contactCount, allocator)
+{
+	m_bodies = bodies;
+	m_bodyCount = bodyCount;
+	m_solverBodies = NULL;
+	m_solverBodyCount = 0;
+	m_batches = NULL;
+	m_batchCount = 0;
+
+	// Small islands would be mostly padding. Leave them to the scalar path.
+	if (m_constraintCount < e_minConstraints)
+	{
+		return;
+	}
+
+	// Slot 0 pads partial batches, then one slot per dynamic body and one
+	// per static end of a constraint. Static slots never change so several
+	// lanes may share a static body.
+	int32 capacity = 1 + bodyCount + m_constraintCount;
+	m_solverBodies = (b2SolverBody*)m_allocator->Allocate(capacity * sizeof(b2SolverBody));
+	memset(m_solverBodies, 0, sizeof(b2SolverBody));
+	m_solverBodyCount = 1;
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (b->IsStatic())
+		{
+			continue;
+		}
+
+		b->m_islandIndex = m_solverBodyCount;
+		b2SolverBody* sb = m_solverBodies + m_solverBodyCount++;
+		sb->colors = 0;
+		sb->body = b;
+	}
+
+	// Count the constraints of each color. The last color collects the
+	// constraints that found no free color; they are solved one per batch.
+	int32 colorCounts[e_maxColors + 1];
+	memset(colorCounts, 0, sizeof(colorCounts));
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		++colorCounts[AssignColor(m_constraints + i, NULL, NULL)];
+	}
+
+	int32 colorBatches[e_maxColors + 1];
+	m_batchCount = 0;
+	for (int32 i = 0; i < e_maxColors; ++i)
+	{
+		colorBatches[i] = m_batchCount;
+		m_batchCount += (colorCounts[i] + b2_simdWidth - 1) / b2_simdWidth;
+	}
+	colorBatches[e_maxColors] = m_batchCount;
+	m_batchCount += colorCounts[e_maxColors];
+
+	m_batches = (b2SimdContactBatch*)m_allocator->Allocate(m_batchCount * sizeof(b2SimdContactBatch));
+	memset(m_batches, 0, m_batchCount * sizeof(b2SimdContactBatch));
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			for (int32 k = 0; k < b2_simdWidth; ++k)
+			{
+				m_batches[i].points[j].separation[k] = b2_unusedSeparation;
+			}
+		}
+	}
+
+	// Color again, the same way, and fill the lanes.
+	for (int32 i = 1; i < m_solverBodyCount; ++i)
+	{
+		m_solverBodies[i].colors = 0;
+	}
+
+	int32 colorFill[e_maxColors + 1];
+	memset(colorFill, 0, sizeof(colorFill));
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		int32 index1, index2;
+		int32 color = AssignColor(c, &index1, &index2);
+
+		int32 slot = colorFill[color]++;
+		b2SimdContactBatch* batch;
+		int32 lane;
+		if (color == e_maxColors)
+		{
+			batch = m_batches + colorBatches[color] + slot;
+			lane = 0;
+		}
+		else
+		{
+			batch = m_batches + colorBatches[color] + slot / b2_simdWidth;
+			lane = slot % b2_simdWidth;
+		}
+
+		b2Body* b1 = c->body1;
+		b2Body* b2 = c->body2;
+
+		batch->constraints[lane] = c;
+		batch->body1[lane] = index1;
+		batch->body2[lane] = index2;
+		batch->normalX[lane] = c->normal.x;
+		batch->normalY[lane] = c->normal.y;
+		batch->friction[lane] = c->friction;
+		batch->invMass1[lane] = b1->m_invMass;
+		batch->invI1[lane] = b1->m_invI;
+		batch->invMass2[lane] = b2->m_invMass;
+		batch->invI2[lane] = b2->m_invI;
+
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+			b2SimdContactPoint* p = batch->points + j;
+
+			b2Vec2 r1 = b2Mul(b1->m_R, ccp->localAnchor1);
+			b2Vec2 r2 = b2Mul(b2->m_R, ccp->localAnchor2);
+
+			p->r1x[lane] = r1.x;
+			p->r1y[lane] = r1.y;
+			p->r2x[lane] = r2.x;
+			p->r2y[lane] = r2.y;
+			p->localAnchor1x[lane] = ccp->localAnchor1.x;
+			p->localAnchor1y[lane] = ccp->localAnchor1.y;
+			p->localAnchor2x[lane] = ccp->localAnchor2.x;
+			p->localAnchor2y[lane] = ccp->localAnchor2.y;
+			p->normalImpulse[lane] = ccp->normalImpulse;
+			p->tangentImpulse[lane] = ccp->tangentImpulse;
+			p->positionImpulse[lane] = 0.0f;
+			p->normalMass[lane] = ccp->normalMass;
+			p->tangentMass[lane] = ccp->tangentMass;
+			p->separation[lane] = ccp->separation;
+			p->velocityBias[lane] = ccp->velocityBias;
+		}
+	}
+}
+
+b2SimdContactSolver::~b2SimdContactSolver()
+{
+	if (m_batches)
+	{
+		m_allocator->Free(m_batches);
+		m_allocator->Free(m_solverBodies);
+	}
+}
+
+// Pick the lowest color free on both dynamic bodies of c. When the
+// indices are requested the color is also claimed and static bodies get
+// a slot of their own.
+int32 b2SimdContactSolver::AssignColor(b2ContactConstraint* c, int32* index1, int32* index2)
+{
+	b2Body* bodies[2] = { c->body1, c->body2 };
+	int32 indices[2];
+	uint32 used = 0;
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		if (bodies[i]->IsStatic())
+		{
+			indices[i] = 0;
+		}
+		else
+		{
+			indices[i] = bodies[i]->m_islandIndex;
+			used |= m_solverBodies[indices[i]].colors;
+		}
+	}
+
+	int32 color = 0;
+	while (color < e_maxColors && (used & (1u << color)))
+	{
+		++color;
+	}
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		if (indices[i] != 0 && color < e_maxColors)
+		{
+			m_solverBodies[indices[i]].colors |= 1u << color;
+		}
+	}
+
+	if (index1 == NULL)
+	{
+		return color;
+	}
+
+	for (int32 i = 0; i < 2; ++i)
+	{
+		if (indices[i] == 0)
+		{
+			b2Body* b = bodies[i];
+			indices[i] = m_solverBodyCount;
+			b2SolverBody* sb = m_solverBodies + m_solverBodyCount++;
+			sb->linearVelocity = b->m_linearVelocity;
+			sb->angularVelocity = b->m_angularVelocity;
+			sb->position = b->m_position;
+			sb->rotation = b->m_rotation;
+			sb->cosine = b->m_R.col1.x;
+			sb->sine = b->m_R.col1.y;
+			sb->colors = 0;
+			sb->body = NULL;
+		}
+	}
+
+	*index1 = indices[0];
+	*index2 = indices[1];
+	return color;
+}
+
+void b2SimdContactSolver::LoadVelocities()
+{
+	for (int32 i = 1; i < m_solverBodyCount; ++i)
+	{
+		b2SolverBody* sb = m_solverBodies + i;
+		if (sb->body)
+		{
+			sb->linearVelocity = sb->body->m_linearVelocity;
+			sb->angularVelocity = sb->body->m_angularVelocity;
+		}
+	}
+}
+
+void b2SimdContactSolver::StoreVelocities()
+{
+	for (int32 i = 1; i < m_solverBodyCount; ++i)
+	{
+		b2SolverBody* sb = m_solverBodies + i;
+		if (sb->body)
+		{
+			sb->body->m_linearVelocity = sb->linearVelocity;
+			sb->body->m_angularVelocity = sb->angularVelocity;
+		}
+	}
+}
+
+void b2SimdContactSolver::LoadPositions()
+{
+	for (int32 i = 1; i < m_solverBodyCount; ++i)
+	{
+		b2SolverBody* sb = m_solverBodies + i;
+		if (sb->body)
+		{
+			sb->position = sb->body->m_position;
+			sb->rotation = sb->body->m_rotation;
+			sb->cosine = sb->body->m_R.col1.x;
+			sb->sine = sb->body->m_R.col1.y;
+		}
+	}
+}
+
+void b2SimdContactSolver::StorePositions()
+{
+	for (int32 i = 1; i < m_solverBodyCount; ++i)
+	{
+		b2SolverBody* sb = m_solverBodies + i;
+		if (sb->body)
+		{
+			b2Body* b = sb->body;
+			b->m_position = sb->position;
+			b->m_rotation = sb->rotation;
+			b->m_R.col1.x = sb->cosine;
+			b->m_R.col1.y = sb->sine;
+			b->m_R.col2.x = -sb->sine;
+			b->m_R.col2.y = sb->cosine;
+		}
+	}
+}
+
+// Lane-wise body state of one side of a batch.
+struct b2VelocityW
+{
+	b2FloatW vx, vy, w;
+};
+
+static inline b2VelocityW b2GatherVelocity(const b2SolverBody* bodies, const int32* indices)
+{
+	float32 vx[b2_simdWidth], vy[b2_simdWidth], w[b2_simdWidth];
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		const b2SolverBody* sb = bodies + indices[i];
+		vx[i] = sb->linearVelocity.x;
+		vy[i] = sb->linearVelocity.y;
+		w[i] = sb->angularVelocity;
+	}
+
+	b2VelocityW v;
+	v.vx = b2LoadW(vx);
+	v.vy = b2LoadW(vy);
+	v.w = b2LoadW(w);
+	return v;
+}
+
+static inline void b2ScatterVelocity(b2SolverBody* bodies, const int32* indices, const b2VelocityW& v)
+{
+	float32 vx[b2_simdWidth], vy[b2_simdWidth], w[b2_simdWidth];
+	b2StoreW(vx, v.vx);
+	b2StoreW(vy, v.vy);
+	b2StoreW(w, v.w);
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		b2SolverBody* sb = bodies + indices[i];
+		sb->linearVelocity.x = vx[i];
+		sb->linearVelocity.y = vy[i];
+		sb->angularVelocity = w[i];
+	}
+}
+
+// Apply the impulse (px, py) at r1/r2 to the two sides of a batch.
+static inline void b2ApplyImpulse(b2VelocityW& v1, b2VelocityW& v2,
+								  b2FloatW invMass1, b2FloatW invI1, b2FloatW invMass2, b2FloatW invI2,
+								  b2FloatW r1x, b2FloatW r1y, b2FloatW r2x, b2FloatW r2y,
+								  b2FloatW px, b2FloatW py)
+{
+	v1.vx = b2SubW(v1.vx, b2MulW(invMass1, px));
+	v1.vy = b2SubW(v1.vy, b2MulW(invMass1, py));
+	v1.w = b2SubW(v1.w, b2MulW(invI1, b2SubW(b2MulW(r1x, py), b2MulW(r1y, px))));
+
+	v2.vx = b2AddW(v2.vx, b2MulW(invMass2, px));
+	v2.vy = b2AddW(v2.vy, b2MulW(invMass2, py));
+	v2.w = b2AddW(v2.w, b2MulW(invI2, b2SubW(b2MulW(r2x, py), b2MulW(r2y, px))));
+}
+
+void b2SimdContactSolver::InitVelocityConstraints()
+{
+	if (m_batches == NULL)
+	{
+		b2ContactSolver::InitVelocityConstraints();
+		return;
+	}
+
+	if (b2World::s_enableWarmStarting == 0)
+	{
+		for (int32 i = 0; i < m_batchCount; ++i)
+		{
+			for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+			{
+				b2SimdContactPoint* p = m_batches[i].points + j;
+				memset(p->normalImpulse, 0, sizeof(p->normalImpulse));
+				memset(p->tangentImpulse, 0, sizeof(p->tangentImpulse));
+			}
+		}
+		return;
+	}
+
+	// Warm start.
+	LoadVelocities();
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2SimdContactBatch* batch = m_batches + i;
+		b2VelocityW v1 = b2GatherVelocity(m_solverBodies, batch->body1);
+		b2VelocityW v2 = b2GatherVelocity(m_solverBodies, batch->body2);
+		b2FloatW invMass1 = b2LoadW(batch->invMass1), invI1 = b2LoadW(batch->invI1);
+		b2FloatW invMass2 = b2LoadW(batch->invMass2), invI2 = b2LoadW(batch->invI2);
+		b2FloatW nx = b2LoadW(batch->normalX), ny = b2LoadW(batch->normalY);
+
+		// tangent = b2Cross(normal, 1.0f)
+		b2FloatW tx = ny, ty = b2SubW(b2ZeroW(), nx);
+
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2SimdContactPoint* p = batch->points + j;
+			b2FloatW ni = b2LoadW(p->normalImpulse), ti = b2LoadW(p->tangentImpulse);
+			b2FloatW px = b2AddW(b2MulW(ni, nx), b2MulW(ti, tx));
+			b2FloatW py = b2AddW(b2MulW(ni, ny), b2MulW(ti, ty));
+			b2ApplyImpulse(v1, v2, invMass1, invI1, invMass2, invI2,
+						   b2LoadW(p->r1x), b2LoadW(p->r1y), b2LoadW(p->r2x), b2LoadW(p->r2y), px, py);
+		}
+
+		b2ScatterVelocity(m_solverBodies, batch->body1, v1);
+		b2ScatterVelocity(m_solverBodies, batch->body2, v2);
+	}
+
+	StoreVelocities();
+}
+
+void b2SimdContactSolver::SolveVelocityConstraints()
+{
+	if (m_batches == NULL)
+	{
+		b2ContactSolver::SolveVelocityConstraints();
+		return;
+	}
+
+	LoadVelocities();
+
+	const b2FloatW zero = b2ZeroW();
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2SimdContactBatch* batch = m_batches + i;
+		b2VelocityW v1 = b2GatherVelocity(m_solverBodies, batch->body1);
+		b2VelocityW v2 = b2GatherVelocity(m_solverBodies, batch->body2);
+		b2FloatW invMass1 = b2LoadW(batch->invMass1), invI1 = b2LoadW(batch->invI1);
+		b2FloatW invMass2 = b2LoadW(batch->invMass2), invI2 = b2LoadW(batch->invI2);
+		b2FloatW nx = b2LoadW(batch->normalX), ny = b2LoadW(batch->normalY);
+		b2FloatW tx = ny, ty = b2SubW(zero, nx);
+
+		// Solver normal constraints
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2SimdContactPoint* p = batch->points + j;
+			b2FloatW r1x = b2LoadW(p->r1x), r1y = b2LoadW(p->r1y);
+			b2FloatW r2x = b2LoadW(p->r2x), r2y = b2LoadW(p->r2y);
+
+			// Relative velocity at contact
+			b2FloatW dvx = b2SubW(b2SubW(b2AddW(v2.vx, b2MulW(b2SubW(zero, v2.w), r2y)), v1.vx), b2MulW(b2SubW(zero, v1.w), r1y));
+			b2FloatW dvy = b2SubW(b2SubW(b2AddW(v2.vy, b2MulW(v2.w, r2x)), v1.vy), b2MulW(v1.w, r1x));
+
+			// Compute normal impulse
+			b2FloatW vn = b2AddW(b2MulW(dvx, nx), b2MulW(dvy, ny));
+			b2FloatW lambda = b2MulW(b2SubW(zero, b2LoadW(p->normalMass)), b2SubW(vn, b2LoadW(p->velocityBias)));
+
+			// b2Clamp the accumulated impulse
+			b2FloatW impulse0 = b2LoadW(p->normalImpulse);
+			b2FloatW newImpulse = b2MaxW(b2AddW(impulse0, lambda), zero);
+			lambda = b2SubW(newImpulse, impulse0);
+
+			// Apply contact impulse
+			b2ApplyImpulse(v1, v2, invMass1, invI1, invMass2, invI2, r1x, r1y, r2x, r2y,
+						   b2MulW(lambda, nx), b2MulW(lambda, ny));
+
+			b2StoreW(p->normalImpulse, newImpulse);
+		}
+
+		// Solver tangent constraints
+		b2FloatW friction = b2LoadW(batch->friction);
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2SimdContactPoint* p = batch->points + j;
+			b2FloatW r1x = b2LoadW(p->r1x), r1y = b2LoadW(p->r1y);
+			b2FloatW r2x = b2LoadW(p->r2x), r2y = b2LoadW(p->r2y);
+
+			// Relative velocity at contact
+			b2FloatW dvx = b2SubW(b2SubW(b2AddW(v2.vx, b2MulW(b2SubW(zero, v2.w), r2y)), v1.vx), b2MulW(b2SubW(zero, v1.w), r1y));
+			b2FloatW dvy = b2SubW(b2SubW(b2AddW(v2.vy, b2MulW(v2.w, r2x)), v1.vy), b2MulW(v1.w, r1x));
+
+			// Compute tangent impulse
+			b2FloatW vt = b2AddW(b2MulW(dvx, tx), b2MulW(dvy, ty));
+			b2FloatW lambda = b2MulW(b2LoadW(p->tangentMass), b2SubW(zero, vt));
+
+			// b2Clamp the accumulated impulse
+			b2FloatW maxFriction = b2MulW(friction, b2LoadW(p->normalImpulse));
+			b2FloatW impulse0 = b2LoadW(p->tangentImpulse);
+			b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxFriction), b2MinW(b2AddW(impulse0, lambda), maxFriction));
+			lambda = b2SubW(newImpulse, impulse0);
+
+			// Apply contact impulse
+			b2ApplyImpulse(v1, v2, invMass1, invI1, invMass2, invI2, r1x, r1y, r2x, r2y,
+						   b2MulW(lambda, tx), b2MulW(lambda, ty));
+
+			b2StoreW(p->tangentImpulse, newImpulse);
+		}
+
+		b2ScatterVelocity(m_solverBodies, batch->body1, v1);
+		b2ScatterVelocity(m_solverBodies, batch->body2, v2);
+	}
+
+	StoreVelocities();
+}
+
+void b2SimdContactSolver::FinalizeVelocityConstraints()
+{
+	if (m_batches == NULL)
+	{
+		b2ContactSolver::FinalizeVelocityConstraints();
+		return;
+	}
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2SimdContactBatch* batch = m_batches + i;
+		for (int32 k = 0; k < b2_simdWidth; ++k)
+		{
+			b2ContactConstraint* c = batch->constraints[k];
+			if (c == NULL)
+			{
+				continue;
+			}
+
+			b2Manifold* m = c->manifold;
+			for (int32 j = 0; j < c->pointCount; ++j)
+			{
+				m->points[j].normalImpulse = batch->points[j].normalImpulse[k];
+				m->points[j].tangentImpulse = batch->points[j].tangentImpulse[k];
+			}
+		}
+	}
+}
+
+void b2SimdContactSolver::InitPositionConstraints()
+{
+	if (m_batches == NULL)
+	{
+		b2ContactSolver::InitPositionConstraints();
+	}
+}
+
+// Lane-wise pose of one side of a batch.
+struct b2PoseW
+{
+	b2FloatW px, py, a, c, s;
+};
+
+static inline b2PoseW b2GatherPose(const b2SolverBody* bodies, const int32* indices)
+{
+	float32 px[b2_simdWidth], py[b2_simdWidth], a[b2_simdWidth], c[b2_simdWidth], s[b2_simdWidth];
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		const b2SolverBody* sb = bodies + indices[i];
+		px[i] = sb->position.x;
+		py[i] = sb->position.y;
+		a[i] = sb->rotation;
+		c[i] = sb->cosine;
+		s[i] = sb->sine;
+	}
+
+	b2PoseW p;
+	p.px = b2LoadW(px);
+	p.py = b2LoadW(py);
+	p.a = b2LoadW(a);
+	p.c = b2LoadW(c);
+	p.s = b2LoadW(s);
+	return p;
+}
+
+// Rotations are written back exactly, as b2Mat22::Set would.
+static inline void b2ScatterPose(b2SolverBody* bodies, const int32* indices, const b2PoseW& p)
+{
+	float32 px[b2_simdWidth], py[b2_simdWidth], a[b2_simdWidth];
+	b2StoreW(px, p.px);
+	b2StoreW(py, p.py);
+	b2StoreW(a, p.a);
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		b2SolverBody* sb = bodies + indices[i];
+		sb->position.x = px[i];
+		sb->position.y = py[i];
+		if (sb->rotation != a[i])
+		{
+			sb->rotation = a[i];
+			sb->cosine = cosf(a[i]);
+			sb->sine = sinf(a[i]);
+		}
+	}
+}
+
+// Turn the cosine/sine pair of p by the small angle da. Position corrections
+// are clamped, so a short series is plenty between two points of a manifold.
+static inline void b2RotateW(b2PoseW& p, b2FloatW da)
+{
+	b2FloatW da2 = b2MulW(da, da);
+	b2FloatW cd = b2SubW(b2SplatW(1.0f), b2MulW(da2, b2SubW(b2SplatW(0.5f), b2MulW(da2, b2SplatW(1.0f / 24.0f)))));
+	b2FloatW sd = b2MulW(da, b2SubW(b2SplatW(1.0f), b2MulW(da2, b2SubW(b2SplatW(1.0f / 6.0f), b2MulW(da2, b2SplatW(1.0f / 120.0f))))));
+	b2FloatW c = b2SubW(b2MulW(p.c, cd), b2MulW(p.s, sd));
+	p.s = b2AddW(b2MulW(p.s, cd), b2MulW(p.c, sd));
+	p.c = c;
+}
+
+bool b2SimdContactSolver::SolvePositionConstraints()
+{
+	if (m_batches == NULL)
+	{
+		return b2ContactSolver::SolvePositionConstraints();
+	}
+
+	LoadPositions();
+
+	const b2FloatW zero = b2ZeroW();
+	const b2FloatW baumgarte = b2SplatW(b2_contactBaumgarte);
+	const b2FloatW slop = b2SplatW(b2_linearSlop);
+	const b2FloatW maxCorrection = b2SplatW(-b2_maxLinearCorrection);
+	b2FloatW minSeparation = zero;
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2SimdContactBatch* batch = m_batches + i;
+		b2PoseW p1 = b2GatherPose(m_solverBodies, batch->body1);
+		b2PoseW p2 = b2GatherPose(m_solverBodies, batch->body2);
+		b2FloatW invMass1 = b2LoadW(batch->invMass1), invI1 = b2LoadW(batch->invI1);
+		b2FloatW invMass2 = b2LoadW(batch->invMass2), invI2 = b2LoadW(batch->invI2);
+		b2FloatW nx = b2LoadW(batch->normalX), ny = b2LoadW(batch->normalY);
+
+		// Solver normal constraints
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2SimdContactPoint* p = batch->points + j;
+			b2FloatW la1x = b2LoadW(p->localAnchor1x), la1y = b2LoadW(p->localAnchor1y);
+			b2FloatW la2x = b2LoadW(p->localAnchor2x), la2y = b2LoadW(p->localAnchor2y);
+
+			b2FloatW r1x = b2SubW(b2MulW(p1.c, la1x), b2MulW(p1.s, la1y));
+			b2FloatW r1y = b2AddW(b2MulW(p1.s, la1x), b2MulW(p1.c, la1y));
+			b2FloatW r2x = b2SubW(b2MulW(p2.c, la2x), b2MulW(p2.s, la2y));
+			b2FloatW r2y = b2AddW(b2MulW(p2.s, la2x), b2MulW(p2.c, la2y));
+
+			b2FloatW dpx = b2SubW(b2AddW(p2.px, r2x), b2AddW(p1.px, r1x));
+			b2FloatW dpy = b2SubW(b2AddW(p2.py, r2y), b2AddW(p1.py, r1y));
+
+			// Approximate the current separation.
+			b2FloatW separation = b2AddW(b2AddW(b2MulW(dpx, nx), b2MulW(dpy, ny)), b2LoadW(p->separation));
+
+			// Track max constraint error.
+			minSeparation = b2MinW(minSeparation, separation);
+
+			// Prevent large corrections and allow slop.
+			b2FloatW C = b2MulW(baumgarte, b2MaxW(maxCorrection, b2MinW(b2AddW(separation, slop), zero)));
+
+			// Compute normal impulse
+			b2FloatW dImpulse = b2MulW(b2SubW(zero, b2LoadW(p->normalMass)), C);
+
+			// b2Clamp the accumulated impulse
+			b2FloatW impulse0 = b2LoadW(p->positionImpulse);
+			b2FloatW impulse = b2MaxW(b2AddW(impulse0, dImpulse), zero);
+			b2StoreW(p->positionImpulse, impulse);
+			dImpulse = b2SubW(impulse, impulse0);
+
+			b2FloatW ix = b2MulW(dImpulse, nx);
+			b2FloatW iy = b2MulW(dImpulse, ny);
+
+			b2FloatW da1 = b2SubW(zero, b2MulW(invI1, b2SubW(b2MulW(r1x, iy), b2MulW(r1y, ix))));
+			p1.px = b2SubW(p1.px, b2MulW(invMass1, ix));
+			p1.py = b2SubW(p1.py, b2MulW(invMass1, iy));
+			p1.a = b2AddW(p1.a, da1);
+
+			b2FloatW da2 = b2MulW(invI2, b2SubW(b2MulW(r2x, iy), b2MulW(r2y, ix)));
+			p2.px = b2AddW(p2.px, b2MulW(invMass2, ix));
+			p2.py = b2AddW(p2.py, b2MulW(invMass2, iy));
+			p2.a = b2AddW(p2.a, da2);
+
+			if (j + 1 < b2_maxManifoldPoints)
+			{
+				b2RotateW(p1, da1);
+				b2RotateW(p2, da2);
+			}
+		}
+
+		b2ScatterPose(m_solverBodies, batch->body1, p1);
+		b2ScatterPose(m_solverBodies, batch->body2, p2);
+	}
+
+	StorePositions();
+
+	float32 separations[b2_simdWidth];
+	b2StoreW(separations, minSeparation);
+	float32 minSep = 0.0f;
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		minSep = b2Min(minSep, separations[i]);
+	}
+
+	return minSep >= -b2_linearSlop;
+}
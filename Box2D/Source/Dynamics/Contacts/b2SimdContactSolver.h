@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2006-2007 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_CONTACT_SOLVER_H
+#define B2_SIMD_CONTACT_SOLVER_H
+
+#include "b2ContactSolver.h"
+#include "../../Common/b2Simd.h"
+
+// Contact solver that packs constraints into SIMD lanes. The constraints
+// are built by b2ContactSolver as usual, then colored so that no two lanes
+// of a batch touch the same dynamic body, and transposed into batches of
+// b2_simdWidth lanes. Body state is gathered into a contiguous solver body
+// array at the start of each solve call and written back at the end, so
+// joints keep working on b2Body directly between calls.
+//
+// The Gauss-Seidel order differs from b2ContactSolver (batch by batch
+// instead of contact by contact) so results are close but not identical.
+// Select it with B2_SOLVER_SIMD at build time. Islands with only a few
+// contacts keep the scalar path, packing them would be mostly padding.
+
+// Lane state of one solver body.
+struct b2SolverBody
+{
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	b2Vec2 position;
+	float32 rotation;
+	float32 cosine, sine;
+	uint32 colors;			// colors already used by this body's constraints
+	b2Body* body;			// NULL for the padding body
+};
+
+// One manifold point across the lanes of a batch.
+struct b2SimdContactPoint
+{
+	float32 r1x[b2_simdWidth], r1y[b2_simdWidth];
+	float32 r2x[b2_simdWidth], r2y[b2_simdWidth];
+	float32 localAnchor1x[b2_simdWidth], localAnchor1y[b2_simdWidth];
+	float32 localAnchor2x[b2_simdWidth], localAnchor2y[b2_simdWidth];
+	float32 normalImpulse[b2_simdWidth];
+	float32 tangentImpulse[b2_simdWidth];
+	float32 positionImpulse[b2_simdWidth];
+	float32 normalMass[b2_simdWidth];
+	float32 tangentMass[b2_simdWidth];
+	float32 separation[b2_simdWidth];
+	float32 velocityBias[b2_simdWidth];
+};
+
+struct b2SimdContactBatch
+{
+	b2SimdContactPoint points[b2_maxManifoldPoints];
+	float32 normalX[b2_simdWidth], normalY[b2_simdWidth];
+	float32 friction[b2_simdWidth];
+	float32 invMass1[b2_simdWidth], invI1[b2_simdWidth];
+	float32 invMass2[b2_simdWidth], invI2[b2_simdWidth];
+	int32 body1[b2_simdWidth], body2[b2_simdWidth];
+	b2ContactConstraint* constraints[b2_simdWidth];
+};
+
+class b2SimdContactSolver : public b2ContactSolver
+{
+public:
+	b2SimdContactSolver(b2Body** bodies, int32 bodyCount, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator);
+	~b2SimdContactSolver();
+
+	void InitVelocityConstraints();
+	void SolveVelocityConstraints();
+	void FinalizeVelocityConstraints();
+
+	void InitPositionConstraints();
+	bool SolvePositionConstraints();
+
+	// Beyond this many colors constraints get a batch of their own. Below
+	// e_minConstraints the island is solved by b2ContactSolver.
+	enum
+	{
+		e_maxColors = 32,
+		e_minConstraints = 2 * b2_simdWidth
+	};
+
+	b2Body** m_bodies;
+	int32 m_bodyCount;
+
+	b2SolverBody* m_solverBodies;
+	int32 m_solverBodyCount;
+
+	b2SimdContactBatch* m_batches;
+	int32 m_batchCount;
+
+private:
+	int32 AssignColor(b2ContactConstraint* c, int32* body1, int32* body2);
+	void LoadVelocities();
+	void StoreVelocities();
+	void LoadPositions();
+	void StorePositions();
+};
+
+#endif
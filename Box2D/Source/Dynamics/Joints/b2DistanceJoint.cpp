@@ -66,10 +66,16 @@ void b2DistanceJoint::InitVelocityConstraints()
 	if (b2World::s_enableWarmStarting)
 	{
 		b2Vec2 P = m_impulse * m_u;
-		m_body1->m_linearVelocity -= m_body1->m_invMass * P;
-		m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
-		m_body2->m_linearVelocity += m_body2->m_invMass * P;
-		m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+		if (!m_body1->IsStatic())
+		{
+			m_body1->m_linearVelocity -= m_body1->m_invMass * P;
+			m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
+		}
+		if (!m_body2->IsStatic())
+		{
+			m_body2->m_linearVelocity += m_body2->m_invMass * P;
+			m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+		}
 	}
 	else
 	{
@@ -92,10 +98,16 @@ void b2DistanceJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	m_impulse += impulse;
 
 	b2Vec2 P = impulse * m_u;
-	m_body1->m_linearVelocity -= m_body1->m_invMass * P;
-	m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
-	m_body2->m_linearVelocity += m_body2->m_invMass * P;
-	m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+	if (!m_body1->IsStatic())
+	{
+		m_body1->m_linearVelocity -= m_body1->m_invMass * P;
+		m_body1->m_angularVelocity -= m_body1->m_invI * b2Cross(r1, P);
+	}
+	if (!m_body2->IsStatic())
+	{
+		m_body2->m_linearVelocity += m_body2->m_invMass * P;
+		m_body2->m_angularVelocity += m_body2->m_invI * b2Cross(r2, P);
+	}
 }
 
 bool b2DistanceJoint::SolvePositionConstraints()
@@ -112,13 +124,18 @@ bool b2DistanceJoint::SolvePositionConstraints()
 	m_u = d;
 	b2Vec2 P = impulse * m_u;
 
-	m_body1->m_position -= m_body1->m_invMass * P;
-	m_body1->m_rotation -= m_body1->m_invI * b2Cross(r1, P);
-	m_body2->m_position += m_body2->m_invMass * P;
-	m_body2->m_rotation += m_body2->m_invI * b2Cross(r2, P);
-
-	m_body1->m_R.Set(m_body1->m_rotation);
-	m_body2->m_R.Set(m_body2->m_rotation);
+	if (!m_body1->IsStatic())
+	{
+		m_body1->m_position -= m_body1->m_invMass * P;
+		m_body1->m_rotation -= m_body1->m_invI * b2Cross(r1, P);
+		m_body1->m_R.Set(m_body1->m_rotation);
+	}
+	if (!m_body2->IsStatic())
+	{
+		m_body2->m_position += m_body2->m_invMass * P;
+		m_body2->m_rotation += m_body2->m_invI * b2Cross(r2, P);
+		m_body2->m_R.Set(m_body2->m_rotation);
+	}
 
 	return b2Abs(C) < b2_linearSlop;
 }
@@ -144,3 +161,13 @@ float32 b2DistanceJoint::GetReactionTorque(float32 invTimeStep) const
 	NOT_USED(invTimeStep);
 	return 0.0f;
 }
+
+void b2DistanceJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_impulse;
+}
+
+void b2DistanceJoint::RestoreState(const b2JointState& state)
+{
+	m_impulse = state.impulses[0];
+}
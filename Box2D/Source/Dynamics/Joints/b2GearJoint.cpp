@@ -143,10 +143,16 @@ void b2GearJoint::InitVelocityConstraints()
 	m_mass = 1.0f / K;
 
 	// Warm starting.
-	b1->m_linearVelocity += b1->m_invMass * m_impulse * m_J.linear1;
-	b1->m_angularVelocity += b1->m_invI * m_impulse * m_J.angular1;
-	b2->m_linearVelocity += b2->m_invMass * m_impulse * m_J.linear2;
-	b2->m_angularVelocity += b2->m_invI * m_impulse * m_J.angular2;
+	if (!b1->IsStatic())
+	{
+		b1->m_linearVelocity += b1->m_invMass * m_impulse * m_J.linear1;
+		b1->m_angularVelocity += b1->m_invI * m_impulse * m_J.angular1;
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_linearVelocity += b2->m_invMass * m_impulse * m_J.linear2;
+		b2->m_angularVelocity += b2->m_invI * m_impulse * m_J.angular2;
+	}
 }
 
 void b2GearJoint::SolveVelocityConstraints(const b2TimeStep& step)
@@ -162,10 +168,16 @@ void b2GearJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	float32 impulse = -m_mass * Cdot;
 	m_impulse += impulse;
 
-	b1->m_linearVelocity += b1->m_invMass * impulse * m_J.linear1;
-	b1->m_angularVelocity += b1->m_invI * impulse * m_J.angular1;
-	b2->m_linearVelocity += b2->m_invMass * impulse * m_J.linear2;
-	b2->m_angularVelocity += b2->m_invI * impulse * m_J.angular2;
+	if (!b1->IsStatic())
+	{
+		b1->m_linearVelocity += b1->m_invMass * impulse * m_J.linear1;
+		b1->m_angularVelocity += b1->m_invI * impulse * m_J.angular1;
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_linearVelocity += b2->m_invMass * impulse * m_J.linear2;
+		b2->m_angularVelocity += b2->m_invI * impulse * m_J.angular2;
+	}
 }
 
 bool b2GearJoint::SolvePositionConstraints()
@@ -198,12 +210,18 @@ bool b2GearJoint::SolvePositionConstraints()
 
 	float32 impulse = -m_mass * C;
 
-	b1->m_position += b1->m_invMass * impulse * m_J.linear1;
-	b1->m_rotation += b1->m_invI * impulse * m_J.angular1;
-	b2->m_position += b2->m_invMass * impulse * m_J.linear2;
-	b2->m_rotation += b2->m_invI * impulse * m_J.angular2;
-	b1->m_R.Set(b1->m_rotation);
-	b2->m_R.Set(b2->m_rotation);
+	if (!b1->IsStatic())
+	{
+		b1->m_position += b1->m_invMass * impulse * m_J.linear1;
+		b1->m_rotation += b1->m_invI * impulse * m_J.angular1;
+		b1->m_R.Set(b1->m_rotation);
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_position += b2->m_invMass * impulse * m_J.linear2;
+		b2->m_rotation += b2->m_invI * impulse * m_J.angular2;
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	return linearError < b2_linearSlop;
 }
@@ -236,3 +254,12 @@ float32 b2GearJoint::GetRatio() const
 	return m_ratio;
 }
 
+void b2GearJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_impulse;
+}
+
+void b2GearJoint::RestoreState(const b2JointState& state)
+{
+	m_impulse = state.impulses[0];
+}
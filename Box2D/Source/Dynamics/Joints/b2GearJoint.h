@@ -69,6 +69,9 @@ public:
 	void SolveVelocityConstraints(const b2TimeStep& step);
 	bool SolvePositionConstraints();
 
+	void SaveState(b2JointState* state) const;
+	void RestoreState(const b2JointState& state);
+
 	b2Body* m_ground1;
 	b2Body* m_ground2;
 
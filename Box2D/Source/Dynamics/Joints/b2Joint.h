@@ -45,6 +45,17 @@ enum b2LimitState
 	e_equalLimits
 };
 
+// Joint state kept by world snapshots: the accumulated impulses used for
+// warm starting and the limit states they were accumulated under. Each
+// joint type uses as many entries as it needs.
+const int32 b2_maxJointImpulses = 5;
+
+struct b2JointState
+{
+	float32 impulses[b2_maxJointImpulses];
+	int32 limitStates[2];
+};
+
 struct b2Jacobian
 {
 	b2Vec2 linear1;
@@ -116,6 +127,9 @@ public:
 	virtual void InitPositionConstraints() {}
 	virtual bool SolvePositionConstraints() = 0;
 
+	virtual void SaveState(b2JointState* state) const = 0;
+	virtual void RestoreState(const b2JointState& state) = 0;
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
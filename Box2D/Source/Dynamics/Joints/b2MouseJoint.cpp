@@ -141,3 +141,14 @@ float32 b2MouseJoint::GetReactionTorque(float32 invTimeStep) const
 	NOT_USED(invTimeStep);
 	return 0.0f;
 }
+
+void b2MouseJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_impulse.x;
+	state->impulses[1] = m_impulse.y;
+}
+
+void b2MouseJoint::RestoreState(const b2JointState& state)
+{
+	m_impulse.Set(state.impulses[0], state.impulses[1]);
+}
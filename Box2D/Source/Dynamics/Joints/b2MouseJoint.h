@@ -62,6 +62,9 @@ public:
 		return true;
 	}
 
+	void SaveState(b2JointState* state) const;
+	void RestoreState(const b2JointState& state);
+
 	b2Vec2 m_localAnchor;
 	b2Vec2 m_target;
 	b2Vec2 m_impulse;
@@ -65,6 +65,7 @@ b2PrismaticJoint::b2PrismaticJoint(const b2PrismaticJointDef* def)
 	m_motorSpeed = def->motorSpeed;
 	m_enableLimit = def->enableLimit;
 	m_enableMotor = def->enableMotor;
+	m_limitState = e_inactiveLimit;
 }
 
 void b2PrismaticJoint::InitVelocityConstraints()
@@ -153,11 +154,16 @@ void b2PrismaticJoint::InitVelocityConstraints()
 		float32 L1 = m_linearImpulse * m_linearJacobian.angular1 - m_angularImpulse + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.angular1;
 		float32 L2 = m_linearImpulse * m_linearJacobian.angular2 + m_angularImpulse + (m_motorImpulse + m_limitImpulse) * m_motorJacobian.angular2;
 
-		b1->m_linearVelocity += invMass1 * P1;
-		b1->m_angularVelocity += invI1 * L1;
-
-		b2->m_linearVelocity += invMass2 * P2;
-		b2->m_angularVelocity += invI2 * L2;
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity += invMass1 * P1;
+			b1->m_angularVelocity += invI1 * L1;
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += invMass2 * P2;
+			b2->m_angularVelocity += invI2 * L2;
+		}
 	}
 	else
 	{
@@ -183,19 +189,30 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	float32 linearImpulse = -m_linearMass * linearCdot;
 	m_linearImpulse += linearImpulse;
 
-	b1->m_linearVelocity += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
-	b1->m_angularVelocity += invI1 * linearImpulse * m_linearJacobian.angular1;
-
-	b2->m_linearVelocity += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
-	b2->m_angularVelocity += invI2 * linearImpulse * m_linearJacobian.angular2;
+	if (!b1->IsStatic())
+	{
+		b1->m_linearVelocity += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
+		b1->m_angularVelocity += invI1 * linearImpulse * m_linearJacobian.angular1;
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_linearVelocity += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
+		b2->m_angularVelocity += invI2 * linearImpulse * m_linearJacobian.angular2;
+	}
 
 	// Solve angular constraint.
 	float32 angularCdot = b2->m_angularVelocity - b1->m_angularVelocity;
 	float32 angularImpulse = -m_angularMass * angularCdot;
 	m_angularImpulse += angularImpulse;
 
-	b1->m_angularVelocity -= invI1 * angularImpulse;
-	b2->m_angularVelocity += invI2 * angularImpulse;
+	if (!b1->IsStatic())
+	{
+		b1->m_angularVelocity -= invI1 * angularImpulse;
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_angularVelocity += invI2 * angularImpulse;
+	}
 
 	// Solve linear motor constraint.
 	if (m_enableMotor && m_limitState != e_equalLimits)
@@ -206,11 +223,16 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		m_motorImpulse = b2Clamp(m_motorImpulse + motorImpulse, -step.dt * m_maxMotorForce, step.dt * m_maxMotorForce);
 		motorImpulse = m_motorImpulse - oldMotorImpulse;
 
-		b1->m_linearVelocity += (invMass1 * motorImpulse) * m_motorJacobian.linear1;
-		b1->m_angularVelocity += invI1 * motorImpulse * m_motorJacobian.angular1;
-
-		b2->m_linearVelocity += (invMass2 * motorImpulse) * m_motorJacobian.linear2;
-		b2->m_angularVelocity += invI2 * motorImpulse * m_motorJacobian.angular2;
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity += (invMass1 * motorImpulse) * m_motorJacobian.linear1;
+			b1->m_angularVelocity += invI1 * motorImpulse * m_motorJacobian.angular1;
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += (invMass2 * motorImpulse) * m_motorJacobian.linear2;
+			b2->m_angularVelocity += invI2 * motorImpulse * m_motorJacobian.angular2;
+		}
 	}
 
 	// Solve linear limit constraint.
@@ -236,11 +258,16 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2TimeStep& step)
 			limitImpulse = m_limitImpulse - oldLimitImpulse;
 		}
 
-		b1->m_linearVelocity += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
-		b1->m_angularVelocity += invI1 * limitImpulse * m_motorJacobian.angular1;
-
-		b2->m_linearVelocity += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
-		b2->m_angularVelocity += invI2 * limitImpulse * m_motorJacobian.angular2;
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
+			b1->m_angularVelocity += invI1 * limitImpulse * m_motorJacobian.angular1;
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
+			b2->m_angularVelocity += invI2 * limitImpulse * m_motorJacobian.angular2;
+		}
 	}
 }
 
@@ -265,12 +292,18 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 	linearC = b2Clamp(linearC, -b2_maxLinearCorrection, b2_maxLinearCorrection);
 	float32 linearImpulse = -m_linearMass * linearC;
 
-	b1->m_position += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
-	b1->m_rotation += invI1 * linearImpulse * m_linearJacobian.angular1;
-	//b1->m_R.Set(b1->m_rotation); // updated by angular constraint
-	b2->m_position += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
-	b2->m_rotation += invI2 * linearImpulse * m_linearJacobian.angular2;
-	//b2->m_R.Set(b2->m_rotation); // updated by angular constraint
+	if (!b1->IsStatic())
+	{
+		b1->m_position += (invMass1 * linearImpulse) * m_linearJacobian.linear1;
+		b1->m_rotation += invI1 * linearImpulse * m_linearJacobian.angular1;
+		//b1->m_R.Set(b1->m_rotation); // updated by angular constraint
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_position += (invMass2 * linearImpulse) * m_linearJacobian.linear2;
+		b2->m_rotation += invI2 * linearImpulse * m_linearJacobian.angular2;
+		//b2->m_R.Set(b2->m_rotation); // updated by angular constraint
+	}
 
 	float32 positionError = b2Abs(linearC);
 
@@ -280,10 +313,16 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 	angularC = b2Clamp(angularC, -b2_maxAngularCorrection, b2_maxAngularCorrection);
 	float32 angularImpulse = -m_angularMass * angularC;
 
-	b1->m_rotation -= b1->m_invI * angularImpulse;
-	b1->m_R.Set(b1->m_rotation);
-	b2->m_rotation += b2->m_invI * angularImpulse;
-	b2->m_R.Set(b2->m_rotation);
+	if (!b1->IsStatic())
+	{
+		b1->m_rotation -= b1->m_invI * angularImpulse;
+		b1->m_R.Set(b1->m_rotation);
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_rotation += b2->m_invI * angularImpulse;
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	float32 angularError = b2Abs(angularC);
 
@@ -332,12 +371,18 @@ bool b2PrismaticJoint::SolvePositionConstraints()
 			limitImpulse = m_limitPositionImpulse - oldLimitImpulse;
 		}
 
-		b1->m_position += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
-		b1->m_rotation += invI1 * limitImpulse * m_motorJacobian.angular1;
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_position += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
-		b2->m_rotation += invI2 * limitImpulse * m_motorJacobian.angular2;
-		b2->m_R.Set(b2->m_rotation);
+		if (!b1->IsStatic())
+		{
+			b1->m_position += (invMass1 * limitImpulse) * m_motorJacobian.linear1;
+			b1->m_rotation += invI1 * limitImpulse * m_motorJacobian.angular1;
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_position += (invMass2 * limitImpulse) * m_motorJacobian.linear2;
+			b2->m_rotation += invI2 * limitImpulse * m_motorJacobian.angular2;
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
@@ -419,3 +464,23 @@ float32 b2PrismaticJoint::GetReactionTorque(float32 invTimeStep) const
 {
 	return invTimeStep * m_angularImpulse;
 }
+
+void b2PrismaticJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_linearImpulse;
+	state->impulses[1] = m_angularImpulse;
+	state->impulses[2] = m_motorImpulse;
+	state->impulses[3] = m_limitImpulse;
+	state->impulses[4] = m_limitPositionImpulse;
+	state->limitStates[0] = m_limitState;
+}
+
+void b2PrismaticJoint::RestoreState(const b2JointState& state)
+{
+	m_linearImpulse = state.impulses[0];
+	m_angularImpulse = state.impulses[1];
+	m_motorImpulse = state.impulses[2];
+	m_limitImpulse = state.impulses[3];
+	m_limitPositionImpulse = state.impulses[4];
+	m_limitState = (b2LimitState)state.limitStates[0];
+}
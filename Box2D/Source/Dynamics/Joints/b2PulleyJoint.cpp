@@ -144,10 +144,16 @@ void b2PulleyJoint::InitVelocityConstraints()
 	// Warm starting.
 	b2Vec2 P1 = (-m_pulleyImpulse - m_limitImpulse1) * m_u1;
 	b2Vec2 P2 = (-m_ratio * m_pulleyImpulse - m_limitImpulse2) * m_u2;
-	b1->m_linearVelocity += b1->m_invMass * P1;
-	b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-	b2->m_linearVelocity += b2->m_invMass * P2;
-	b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+	if (!b1->IsStatic())
+	{
+		b1->m_linearVelocity += b1->m_invMass * P1;
+		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_linearVelocity += b2->m_invMass * P2;
+		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+	}
 }
 
 void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
@@ -170,10 +176,16 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity += b1->m_invMass * P1;
+			b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += b2->m_invMass * P2;
+			b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		}
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
@@ -185,8 +197,11 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		m_limitImpulse1 = b2Max(0.0f, m_limitImpulse1 + impulse);
 		impulse = m_limitImpulse1 - oldLimitImpulse;
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity += b1->m_invMass * P1;
+			b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		}
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
@@ -198,8 +213,11 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		m_limitImpulse2 = b2Max(0.0f, m_limitImpulse2 + impulse);
 		impulse = m_limitImpulse2 - oldLimitImpulse;
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += b2->m_invMass * P2;
+			b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		}
 	}
 }
 
@@ -253,13 +271,18 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
 
-		b1->m_position += b1->m_invMass * P1;
-		b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
-		b2->m_position += b2->m_invMass * P2;
-		b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
-
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_R.Set(b2->m_rotation);
+		if (!b1->IsStatic())
+		{
+			b1->m_position += b1->m_invMass * P1;
+			b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_position += b2->m_invMass * P2;
+			b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
@@ -288,9 +311,12 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		impulse = m_limitPositionImpulse1 - oldLimitPositionImpulse;
 
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_position += b1->m_invMass * P1;
-		b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
-		b1->m_R.Set(b1->m_rotation);
+		if (!b1->IsStatic())
+		{
+			b1->m_position += b1->m_invMass * P1;
+			b1->m_rotation += b1->m_invI * b2Cross(r1, P1);
+			b1->m_R.Set(b1->m_rotation);
+		}
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
@@ -319,9 +345,12 @@ bool b2PulleyJoint::SolvePositionConstraints()
 		impulse = m_limitPositionImpulse2 - oldLimitPositionImpulse;
 
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_position += b2->m_invMass * P2;
-		b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
-		b2->m_R.Set(b2->m_rotation);
+		if (!b2->IsStatic())
+		{
+			b2->m_position += b2->m_invMass * P2;
+			b2->m_rotation += b2->m_invI * b2Cross(r2, P2);
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return linearError < b2_linearSlop;
@@ -381,3 +410,24 @@ float32 b2PulleyJoint::GetRatio() const
 	return m_ratio;
 }
 
+void b2PulleyJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_pulleyImpulse;
+	state->impulses[1] = m_limitImpulse1;
+	state->impulses[2] = m_limitImpulse2;
+	state->impulses[3] = m_limitPositionImpulse1;
+	state->impulses[4] = m_limitPositionImpulse2;
+	state->limitStates[0] = m_limitState1;
+	state->limitStates[1] = m_limitState2;
+}
+
+void b2PulleyJoint::RestoreState(const b2JointState& state)
+{
+	m_pulleyImpulse = state.impulses[0];
+	m_limitImpulse1 = state.impulses[1];
+	m_limitImpulse2 = state.impulses[2];
+	m_limitPositionImpulse1 = state.impulses[3];
+	m_limitPositionImpulse2 = state.impulses[4];
+	m_limitState1 = (b2LimitState)state.limitStates[0];
+	m_limitState2 = (b2LimitState)state.limitStates[1];
+}
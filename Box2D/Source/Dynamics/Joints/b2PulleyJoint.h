@@ -80,6 +80,9 @@ public:
 	void SolveVelocityConstraints(const b2TimeStep& step);
 	bool SolvePositionConstraints();
 
+	void SaveState(b2JointState* state) const;
+	void RestoreState(const b2JointState& state);
+
 	b2Body* m_ground;
 	b2Vec2 m_groundAnchor1;
 	b2Vec2 m_groundAnchor2;
@@ -54,6 +54,7 @@ b2RevoluteJoint::b2RevoluteJoint(const b2RevoluteJointDef* def)
 	m_motorSpeed = def->motorSpeed;
 	m_enableLimit = def->enableLimit;
 	m_enableMotor = def->enableMotor;
+	m_limitState = e_inactiveLimit;
 }
 
 void b2RevoluteJoint::InitVelocityConstraints()
@@ -129,11 +130,16 @@ void b2RevoluteJoint::InitVelocityConstraints()
 
 	if (b2World::s_enableWarmStarting)
 	{
-		b1->m_linearVelocity -= invMass1 * m_ptpImpulse;
-		b1->m_angularVelocity -= invI1 * (b2Cross(r1, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
-
-		b2->m_linearVelocity += invMass2 * m_ptpImpulse;
-		b2->m_angularVelocity += invI2 * (b2Cross(r2, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		if (!b1->IsStatic())
+		{
+			b1->m_linearVelocity -= invMass1 * m_ptpImpulse;
+			b1->m_angularVelocity -= invI1 * (b2Cross(r1, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_linearVelocity += invMass2 * m_ptpImpulse;
+			b2->m_angularVelocity += invI2 * (b2Cross(r2, m_ptpImpulse) + m_motorImpulse + m_limitImpulse);
+		}
 	}
 	else
 	{
@@ -158,11 +164,16 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	b2Vec2 ptpImpulse = -b2Mul(m_ptpMass, ptpCdot);
 	m_ptpImpulse += ptpImpulse;
 
-	b1->m_linearVelocity -= b1->m_invMass * ptpImpulse;
-	b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, ptpImpulse);
-
-	b2->m_linearVelocity += b2->m_invMass * ptpImpulse;
-	b2->m_angularVelocity += b2->m_invI * b2Cross(r2, ptpImpulse);
+	if (!b1->IsStatic())
+	{
+		b1->m_linearVelocity -= b1->m_invMass * ptpImpulse;
+		b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, ptpImpulse);
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_linearVelocity += b2->m_invMass * ptpImpulse;
+		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, ptpImpulse);
+	}
 
 	if (m_enableMotor && m_limitState != e_equalLimits)
 	{
@@ -171,8 +182,14 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		float32 oldMotorImpulse = m_motorImpulse;
 		m_motorImpulse = b2Clamp(m_motorImpulse + motorImpulse, -step.dt * m_maxMotorTorque, step.dt * m_maxMotorTorque);
 		motorImpulse = m_motorImpulse - oldMotorImpulse;
-		b1->m_angularVelocity -= b1->m_invI * motorImpulse;
-		b2->m_angularVelocity += b2->m_invI * motorImpulse;
+		if (!b1->IsStatic())
+		{
+			b1->m_angularVelocity -= b1->m_invI * motorImpulse;
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_angularVelocity += b2->m_invI * motorImpulse;
+		}
 	}
 
 	if (m_enableLimit && m_limitState != e_inactiveLimit)
@@ -197,8 +214,14 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 			limitImpulse = m_limitImpulse - oldLimitImpulse;
 		}
 
-		b1->m_angularVelocity -= b1->m_invI * limitImpulse;
-		b2->m_angularVelocity += b2->m_invI * limitImpulse;
+		if (!b1->IsStatic())
+		{
+			b1->m_angularVelocity -= b1->m_invI * limitImpulse;
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_angularVelocity += b2->m_invI * limitImpulse;
+		}
 	}
 }
 
@@ -241,13 +264,18 @@ bool b2RevoluteJoint::SolvePositionConstraints()
 	b2Mat22 K = K1 + K2 + K3;
 	b2Vec2 impulse = K.Solve(-ptpC);
 
-	b1->m_position -= b1->m_invMass * impulse;
-	b1->m_rotation -= b1->m_invI * b2Cross(r1, impulse);
-	b1->m_R.Set(b1->m_rotation);
-
-	b2->m_position += b2->m_invMass * impulse;
-	b2->m_rotation += b2->m_invI * b2Cross(r2, impulse);
-	b2->m_R.Set(b2->m_rotation);
+	if (!b1->IsStatic())
+	{
+		b1->m_position -= b1->m_invMass * impulse;
+		b1->m_rotation -= b1->m_invI * b2Cross(r1, impulse);
+		b1->m_R.Set(b1->m_rotation);
+	}
+	if (!b2->IsStatic())
+	{
+		b2->m_position += b2->m_invMass * impulse;
+		b2->m_rotation += b2->m_invI * b2Cross(r2, impulse);
+		b2->m_R.Set(b2->m_rotation);
+	}
 
 	// Handle limits.
 	float32 angularError = 0.0f;
@@ -289,10 +317,16 @@ bool b2RevoluteJoint::SolvePositionConstraints()
 			limitImpulse = m_limitPositionImpulse - oldLimitImpulse;
 		}
 
-		b1->m_rotation -= b1->m_invI * limitImpulse;
-		b1->m_R.Set(b1->m_rotation);
-		b2->m_rotation += b2->m_invI * limitImpulse;
-		b2->m_R.Set(b2->m_rotation);
+		if (!b1->IsStatic())
+		{
+			b1->m_rotation -= b1->m_invI * limitImpulse;
+			b1->m_R.Set(b1->m_rotation);
+		}
+		if (!b2->IsStatic())
+		{
+			b2->m_rotation += b2->m_invI * limitImpulse;
+			b2->m_R.Set(b2->m_rotation);
+		}
 	}
 
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
@@ -348,3 +382,22 @@ float32 b2RevoluteJoint::GetReactionTorque(float32 invTimeStep) const
 {
 	return invTimeStep * m_limitImpulse;
 }
+
+void b2RevoluteJoint::SaveState(b2JointState* state) const
+{
+	state->impulses[0] = m_ptpImpulse.x;
+	state->impulses[1] = m_ptpImpulse.y;
+	state->impulses[2] = m_motorImpulse;
+	state->impulses[3] = m_limitImpulse;
+	state->impulses[4] = m_limitPositionImpulse;
+	state->limitStates[0] = m_limitState;
+}
+
+void b2RevoluteJoint::RestoreState(const b2JointState& state)
+{
+	m_ptpImpulse.Set(state.impulses[0], state.impulses[1]);
+	m_motorImpulse = state.impulses[2];
+	m_limitImpulse = state.impulses[3];
+	m_limitPositionImpulse = state.impulses[4];
+	m_limitState = (b2LimitState)state.limitStates[0];
+}
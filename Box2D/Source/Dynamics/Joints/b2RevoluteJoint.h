@@ -69,6 +69,9 @@ public:
 
 	bool SolvePositionConstraints();
 
+	void SaveState(b2JointState* state) const;
+	void RestoreState(const b2JointState& state);
+
 	b2Vec2 m_localAnchor1;
 	b2Vec2 m_localAnchor2;
 	b2Vec2 m_ptpImpulse;
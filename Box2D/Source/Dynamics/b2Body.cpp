@@ -121,6 +121,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_sleepTime = 0.0f;
+	m_islandIndex = 0;
 	if (bd->allowSleep)
 	{
 		m_flags |= e_allowSleepFlag;
@@ -214,9 +215,17 @@ void b2Body::QuickSyncShapes()
 
 void b2Body::Freeze()
 {
+	if ((m_flags & e_frozenFlag) == 0)
+	{
+		m_world->QueueFrozen(this);
+	}
+
 	m_flags |= e_frozenFlag;
 	m_linearVelocity.SetZero();
 	m_angularVelocity = 0.0f;
+
+	// A frozen body no longer seeds islands.
+	m_world->m_islands.m_valid = false;
 	for (b2Shape* s = m_shapeList; s; s = s->m_next)
 	{
 		s->DestroyProxy();
@@ -223,6 +223,8 @@ public:
 
 	float32 m_sleepTime;
 
+	int32 m_islandIndex;	// solver slot, set by b2SimdContactSolver and snapshots
+
 	void* m_userData;
 };
 
@@ -135,6 +135,11 @@ void b2ContactManager::DestroyContact(b2Contact* c)
 		b2Body* body1 = c->m_shape1->m_body;
 		b2Body* body2 = c->m_shape2->m_body;
 
+		if (m_world->m_contactListener)
+		{
+			m_world->m_contactListener->EndContact(c);
+		}
+
 		// Wake up touching bodies.
 		body1->WakeUp();
 		body2->WakeUp();
@@ -181,6 +186,8 @@ void b2ContactManager::DestroyContact(b2Contact* c)
 	// Call the factory.
 	b2Contact::Destroy(c, &m_world->m_blockAllocator);
 	--m_world->m_contactCount;
+
+	m_world->m_islands.m_valid = false;
 }
 
 // Destroy any contacts marked for deferred destruction.
@@ -310,6 +317,13 @@ void b2ContactManager::Collide(const b2TimeStep& step)
 				c->m_node2.next->prev = &c->m_node2;
 			}
 			body2->m_contactList = &c->m_node2;
+
+			m_world->m_islands.m_valid = false;
+
+			if (m_world->m_contactListener)
+			{
+				m_world->m_contactListener->BeginContact(c);
+			}
 		}
 		else if (oldCount > 0 && newCount == 0)
 		{
@@ -354,6 +368,13 @@ void b2ContactManager::Collide(const b2TimeStep& step)
 
 			c->m_node2.prev = NULL;
 			c->m_node2.next = NULL;
+
+			m_world->m_islands.m_valid = false;
+
+			if (m_world->m_contactListener)
+			{
+				m_world->m_contactListener->EndContact(c);
+			}
 		}
 	}
 }
\ No newline at end of file
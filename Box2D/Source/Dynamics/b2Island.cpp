@@ -21,6 +21,7 @@
 #include "b2World.h"
 #include "Contacts/b2Contact.h"
 #include "Contacts/b2ContactSolver.h"
+#include "Contacts/b2SimdContactSolver.h"
 #include "Joints/b2Joint.h"
 #include "../Common/b2StackAllocator.h"
 
@@ -119,10 +120,34 @@ b2Island::b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacit
 	m_allocator = allocator;
 
 	m_positionIterationCount = 0;
+	m_ownsStorage = true;
+}
+
+b2Island::b2Island(b2IslandList* list, int32 index, b2StackAllocator* allocator)
+{
+	const b2IslandRange& range = list->m_islands[index];
+
+	m_bodies = list->m_bodies + range.bodyStart;
+	m_contacts = list->m_contacts + range.contactStart;
+	m_joints = list->m_joints + range.jointStart;
+
+	m_bodyCount = m_bodyCapacity = range.bodyCount;
+	m_contactCount = m_contactCapacity = range.contactCount;
+	m_jointCount = m_jointCapacity = range.jointCount;
+
+	m_allocator = allocator;
+
+	m_positionIterationCount = 0;
+	m_ownsStorage = false;
 }
 
 b2Island::~b2Island()
 {
+	if (m_ownsStorage == false)
+	{
+		return;
+	}
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
@@ -159,7 +184,11 @@ void b2Island::Integrate(const b2TimeStep& step, const b2Vec2& gravity)
 		b->m_angularVelocity *= b->m_angularDamping;
 	}
 
+#if defined(B2_SOLVER_SIMD)
+	b2SimdContactSolver contactSolver(m_bodies, m_bodyCount, m_contacts, m_contactCount, m_allocator);
+#else
 	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_allocator);
+#endif
 
 	// Initialize velocity constraints.
 	contactSolver.InitVelocityConstraints();
@@ -199,6 +228,17 @@ void b2Island::Integrate(const b2TimeStep& step, const b2Vec2& gravity)
 		b->m_position += step.dt * b->m_linearVelocity;
 		b->m_rotation += step.dt * b->m_angularVelocity;
 		b->m_R.Set(b->m_rotation);
+	}
+}
+
+void b2Island::SynchronizeShapes()
+{
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+
+		if (b->IsStatic())
+			continue;
 
 		// Update shapes (for broad-phase).
 		b->SynchronizeShapes();
@@ -207,7 +247,11 @@ void b2Island::Integrate(const b2TimeStep& step, const b2Vec2& gravity)
 
 void b2Island::SolvePositionConstraints(const b2TimeStep& step)
 {
+#if defined(B2_SOLVER_SIMD)
+	b2SimdContactSolver contactSolver(m_bodies, m_bodyCount, m_contacts, m_contactCount, m_allocator);
+#else
 	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_allocator);
+#endif
 
 	// Initialize position constraints
 	contactSolver.InitPositionConstraints();
@@ -281,3 +325,100 @@ void b2Island::UpdateSleep(const b2TimeStep& step)
 		}
 	}
 }
+
+b2IslandList::b2IslandList()
+{
+	m_islands = NULL;
+	m_tasks = NULL;
+	m_bodies = NULL;
+	m_contacts = NULL;
+	m_joints = NULL;
+
+	m_bodyCapacity = 0;
+	m_contactCapacity = 0;
+	m_jointCapacity = 0;
+
+	Clear();
+}
+
+b2IslandList::~b2IslandList()
+{
+	b2Free(m_joints);
+	b2Free(m_contacts);
+	b2Free(m_bodies);
+	b2Free(m_tasks);
+	b2Free(m_islands);
+}
+
+void b2IslandList::Reserve(int32 bodyCount, int32 contactCount, int32 jointCount)
+{
+	// Every island holds at least one body.
+	if (bodyCount > m_bodyCapacity)
+	{
+		m_bodyCapacity = b2Max(bodyCount, 2 * m_bodyCapacity);
+		b2Free(m_bodies);
+		b2Free(m_tasks);
+		b2Free(m_islands);
+		m_bodies = (b2Body**)b2Alloc(m_bodyCapacity * sizeof(b2Body*));
+		m_islands = (b2IslandRange*)b2Alloc(m_bodyCapacity * sizeof(b2IslandRange));
+		m_tasks = (int32*)b2Alloc((m_bodyCapacity + 1) * sizeof(int32));
+	}
+
+	if (contactCount > m_contactCapacity)
+	{
+		m_contactCapacity = b2Max(contactCount, 2 * m_contactCapacity);
+		b2Free(m_contacts);
+		m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+	}
+
+	if (jointCount > m_jointCapacity)
+	{
+		m_jointCapacity = b2Max(jointCount, 2 * m_jointCapacity);
+		b2Free(m_joints);
+		m_joints = (b2Joint**)b2Alloc(m_jointCapacity * sizeof(b2Joint*));
+	}
+}
+
+void b2IslandList::Clear()
+{
+	m_islandCount = 0;
+	m_taskCount = 0;
+	m_bodyCount = 0;
+	m_contactCount = 0;
+	m_jointCount = 0;
+	m_valid = false;
+}
+
+void b2IslandList::Begin()
+{
+	b2Assert(m_islandCount < m_bodyCapacity);
+	b2IslandRange* range = m_islands + m_islandCount++;
+	range->bodyStart = m_bodyCount;
+	range->bodyCount = 0;
+	range->contactStart = m_contactCount;
+	range->contactCount = 0;
+	range->jointStart = m_jointCount;
+	range->jointCount = 0;
+}
+
+void b2IslandList::Partition(int32 minCost)
+{
+	m_taskCount = 0;
+	int32 cost = minCost;
+	for (int32 i = 0; i < m_islandCount; ++i)
+	{
+		if (cost >= minCost)
+		{
+			m_tasks[m_taskCount++] = i;
+			cost = 0;
+		}
+
+		const b2IslandRange& range = m_islands[i];
+		cost += range.bodyCount + range.contactCount + range.jointCount;
+	}
+
+	if (m_taskCount > 0)
+	{
+		m_tasks[m_taskCount] = m_islandCount;
+	}
+}
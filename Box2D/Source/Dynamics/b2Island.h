@@ -25,17 +25,25 @@ class b2StackAllocator;
 class b2Contact;
 class b2Body;
 class b2Joint;
+class b2IslandList;
 struct b2TimeStep;
 
 class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity, b2StackAllocator* allocator);
+
+	// View one island of a b2IslandList. The arrays are not copied or freed.
+	b2Island(b2IslandList* list, int32 index, b2StackAllocator* allocator);
+
 	~b2Island();
 
 	void Clear();
 
+	// Integrate leaves the broad-phase alone so islands can be integrated
+	// concurrently. Call SynchronizeShapes afterwards, one island at a time.
 	void Integrate(const b2TimeStep& step, const b2Vec2& gravity);
+	void SynchronizeShapes();
 	void SolvePositionConstraints(const b2TimeStep& step);
 	void UpdateSleep(const b2TimeStep& step);
 
@@ -72,6 +80,81 @@ public:
 	int32 m_jointCapacity;
 
 	int32 m_positionIterationCount;
+
+	bool m_ownsStorage;
+};
+
+// A range of a b2IslandList holding one island.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+};
+
+// The island partition of one time step. b2World builds it once before the
+// velocity phase and solves the position phase from the same list, unless
+// the constraint graph changed in between (contacts linked or unlinked,
+// bodies destroyed or frozen, joints added or removed), which clears m_valid.
+// The arrays grow as needed and are kept between steps.
+class b2IslandList
+{
+public:
+	b2IslandList();
+	~b2IslandList();
+
+	// Make room for the worst case: every body, contact and joint awake.
+	// bodyCount must include the repeats of static bodies.
+	void Reserve(int32 bodyCount, int32 contactCount, int32 jointCount);
+	void Clear();
+
+	// Start a new island; the following Add calls go into it.
+	void Begin();
+
+	// Group consecutive islands into tasks of at least minCost bodies,
+	// contacts and joints, so that tiny islands are not scheduled alone.
+	// Task i covers islands [m_tasks[i], m_tasks[i + 1]).
+	void Partition(int32 minCost);
+
+	void Add(b2Body* body)
+	{
+		b2Assert(m_bodyCount < m_bodyCapacity);
+		m_bodies[m_bodyCount++] = body;
+		++m_islands[m_islandCount - 1].bodyCount;
+	}
+
+	void Add(b2Contact* contact)
+	{
+		b2Assert(m_contactCount < m_contactCapacity);
+		m_contacts[m_contactCount++] = contact;
+		++m_islands[m_islandCount - 1].contactCount;
+	}
+
+	void Add(b2Joint* joint)
+	{
+		b2Assert(m_jointCount < m_jointCapacity);
+		m_joints[m_jointCount++] = joint;
+		++m_islands[m_islandCount - 1].jointCount;
+	}
+
+	b2IslandRange* m_islands;
+	b2Body** m_bodies;
+	b2Contact** m_contacts;
+	b2Joint** m_joints;
+
+	int32 m_islandCount;
+	int32 m_bodyCount;
+	int32 m_contactCount;
+	int32 m_jointCount;
+
+	int32* m_tasks;
+	int32 m_taskCount;
+
+	int32 m_bodyCapacity;
+	int32 m_contactCapacity;
+	int32 m_jointCapacity;
+
+	bool m_valid;
 };
 
 #endif
@@ -24,15 +24,24 @@
 #include "Contacts/b2Conservative.h"
 #include "../Collision/b2Collision.h"
 #include "../Collision/b2Shape.h"
+#include "../Collision/b2BroadPhase.h"
+#include "../Collision/b2TreeBroadPhase.h"
+#include "../Common/b2Timer.h"
 #include <new>
+#include <algorithm>
 
 int32 b2World::s_enablePositionCorrection = 1;
 int32 b2World::s_enableWarmStarting = 1;
 
-b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
+b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, b2BroadPhaseType broadPhase)
 {
 	m_listener = NULL;
 	m_filter = &b2_defaultFilter;
+	m_contactListener = NULL;
+
+	m_frozenBodies = NULL;
+	m_frozenCount = 0;
+	m_frozenCapacity = 0;
 
 	m_bodyList = NULL;
 	m_contactList = NULL;
@@ -48,9 +57,30 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 	m_gravity = gravity;
 
+	m_profile.step = 0.0f;
+	m_profile.islands = 0.0f;
+	m_profile.integrate = 0.0f;
+	m_profile.broadphase = 0.0f;
+	m_profile.collide = 0.0f;
+	m_profile.positions = 0.0f;
+	m_profile.islandCount = 0;
+	m_profile.islandRebuilds = 0;
+
+	m_threadPool = NULL;
+	m_workerAllocators = NULL;
+	m_workerCount = 1;
+
 	m_contactManager.m_world = this;
-	void* mem = b2Alloc(sizeof(b2BroadPhase));
-	m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	if (broadPhase == b2_dynamicTree)
+	{
+		void* mem = b2Alloc(sizeof(b2TreeBroadPhase));
+		m_broadPhase = new (mem) b2TreeBroadPhase(worldAABB, &m_contactManager);
+	}
+	else
+	{
+		void* mem = b2Alloc(sizeof(b2BroadPhase));
+		m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	}
 
 	b2BodyDef bd;
 	m_groundBody = CreateBody(&bd);
@@ -58,9 +88,73 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 b2World::~b2World()
 {
+	SetWorkerCount(1);
 	DestroyBody(m_groundBody);
-	m_broadPhase->~b2BroadPhase();
+	m_broadPhase->~b2BroadPhaseInterface();
 	b2Free(m_broadPhase);
+	b2Free(m_frozenBodies);
+}
+
+void b2World::SetWorkerCount(int32 count)
+{
+	count = b2Clamp(count, 1, b2_maxWorkers);
+	if (count == m_workerCount)
+	{
+		return;
+	}
+
+	if (m_threadPool)
+	{
+		m_threadPool->~b2ThreadPool();
+		b2Free(m_threadPool);
+		m_threadPool = NULL;
+
+		for (int32 i = 0; i < m_workerCount - 1; ++i)
+		{
+			m_workerAllocators[i].~b2StackAllocator();
+		}
+		b2Free(m_workerAllocators);
+		m_workerAllocators = NULL;
+	}
+
+	m_workerCount = count;
+	if (count == 1)
+	{
+		return;
+	}
+
+	void* mem = b2Alloc(sizeof(b2ThreadPool));
+	m_threadPool = new (mem) b2ThreadPool(count);
+
+	m_workerAllocators = (b2StackAllocator*)b2Alloc((count - 1) * sizeof(b2StackAllocator));
+	for (int32 i = 0; i < count - 1; ++i)
+	{
+		new (m_workerAllocators + i) b2StackAllocator;
+	}
+}
+
+b2StackAllocator* b2World::GetWorkerAllocator(int32 worker)
+{
+	if (worker == 0)
+	{
+		return &m_stackAllocator;
+	}
+
+	return m_workerAllocators + worker - 1;
+}
+
+void b2World::SolveIslands(b2TaskCallback* callback, void* context)
+{
+	if (m_threadPool)
+	{
+		m_threadPool->Run(callback, context, m_islands.m_taskCount);
+		return;
+	}
+
+	for (int32 i = 0; i < m_islands.m_taskCount; ++i)
+	{
+		callback(context, i, 0);
+	}
 }
 
 void b2World::SetListener(b2WorldListener* listener)
@@ -68,6 +162,27 @@ void b2World::SetListener(b2WorldListener* listener)
 	m_listener = listener;
 }
 
+void b2World::SetContactListener(b2ContactListener* listener)
+{
+	m_contactListener = listener;
+}
+
+void b2World::QueueFrozen(b2Body* body)
+{
+	if (m_frozenCount == m_frozenCapacity)
+	{
+		m_frozenCapacity = b2Max(2 * m_frozenCapacity, 16);
+		b2Body** bodies = (b2Body**)b2Alloc(m_frozenCapacity * sizeof(b2Body*));
+		if (m_frozenBodies)
+		{
+			memcpy(bodies, m_frozenBodies, m_frozenCount * sizeof(b2Body*));
+			b2Free(m_frozenBodies);
+		}
+		m_frozenBodies = bodies;
+	}
+	m_frozenBodies[m_frozenCount++] = body;
+}
+
 void b2World::SetFilter(b2CollisionFilter* filter)
 {
 	m_filter = filter;
@@ -87,6 +202,8 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	m_islands.m_valid = false;
+
 	return b;
 }
 
@@ -114,10 +231,22 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	// It is freed before the step would report it.
+	for (int32 i = 0; i < m_frozenCount; ++i)
+	{
+		if (m_frozenBodies[i] == b)
+		{
+			m_frozenBodies[i] = m_frozenBodies[--m_frozenCount];
+			break;
+		}
+	}
+
 	b->m_flags |= b2Body::e_destroyFlag;
 	b2Assert(m_bodyCount > 0);
 	--m_bodyCount;
 
+	m_islands.m_valid = false;
+
 	// Add to the deferred destruction list.
 	b->m_prev = NULL;
 	b->m_next = m_bodyDestroyList;
@@ -162,6 +291,486 @@ void b2World::CleanBodyList()
 	m_contactManager.m_destroyImmediate = false;
 }
 
+void b2World::Reset()
+{
+	// Chain shapes own heap memory, so shape destructors must run. Clear
+	// the proxy ids first: the broad-phase is reset in one go below.
+	// Bodies, contacts and joints own nothing outside the block allocator.
+	b2Body* lists[2] = { m_bodyList, m_bodyDestroyList };
+	for (int32 i = 0; i < 2; ++i)
+	{
+		for (b2Body* b = lists[i]; b; b = b->m_next)
+		{
+			b2Shape* s = b->m_shapeList;
+			while (s)
+			{
+				b2Shape* s0 = s;
+				s = s->m_next;
+
+				s0->m_proxyId = b2_nullProxy;
+				s0->~b2Shape();
+			}
+		}
+	}
+
+	m_broadPhase->Reset();
+	m_blockAllocator.Reset();
+
+	m_bodyList = NULL;
+	m_contactList = NULL;
+	m_jointList = NULL;
+	m_bodyDestroyList = NULL;
+
+	m_bodyCount = 0;
+	m_contactCount = 0;
+	m_jointCount = 0;
+	m_frozenCount = 0;
+
+	m_islands.m_valid = false;
+
+	b2BodyDef bd;
+	m_groundBody = CreateBody(&bd);
+}
+
+// Snapshot layout: a header, then one record per body, per shape, per
+// joint and per contact in list order, then the order of each body's
+// touching contacts. Shapes are named by body index and position in the
+// body's shape list so that a snapshot fits any world with the same layout.
+const int32 b2_snapshotMagic = 0x32503242;	// "B2P2"
+
+struct b2SnapshotHeader
+{
+	int32 magic;
+	int32 size;
+	int32 bodyCount;
+	int32 shapeCount;
+	int32 jointCount;
+	int32 contactCount;
+	int32 touchingCount;
+};
+
+struct b2BodySnapshot
+{
+	b2Vec2 position;
+	float32 rotation;
+	b2Vec2 position0;
+	float32 rotation0;
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	float32 sleepTime;
+	uint32 flags;
+};
+
+// Shapes keep their own copy of the body transform, which lags the body
+// once position correction has run.
+struct b2ShapeSnapshot
+{
+	b2Vec2 position;
+	b2Mat22 R;
+};
+
+struct b2JointSnapshot
+{
+	int32 type;
+	int32 body1;
+	int32 body2;
+	b2JointState state;
+};
+
+struct b2ContactSnapshot
+{
+	bool operator < (const b2ContactSnapshot& other) const
+	{
+		return shape1 < other.shape1 || (shape1 == other.shape1 && shape2 < other.shape2);
+	}
+
+	int32 shape1;
+	int32 shape2;
+	int32 size;		// bytes of contact state that follow
+};
+
+// Used to find the live contact for a snapshot record and the record of a
+// live contact.
+struct b2ContactRef
+{
+	bool operator < (const b2ContactRef& other) const
+	{
+		return key < other.key;
+	}
+
+	b2ContactSnapshot key;
+	b2Contact* contact;
+	int32 index;
+};
+
+static bool b2ComparePointers(const b2ContactRef& a, const b2ContactRef& b)
+{
+	return a.contact < b.contact;
+}
+
+static int32 b2ShapeKey(const b2Shape* shape)
+{
+	int32 local = 0;
+	for (const b2Shape* s = shape->m_body->m_shapeList; s != shape; s = s->m_next)
+	{
+		++local;
+	}
+	return shape->m_body->m_islandIndex * b2_maxShapesPerBody + local;
+}
+
+static void b2AppendContact(b2Contact** list, b2Contact** tail, b2Contact* c)
+{
+	c->m_prev = *tail;
+	c->m_next = NULL;
+	if (*tail)
+	{
+		(*tail)->m_next = c;
+	}
+	else
+	{
+		*list = c;
+	}
+	*tail = c;
+}
+
+static int32 b2TouchingCount(const b2Body* b)
+{
+	int32 count = 0;
+	for (const b2ContactNode* cn = b->m_contactList; cn; cn = cn->next)
+	{
+		++count;
+	}
+	return count;
+}
+
+void b2World::IndexBodies()
+{
+	int32 index = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_islandIndex = index++;
+	}
+}
+
+int32 b2World::GetSnapshotSize()
+{
+	int32 size = sizeof(b2SnapshotHeader);
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		size += sizeof(b2BodySnapshot) + b->m_shapeCount * sizeof(b2ShapeSnapshot);
+		size += sizeof(int32) * (1 + b2TouchingCount(b));
+	}
+
+	size += m_jointCount * sizeof(b2JointSnapshot);
+
+	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	{
+		size += sizeof(b2ContactSnapshot) + c->GetStateSize();
+	}
+
+	return size;
+}
+
+int32 b2World::SaveSnapshot(void* buffer, int32 size)
+{
+	// Deferred destruction would leave bodies and contacts in the lists
+	// that the next step removes.
+	m_contactManager.CleanContactList();
+	CleanBodyList();
+
+	int32 needed = GetSnapshotSize();
+	if (size < needed)
+	{
+		return 0;
+	}
+
+	IndexBodies();
+
+	int8* p = (int8*)buffer;
+	b2SnapshotHeader* header = (b2SnapshotHeader*)p;
+	header->magic = b2_snapshotMagic;
+	header->size = needed;
+	header->bodyCount = m_bodyCount;
+	header->shapeCount = 0;
+	header->jointCount = m_jointCount;
+	header->contactCount = m_contactCount;
+	header->touchingCount = 0;
+	p += sizeof(b2SnapshotHeader);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodySnapshot* bs = (b2BodySnapshot*)p;
+		bs->position = b->m_position;
+		bs->rotation = b->m_rotation;
+		bs->position0 = b->m_position0;
+		bs->rotation0 = b->m_rotation0;
+		bs->linearVelocity = b->m_linearVelocity;
+		bs->angularVelocity = b->m_angularVelocity;
+		bs->sleepTime = b->m_sleepTime;
+		bs->flags = b->m_flags;
+		p += sizeof(b2BodySnapshot);
+
+		for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
+		{
+			b2ShapeSnapshot* ss = (b2ShapeSnapshot*)p;
+			ss->position = s->m_position;
+			ss->R = s->m_R;
+			p += sizeof(b2ShapeSnapshot);
+		}
+		header->shapeCount += b->m_shapeCount;
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2JointSnapshot* js = (b2JointSnapshot*)p;
+		js->type = j->m_type;
+		js->body1 = j->m_body1->m_islandIndex;
+		js->body2 = j->m_body2->m_islandIndex;
+		j->SaveState(&js->state);
+		p += sizeof(b2JointSnapshot);
+	}
+
+	b2ContactRef* refs = (b2ContactRef*)b2Alloc(b2Max(m_contactCount, 1) * sizeof(b2ContactRef));
+	int32 index = 0;
+	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	{
+		b2ContactSnapshot* cs = (b2ContactSnapshot*)p;
+		cs->shape1 = b2ShapeKey(c->m_shape1);
+		cs->shape2 = b2ShapeKey(c->m_shape2);
+		cs->size = c->GetStateSize();
+		p += sizeof(b2ContactSnapshot);
+
+		c->SaveState(p);
+		p += cs->size;
+
+		refs[index].contact = c;
+		refs[index].index = index;
+		++index;
+	}
+
+	// The island search walks the body contact lists, so their order is
+	// part of the state.
+	std::sort(refs, refs + m_contactCount, b2ComparePointers);
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		int32* count = (int32*)p;
+		*count = 0;
+		p += sizeof(int32);
+
+		for (b2ContactNode* cn = b->m_contactList; cn; cn = cn->next)
+		{
+			b2ContactRef ref;
+			ref.contact = cn->contact;
+			b2ContactRef* found = std::lower_bound(refs, refs + m_contactCount, ref, b2ComparePointers);
+			b2Assert(found < refs + m_contactCount && found->contact == cn->contact);
+
+			*(int32*)p = found->index;
+			p += sizeof(int32);
+			++(*count);
+		}
+		header->touchingCount += *count;
+	}
+	b2Free(refs);
+
+	b2Assert(p == (int8*)buffer + needed);
+	return needed;
+}
+
+bool b2World::RestoreSnapshot(const void* buffer, int32 size)
+{
+	m_contactManager.CleanContactList();
+	CleanBodyList();
+
+	// Check that the snapshot fits before touching anything.
+	const int8* p = (const int8*)buffer;
+	const b2SnapshotHeader* header = (const b2SnapshotHeader*)p;
+	if (size < (int32)sizeof(b2SnapshotHeader) || header->magic != b2_snapshotMagic ||
+		header->size > size || header->bodyCount != m_bodyCount ||
+		header->jointCount != m_jointCount)
+	{
+		return false;
+	}
+	p += sizeof(b2SnapshotHeader);
+
+	const int8* bodies = p;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		const b2BodySnapshot* bs = (const b2BodySnapshot*)p;
+		if ((bs->flags & (b2Body::e_staticFlag | b2Body::e_frozenFlag)) !=
+			(b->m_flags & (b2Body::e_staticFlag | b2Body::e_frozenFlag)))
+		{
+			return false;
+		}
+		p += sizeof(b2BodySnapshot) + b->m_shapeCount * sizeof(b2ShapeSnapshot);
+	}
+
+	if (p - bodies != header->bodyCount * (int32)sizeof(b2BodySnapshot) + header->shapeCount * (int32)sizeof(b2ShapeSnapshot))
+	{
+		return false;
+	}
+
+	IndexBodies();
+
+	const b2JointSnapshot* joints = (const b2JointSnapshot*)p;
+	int32 jointIndex = 0;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		const b2JointSnapshot* js = joints + jointIndex++;
+		if (js->type != j->m_type || js->body1 != j->m_body1->m_islandIndex ||
+			js->body2 != j->m_body2->m_islandIndex)
+		{
+			return false;
+		}
+	}
+	p += m_jointCount * sizeof(b2JointSnapshot);
+
+	// Move the bodies and let the broad-phase bring the contact set up to
+	// date. Contacts that go away here wake their bodies, so the flags are
+	// set afterwards.
+	p = bodies;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		const b2BodySnapshot* bs = (const b2BodySnapshot*)p;
+		b->m_position = bs->position;
+		b->m_rotation = bs->rotation;
+		b->m_R.Set(b->m_rotation);
+		b->m_position0 = bs->position0;
+		b->m_rotation0 = bs->rotation0;
+		b->m_linearVelocity = bs->linearVelocity;
+		b->m_angularVelocity = bs->angularVelocity;
+		b->m_force.SetZero();
+		b->m_torque = 0.0f;
+		b->m_sleepTime = bs->sleepTime;
+		b->SynchronizeShapes();
+		p += sizeof(b2BodySnapshot);
+
+		for (b2Shape* s = b->m_shapeList; s; s = s->m_next)
+		{
+			const b2ShapeSnapshot* ss = (const b2ShapeSnapshot*)p;
+			s->m_position = ss->position;
+			s->m_R = ss->R;
+			p += sizeof(b2ShapeSnapshot);
+		}
+	}
+
+	m_broadPhase->Commit();
+	m_contactManager.CleanContactList();
+
+	const uint32 savedFlags = b2Body::e_sleepFlag | b2Body::e_allowSleepFlag | b2Body::e_fastFlag;
+	p = bodies;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		const b2BodySnapshot* bs = (const b2BodySnapshot*)p;
+		b->m_flags = (b->m_flags & ~savedFlags) | (bs->flags & savedFlags);
+		b->m_contactList = NULL;
+		p += sizeof(b2BodySnapshot) + b->m_shapeCount * sizeof(b2ShapeSnapshot);
+	}
+
+	jointIndex = 0;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->RestoreState(joints[jointIndex++].state);
+	}
+	p += m_jointCount * sizeof(b2JointSnapshot);
+
+	// Match the snapshot contacts with the live ones by shape pair. Live
+	// contacts the snapshot does not know start out with no manifolds.
+	b2ContactRef* refs = (b2ContactRef*)b2Alloc(b2Max(m_contactCount, 1) * sizeof(b2ContactRef));
+	b2Contact** order = (b2Contact**)b2Alloc(b2Max(header->contactCount, 1) * sizeof(b2Contact*));
+	int32 liveCount = 0;
+	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	{
+		refs[liveCount].key.shape1 = b2ShapeKey(c->m_shape1);
+		refs[liveCount].key.shape2 = b2ShapeKey(c->m_shape2);
+		refs[liveCount].contact = c;
+		refs[liveCount].index = -1;
+		++liveCount;
+
+		c->m_manifoldCount = 0;
+	}
+	std::sort(refs, refs + liveCount);
+
+	for (int32 i = 0; i < header->contactCount; ++i)
+	{
+		const b2ContactSnapshot* cs = (const b2ContactSnapshot*)p;
+		p += sizeof(b2ContactSnapshot);
+
+		b2ContactRef ref;
+		ref.key = *cs;
+		b2ContactRef* found = std::lower_bound(refs, refs + liveCount, ref);
+		if (found < refs + liveCount && found->key.shape1 == cs->shape1 && found->key.shape2 == cs->shape2)
+		{
+			found->contact->RestoreState(p);
+			found->index = i;
+			order[i] = found->contact;
+		}
+		else
+		{
+			order[i] = NULL;
+		}
+		p += cs->size;
+	}
+
+	// Rebuild the world contact list in snapshot order, followed by the
+	// contacts that are new since.
+	b2Contact* tail = NULL;
+	m_contactList = NULL;
+	for (int32 i = 0; i < header->contactCount; ++i)
+	{
+		if (order[i])
+		{
+			b2AppendContact(&m_contactList, &tail, order[i]);
+		}
+	}
+
+	for (int32 i = 0; i < liveCount; ++i)
+	{
+		if (refs[i].index == -1)
+		{
+			b2AppendContact(&m_contactList, &tail, refs[i].contact);
+		}
+	}
+
+	// Relink the touching contacts into the body lists in their old order.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		int32 count = *(const int32*)p;
+		p += sizeof(int32);
+
+		b2ContactNode* last = NULL;
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Contact* c = order[((const int32*)p)[i]];
+			if (c == NULL || c->m_manifoldCount == 0)
+			{
+				continue;
+			}
+
+			b2ContactNode* cn = c->m_shape1->m_body == b ? &c->m_node1 : &c->m_node2;
+			cn->contact = c;
+			cn->other = c->m_shape1->m_body == b ? c->m_shape2->m_body : c->m_shape1->m_body;
+			cn->prev = last;
+			cn->next = NULL;
+			if (last)
+			{
+				last->next = cn;
+			}
+			else
+			{
+				b->m_contactList = cn;
+			}
+			last = cn;
+		}
+		p += count * sizeof(int32);
+	}
+
+	b2Free(order);
+	b2Free(refs);
+
+	m_islands.m_valid = false;
+	return true;
+}
+
 b2Joint* b2World::CreateJoint(const b2JointDef* def)
 {
 	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
@@ -176,6 +785,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	m_jointList = j;
 	++m_jointCount;
 
+	m_islands.m_valid = false;
+
 	// Connect to the bodies
 	j->m_node1.joint = j;
 	j->m_node1.other = j->m_body2;
@@ -276,6 +887,8 @@ void b2World::DestroyJoint(b2Joint* j)
 	b2Assert(m_jointCount > 0);
 	--m_jointCount;
 
+	m_islands.m_valid = false;
+
 	// If the joint prevents collisions, then reset collision filtering.
 	if (collideConnected == false)
 	{
@@ -288,10 +901,14 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 }
 
-void b2World::Integrate(const b2TimeStep& step)
+// Partition the awake bodies into islands. The result is kept in m_islands
+// so the position phase can reuse it.
+void b2World::BuildIslands()
 {
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator);
+	m_islands.Clear();
+	// Static bodies are repeated in every island that touches them, once per
+	// contact or joint at most.
+	m_islands.Reserve(m_bodyCount + m_contactCount + m_jointCount, m_contactCount, m_jointCount);
 
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
@@ -307,7 +924,7 @@ void b2World::Integrate(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
-	// Build and simulate all awake islands.
+	// Build all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
 	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
@@ -317,8 +934,8 @@ void b2World::Integrate(const b2TimeStep& step)
 			continue;
 		}
 
-		// Reset island and stack.
-		island.Clear();
+		// Start a new island and reset the stack.
+		m_islands.Begin();
 		int32 stackCount = 0;
 		stack[stackCount++] = seed;
 		seed->m_flags |= b2Body::e_islandFlag;
@@ -328,7 +945,7 @@ void b2World::Integrate(const b2TimeStep& step)
 		{
 			// Grab the next body off the stack and add it to the island.
 			b2Body* b = stack[--stackCount];
-			island.Add(b);
+			m_islands.Add(b);
 
 			// Make sure the body is awake.
 			b->m_flags &= ~b2Body::e_sleepFlag;
@@ -348,7 +965,7 @@ void b2World::Integrate(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(cn->contact);
+				m_islands.Add(cn->contact);
 				cn->contact->m_flags |= b2Contact::e_islandFlag;
 
 				b2Body* other = cn->other;
@@ -370,7 +987,7 @@ void b2World::Integrate(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(jn->joint);
+				m_islands.Add(jn->joint);
 				jn->joint->m_islandFlag = true;
 
 				b2Body* other = jn->other;
@@ -385,13 +1002,11 @@ void b2World::Integrate(const b2TimeStep& step)
 			}
 		}
 
-		island.Integrate(step, m_gravity);
-
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		// Allow static bodies to participate in other islands.
+		const b2IslandRange& range = m_islands.m_islands[m_islands.m_islandCount - 1];
+		for (int32 i = 0; i < range.bodyCount; ++i)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
+			b2Body* b = m_islands.m_bodies[range.bodyStart + i];
 			if (b->m_flags & b2Body::e_staticFlag)
 			{
 				b->m_flags &= ~b2Body::e_islandFlag;
@@ -400,6 +1015,70 @@ void b2World::Integrate(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+
+	m_islands.Partition(b2_minIslandTaskCost);
+	m_islands.m_valid = true;
+}
+
+// Island tasks for SolveIslands. An island only writes to its own dynamic
+// bodies, contacts and joints. Static bodies are shared between islands, so
+// the island, contact and joint solvers only read them and never store back,
+// and islands can be solved in any order, on any thread, with the same
+// result. Anything touching the broad-phase, sleep flags or the listener is
+// left to the serial passes that follow, which go in island order.
+struct b2IslandTaskContext
+{
+	b2World* world;
+	const b2TimeStep* step;
+	int32 positionIterations[b2_maxWorkers];
+};
+
+static void b2IntegrateIslands(void* context, int32 task, int32 worker)
+{
+	b2IslandTaskContext* c = (b2IslandTaskContext*)context;
+	b2World* world = c->world;
+	b2IslandList* list = &world->m_islands;
+
+	for (int32 i = list->m_tasks[task]; i < list->m_tasks[task + 1]; ++i)
+	{
+		b2Island island(list, i, world->GetWorkerAllocator(worker));
+		island.Integrate(*c->step, world->m_gravity);
+	}
+}
+
+static void b2SolveIslandPositions(void* context, int32 task, int32 worker)
+{
+	b2IslandTaskContext* c = (b2IslandTaskContext*)context;
+	b2World* world = c->world;
+	b2IslandList* list = &world->m_islands;
+
+	for (int32 i = list->m_tasks[task]; i < list->m_tasks[task + 1]; ++i)
+	{
+		b2Island island(list, i, world->GetWorkerAllocator(worker));
+		island.SolvePositionConstraints(*c->step);
+		c->positionIterations[worker] = b2Max(c->positionIterations[worker], island.m_positionIterationCount);
+	}
+}
+
+void b2World::Integrate(const b2TimeStep& step)
+{
+	b2Timer timer;
+	BuildIslands();
+	m_profile.islands = timer.GetMilliseconds();
+	m_profile.islandCount = m_islands.m_islandCount;
+
+	timer.Reset();
+	b2IslandTaskContext context;
+	context.world = this;
+	context.step = &step;
+	SolveIslands(b2IntegrateIslands, &context);
+
+	for (int32 i = 0; i < m_islands.m_islandCount; ++i)
+	{
+		b2Island island(&m_islands, i, &m_stackAllocator);
+		island.SynchronizeShapes();
+	}
+	m_profile.integrate = timer.GetMilliseconds();
 }
 
 void b2World::SolvePositionConstraints(const b2TimeStep& step)
@@ -410,139 +1089,53 @@ void b2World::SolvePositionConstraints(const b2TimeStep& step)
 		return;
 	}
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator);
-
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	// The islands from the velocity phase are still good unless the
+	// contact graph changed during collision.
+	if (m_islands.m_valid == false)
 	{
-		b->m_flags &= ~b2Body::e_islandFlag;
+		b2Timer timer;
+		BuildIslands();
+		m_profile.islands += timer.GetMilliseconds();
+		m_profile.islandRebuilds = 1;
 	}
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+
+	b2IslandTaskContext context;
+	context.world = this;
+	context.step = &step;
+	for (int32 i = 0; i < m_workerCount; ++i)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		context.positionIterations[i] = 0;
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	SolveIslands(b2SolveIslandPositions, &context);
+
+	for (int32 i = 0; i < m_workerCount; ++i)
 	{
-		j->m_islandFlag = false;
+		m_positionIterationCount = b2Max(m_positionIterationCount, context.positionIterations[i]);
 	}
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	for (int32 i = 0; i < m_islands.m_islandCount; ++i)
 	{
-		if (seed->m_flags & (b2Body::e_staticFlag | b2Body::e_islandFlag | b2Body::e_sleepFlag | b2Body::e_frozenFlag))
-		{
-			continue;
-		}
-
-		// Reset island and stack.
-		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
+		b2Island island(&m_islands, i, &m_stackAllocator);
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		// A static body shared with an earlier island may have been put to
+		// sleep by it. Wake it as a fresh search would have.
+		for (int32 j = 0; j < island.m_bodyCount; ++j)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			island.Add(b);
-
-			// Make sure the body is awake.
-			b->m_flags &= ~b2Body::e_sleepFlag;
-
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->m_flags & b2Body::e_staticFlag)
-			{
-				continue;
-			}
-
-			// Search all contacts connected to this body.
-			for (b2ContactNode* cn = b->m_contactList; cn; cn = cn->next)
-			{
-				if (cn->contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
-
-				island.Add(cn->contact);
-				cn->contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = cn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
-
-			// Search all joints connect to this body.
-			for (b2JointNode* jn = b->m_jointList; jn; jn = jn->next)
-			{
-				if (jn->joint->m_islandFlag == true)
-				{
-					continue;
-				}
-
-				island.Add(jn->joint);
-				jn->joint->m_islandFlag = true;
-
-				b2Body* other = jn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+			island.m_bodies[j]->m_flags &= ~b2Body::e_sleepFlag;
 		}
 
-		island.SolvePositionConstraints(step);
-
-		m_positionIterationCount = b2Max(m_positionIterationCount, island.m_positionIterationCount);
-
 		if (m_allowSleep)
 		{
 			island.UpdateSleep(step);
 		}
-
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
-		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->m_flags & b2Body::e_staticFlag)
-			{
-				b->m_flags &= ~b2Body::e_islandFlag;
-			}
-
-			// Handle newly frozen bodies.
-			if (b->IsFrozen() && m_listener)
-			{
-				b2BoundaryResponse response = m_listener->NotifyBoundaryViolated(b);
-				if (response == b2_destroyBody)
-				{
-					DestroyBody(b);
-					b = NULL;
-					island.m_bodies[i] = NULL;
-				}
-			}
-		}
 	}
-
-	m_stackAllocator.Free(stack);
 }
 
 void b2World::Step(float32 dt, int32 iterations)
 {
+	b2Timer stepTimer;
+	m_profile.islandRebuilds = 0;
+
 	b2TimeStep step;
 	step.dt = dt;
 	step.iterations	= iterations;
@@ -564,36 +1157,36 @@ void b2World::Step(float32 dt, int32 iterations)
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	Integrate(step);
 
+	b2Timer timer;
 	m_broadPhase->Commit();
+	m_profile.broadphase = timer.GetMilliseconds();
 
-	// Handle newly frozen bodies.
-	if (m_listener)
+	// Handle newly frozen bodies. DestroyBody edits the queue, so take
+	// from the back.
+	while (m_frozenCount > 0)
 	{
-		b2Body* b = m_bodyList;
-		while (b)
+		b2Body* b = m_frozenBodies[--m_frozenCount];
+		if (m_listener && m_listener->NotifyBoundaryViolated(b) == b2_destroyBody)
 		{
-			b2Body* b0 = b;
-			b = b->m_next;
-			if (b0->IsFrozen())
-			{
-				b2BoundaryResponse response = m_listener->NotifyBoundaryViolated(b0);
-				if (response == b2_destroyBody)
-				{
-					DestroyBody(b0);
-					b0 = NULL;
-				}
-			}
+			DestroyBody(b);
 		}
 	}
 
 	// Update contacts.
+	timer.Reset();
 	m_contactManager.Collide(step);
+	m_profile.collide = timer.GetMilliseconds();
 
 	// Project positions onto the constraint manifold.
+	timer.Reset();
 	if (s_enablePositionCorrection)
 	{
 		SolvePositionConstraints(step);
 	}
+	m_islands.m_valid = false;
+	m_profile.positions = timer.GetMilliseconds();
+
+	m_profile.step = stepTimer.GetMilliseconds();
 }
 
 int32 b2World::Query(const b2AABB& aabb, b2Shape** shapes, int32 maxCount)
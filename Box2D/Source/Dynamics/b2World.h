@@ -24,6 +24,9 @@
 #include "../Common/b2StackAllocator.h"
 #include "b2ContactManager.h"
 #include "b2WorldCallbacks.h"
+#include "b2Island.h"
+#include "../Common/b2ThreadPool.h"
+#include "../Collision/b2BroadPhaseInterface.h"
 
 struct b2AABB;
 struct b2BodyDef;
@@ -32,7 +35,8 @@ class b2Body;
 class b2Joint;
 class b2Shape;
 class b2Contact;
-class b2BroadPhase;
+class b2BroadPhaseInterface;
+class b2ThreadPool;
 
 struct b2TimeStep
 {
@@ -41,10 +45,26 @@ struct b2TimeStep
 	int32 iterations;
 };
 
+// Time spent in each phase of the last call to b2World::Step, in milliseconds.
+struct b2Profile
+{
+	float32 step;
+	float32 islands;		// building the island partition
+	float32 integrate;		// velocity constraints and position integration
+	float32 broadphase;		// broad-phase commit
+	float32 collide;		// TOI and narrow phase
+	float32 positions;		// position constraints and sleep, including any island rebuild
+	int32 islandCount;
+	int32 islandRebuilds;	// 1 if the position phase could not reuse the islands
+};
+
 class b2World
 {
 public:
-	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep);
+	// broadPhase picks the broad-phase implementation: sweep and prune is
+	// limited to b2_maxProxies shapes, the dynamic tree is not.
+	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep,
+			b2BroadPhaseType broadPhase = b2_sweepAndPrune);
 	~b2World();
 
 	// Register a world listener to receive important events that can
@@ -55,6 +75,10 @@ public:
 	// Otherwise the default filter is used (b2CollisionFilter).
 	void SetFilter(b2CollisionFilter* filter);
 
+	// Register a contact listener to be told when shapes start and stop
+	// touching.
+	void SetContactListener(b2ContactListener* listener);
+
 	// Create and destroy rigid bodies. Destruction is deferred until the
 	// the next call to Step. This is done so that bodies may be destroyed
 	// while you iterate through the contact list.
@@ -64,6 +88,25 @@ public:
 	b2Joint* CreateJoint(const b2JointDef* def);
 	void DestroyJoint(b2Joint* joint);
 
+	// Destroy every body, shape, joint and contact at once and empty the
+	// broad-phase, keeping gravity, listeners and allocated memory. Much
+	// cheaper than destroying bodies one by one. Nothing is reported to the
+	// listener and all body and joint pointers become invalid; the ground
+	// body is recreated.
+	void Reset();
+
+	// Snapshots capture the moving state of the world: body transforms,
+	// velocities and sleep state, joint impulses and contact manifolds.
+	// Restoring one puts the bodies back in place without recreating
+	// anything, so the world must hold the same bodies, shapes and joints
+	// (in the same order) as when it was saved. A world built from the same
+	// definitions will do. SaveSnapshot returns the number of bytes written,
+	// or 0 if size is too small. RestoreSnapshot returns false and leaves
+	// the world untouched if the snapshot does not fit the world.
+	int32 GetSnapshotSize();
+	int32 SaveSnapshot(void* buffer, int32 size);
+	bool RestoreSnapshot(const void* buffer, int32 size);
+
 	// The world provides a single ground body with no collision shapes. You
 	// can use this to simplify the creation of joints.
 	b2Body* GetGroundBody();
@@ -80,17 +123,36 @@ public:
 	b2Joint* GetJointList();
 	b2Contact* GetContactList();
 
+	// Per-phase timing of the last step.
+	const b2Profile& GetProfile() const;
+
+	// Solve islands on this many threads, the calling thread included. The
+	// default of 1 starts no threads. Results do not depend on the count.
+	void SetWorkerCount(int32 count);
+	int32 GetWorkerCount() const;
+
 	//--------------- Internals Below -------------------
 
 	void CleanBodyList();
 
+	// Bodies frozen since the last step, reported to the listener by Step.
+	void QueueFrozen(b2Body* body);
+
+	// Number the bodies in m_islandIndex for snapshot records.
+	void IndexBodies();
+
+	void BuildIslands();
 	void Integrate(const b2TimeStep& step);
 	void SolvePositionConstraints(const b2TimeStep& step);
 
+	// Run callback over the island tasks of m_islands.
+	void SolveIslands(b2TaskCallback* callback, void* context);
+	b2StackAllocator* GetWorkerAllocator(int32 worker);
+
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
-	b2BroadPhase* m_broadPhase;
+	b2BroadPhaseInterface* m_broadPhase;
 	b2ContactManager m_contactManager;
 
 	b2Body* m_bodyList;
@@ -111,9 +173,22 @@ public:
 
 	b2WorldListener* m_listener;
 	b2CollisionFilter* m_filter;
+	b2ContactListener* m_contactListener;
+
+	b2Body** m_frozenBodies;
+	int32 m_frozenCount;
+	int32 m_frozenCapacity;
 
 	int32 m_positionIterationCount;
 
+	b2IslandList m_islands;
+	b2Profile m_profile;
+
+	// Worker 0 is the calling thread and uses m_stackAllocator.
+	b2ThreadPool* m_threadPool;
+	b2StackAllocator* m_workerAllocators;
+	int32 m_workerCount;
+
 	static int32 s_enablePositionCorrection;
 	static int32 s_enableWarmStarting;
 };
@@ -138,4 +213,14 @@ inline b2Contact* b2World::GetContactList()
 	return m_contactList;
 }
 
+inline const b2Profile& b2World::GetProfile() const
+{
+	return m_profile;
+}
+
+inline int32 b2World::GetWorkerCount() const
+{
+	return m_workerCount;
+}
+
 #endif
@@ -24,6 +24,7 @@
 class b2Body;
 class b2Joint;
 class b2Shape;
+class b2Contact;
 
 enum b2BoundaryResponse
 {
@@ -49,6 +50,7 @@ public:
 	// This is called when a body's shape passes outside of the world boundary. If you
 	// override this and pass back e_destroyBody, you must nullify your copies of the
 	// body pointer.
+	// Each body is reported once, during the step after it froze.
 	virtual b2BoundaryResponse NotifyBoundaryViolated(b2Body* body)
 	{
 	  //NOT_USED(body);
@@ -56,6 +58,22 @@ public:
 	}
 };
 
+// Implement this class to hear when shapes start and stop touching, rather
+// than walking the contact list after every step. Provide it to b2World via
+// b2World::SetContactListener().
+// DO NOT modify the Box2D world inside these callbacks.
+class b2ContactListener
+{
+public:
+	virtual ~b2ContactListener() {}
+
+	// Called from b2World::Step when a contact gets its first manifold.
+	virtual void BeginContact(b2Contact* contact) = 0;
+
+	// Called when a touching contact loses its manifolds or is destroyed.
+	virtual void EndContact(b2Contact* /*contact*/) {}
+};
+
 // Implement this class to provide collision filtering. In other words, you can implement
 // this class if you want finer control over contact creation.
 class b2CollisionFilter
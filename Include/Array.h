@@ -18,45 +18,68 @@
 * http://rock88dev.blogspot.com
 */
 
+
 #ifndef ARRAY_H
 #define ARRAY_H
 
 #include <string.h>
+#include <stdlib.h>
+#include <new>
+#include <utility>
+#include <type_traits>
 #include "Common.h"
 
+// Room for N elements inside the array itself, used until it outgrows
+// them. With N of 0 there is none and it takes no space.
+template <typename T, int N>
+struct ArrayInline
+{
+  T* inlineData() { return reinterpret_cast<T*>(m_inline); }
+  alignas(T) char m_inline[N * sizeof(T)];
+};
+
 template <typename T>
-class Array
+struct ArrayInline<T, 0>
+{
+  T* inlineData() { return NULL; }
+};
+
+// Growable array. Elements are constructed, moved and destroyed properly,
+// so any type will do; trivially copyable ones are moved with memcpy and
+// grown with realloc as before.
+template <typename T, int N=0>
+class Array : private ArrayInline<T, N>
 {
  public:
 
-  Array( int cap=0 ) : m_data(NULL), m_size(0), m_capacity(0)
+  Array( int cap=0 ) : m_data(this->inlineData()), m_size(0), m_capacity(N)
   {
-    capacity( cap );
+    reserve( cap );
   }
   
- Array( int n, const T* d ) : m_data(NULL), m_size(0), m_capacity(0)
+  Array( int n, const T* d ) : m_data(this->inlineData()), m_size(0), m_capacity(N)
   {
-    if ( n ) {
-      capacity( n );
-      memcpy( m_data, d, n * sizeof(T) );
-      m_size = n;
-    }
+    reserve( n );
+    copyConstruct( m_data, d, n );
+    m_size = n;
   }
 
-  Array( const Array& other ) : m_data(NULL), m_size(0), m_capacity(0)
+  Array( const Array& other ) : m_data(this->inlineData()), m_size(0), m_capacity(N)
   {
-    if ( other.size() ) {
-      capacity( other.size() );
-      memcpy( m_data, other.m_data, other.size() * sizeof(T) );
-      m_size = other.size();
-    }
+    reserve( other.size() );
+    copyConstruct( m_data, other.m_data, other.size() );
+    m_size = other.size();
+  }
+
+  Array( Array&& other ) : m_data(this->inlineData()), m_size(0), m_capacity(N)
+  {
+    take( other );
   }
 
   ~Array()
   {
-    if ( m_data ) {
-      free( m_data );
-    }
+    destroy( 0, m_size );
+    release();
   }
 
   int size() const
@@ -66,6 +89,7 @@ class Array
 
   void empty()
   {
+    destroy( 0, m_size );
     m_size = 0;
   }
 
@@ -81,10 +105,29 @@ class Array
     return m_data[i];
   }
 
+  // t may be an element of this array.
   void append( const T& t )
   {
-    ensureCapacity( m_size + 1 );
-    m_data[ m_size++ ] = t;
+    if ( m_size == m_capacity ) {
+      T copy( t );
+      ensureCapacity( m_size + 1 );
+      new ( m_data + m_size ) T( std::move(copy) );
+    } else {
+      new ( m_data + m_size ) T( t );
+    }
+    m_size++;
+  }
+
+  void append( T&& t )
+  {
+    if ( m_size == m_capacity ) {
+      T moved( std::move(t) );
+      ensureCapacity( m_size + 1 );
+      new ( m_data + m_size ) T( std::move(moved) );
+    } else {
+      new ( m_data + m_size ) T( std::move(t) );
+    }
+    m_size++;
   }
 
   void insert( int i, const T& t )
@@ -93,11 +136,13 @@ class Array
       append( t );
     } else {
       ASSERT( i < m_size );
+      T copy( t );
       ensureCapacity( m_size + 1 );
-      for ( int j=m_size-1; j>=i; j-- ) {
-	m_data[j+1] = m_data[j];
+      new ( m_data + m_size ) T( std::move(m_data[m_size-1]) );
+      for ( int j=m_size-2; j>=i; j-- ) {
+	m_data[j+1] = std::move( m_data[j] );
       }
-      m_data[ i ] = t;
+      m_data[ i ] = std::move( copy );
       m_size++;
     }
   }
@@ -105,26 +150,66 @@ class Array
   void erase( int i )
   {
     ASSERT( i < m_size );
-    if ( i < m_size-1 ) {
-      memcpy( m_data+i, m_data+i+1, (m_size-i-1)*sizeof(T) );
+    for ( int j=i; j<m_size-1; j++ ) {
+      m_data[j] = std::move( m_data[j+1] );
     }
+    destroy( m_size-1, m_size );
     m_size--;
   }
 
   void trim( int i )
   {
     ASSERT( i < m_size );
+    destroy( m_size-i, m_size );
     m_size -= i;
   }
 
+  // Grow or shrink to n elements. New elements are default initialised,
+  // which leaves plain data uninitialised.
+  void resize( int n )
+  {
+    if ( n > m_size ) {
+      ensureCapacity( n );
+      for ( int i=m_size; i<n; i++ ) {
+	new ( m_data + i ) T;
+      }
+    } else {
+      destroy( n, m_size );
+    }
+    m_size = n;
+  }
+
+  // Room for at least c elements without reallocating.
+  void reserve( int c )
+  {
+    if ( c > m_capacity ) {
+      capacity( c );
+    }
+  }
+
+  // Set the room to exactly c elements, or the inline room if that is
+  // enough. Ignored if fewer than are held.
   void capacity( int c )
   {
-    if ( c >= m_size ) {
-      if ( m_capacity ) {
-	m_data = (T*)realloc( m_data, c * sizeof(T) );
-      } else {
-	m_data = (T*)malloc( c * sizeof(T) );
+    if ( c < m_size ) {
+      return;
+    }
+    T* inl = this->inlineData();
+    if ( N > 0 && c <= N ) {
+      if ( m_data != inl ) {
+	relocate( inl, m_data, m_size );
+	free( m_data );
+	m_data = inl;
       }
+      m_capacity = N;
+    } else if ( m_data != inl && std::is_trivially_copyable<T>::value ) {
+      m_data = (T*)realloc( m_data, c * sizeof(T) );
+      m_capacity = c;
+    } else {
+      T* data = (T*)malloc( c * sizeof(T) );
+      relocate( data, m_data, m_size );
+      release();
+      m_data = data;
       m_capacity = c;
     }
   }
@@ -149,17 +234,29 @@ class Array
     return at(i);
   }
 
-  Array<T>& operator=(const Array<T>& other) 
+  Array<T,N>& operator=(const Array<T,N>& other) 
   {
-    m_size = 0;
-    if ( other.size() ) {
-      capacity( other.size() );
-      memcpy( m_data, other.m_data, other.size() * sizeof(T) );
+    if ( this != &other ) {
+      empty();
+      reserve( other.size() );
+      copyConstruct( m_data, other.m_data, other.size() );
       m_size = other.size();
     }
     return *this;
   }
 
+  Array<T,N>& operator=(Array<T,N>&& other) 
+  {
+    if ( this != &other ) {
+      empty();
+      release();
+      m_data = this->inlineData();
+      m_capacity = N;
+      take( other );
+    }
+    return *this;
+  }
+
  private:
   void ensureCapacity( int c ) 
   {
@@ -172,6 +269,61 @@ class Array
     }
   }
 
+  // Steal a heap block outright; inline elements have to be moved over.
+  void take( Array<T,N>& other )
+  {
+    if ( other.m_data != other.inlineData() ) {
+      m_data = other.m_data;
+      m_capacity = other.m_capacity;
+      other.m_data = other.inlineData();
+      other.m_capacity = N;
+    } else if ( N > 0 ) {
+      relocate( m_data, other.m_data, other.m_size );
+    }
+    m_size = other.m_size;
+    other.m_size = 0;
+  }
+
+  void release()
+  {
+    if ( m_data != this->inlineData() ) {
+      free( m_data );
+    }
+  }
+
+  static void copyConstruct( T* dst, const T* src, int n )
+  {
+    if ( std::is_trivially_copyable<T>::value ) {
+      if ( n ) memcpy( (void*)dst, (const void*)src, n * sizeof(T) );
+    } else {
+      for ( int i=0; i<n; i++ ) {
+	new ( dst + i ) T( src[i] );
+      }
+    }
+  }
+
+  // Move n elements to uninitialised memory, leaving none behind.
+  static void relocate( T* dst, T* src, int n )
+  {
+    if ( std::is_trivially_copyable<T>::value ) {
+      if ( n && src ) memcpy( (void*)dst, (const void*)src, n * sizeof(T) );
+    } else {
+      for ( int i=0; i<n; i++ ) {
+	new ( dst + i ) T( std::move(src[i]) );
+	src[i].~T();
+      }
+    }
+  }
+
+  void destroy( int from, int to )
+  {
+    if ( !std::is_trivially_destructible<T>::value ) {
+      for ( int i=from; i<to; i++ ) {
+	m_data[i].~T();
+      }
+    }
+  }
+
   T* m_data;
   int m_size;
   int m_capacity;
@@ -22,7 +22,6 @@
 #define __CANVAS_H__
 
 #include <string>
-#include <vita2d.h>
 
 #include "Config.h"
 #include "Common.h"
@@ -30,6 +29,15 @@
 #include "SDL_Lite.h"
 
 class Path;
+class CanvasRecorder;
+
+// A corner of the triangle strip that lines and rectangles are batched
+// into; colour as for makeColour().
+struct CanvasVertex
+{
+	float x, y;
+	int   colour;
+};
 
 class Canvas
 {
@@ -46,6 +54,12 @@ public:
 	void setBackground(Canvas* bg);
 	void clear();
 	void clear(const Rect& r);
+	// A screen of RGB565 pixels (the paper and whatever never moves) that
+	// clear() draws in place of the bare paper. NULL goes back to paper.
+	void setLayer(const void* pixels);
+	const void* layer() const;
+	// Whether clear() puts the layer down; faded screens get dark paper.
+	bool layered() const;
 	void fade(bool f);
 	Canvas* scale(int factor) const;
 	void drawImage(Canvas *canvas, int x, int y);
@@ -58,8 +72,24 @@ public:
 	void drawEdit(int x, int y);
 	void drawPause(int x, int y);
 	void drawNext(int x, int y);
-	void drawImage(void *img, int x, int y, int w, int h);
+	// A THUMB_WIDTH x THUMB_HEIGHT image of RGB565 pixels, copied up once
+	// here for drawImage() to draw at its own size as often as it likes.
+	// NULL drops it.
+	void setImage(const void* pixels);
+	void drawImage(int x, int y);
 	void LoadAssets();
+	// Lines, paths and rectangles are gathered into one triangle strip
+	// and drawn in a single call here. Anything else drawn flushes first
+	// to keep the order; the game flushes at the end of each frame.
+	void flush();
+	// Draw calls and vertices sent since resetCounts(). Only the headless
+	// backend keeps count.
+	int drawCalls() const;
+	int vertexCount() const;
+	void resetCounts();
+	// Keeps a copy of every draw in recorder (NULL stops). Only the
+	// headless backend records.
+	void record(CanvasRecorder* recorder);
 	
 protected:
 	typedef void* State;
@@ -69,6 +99,20 @@ protected:
 	Canvas* m_bgImage; 
 	Rect    m_clip;
 	bool b_fade;
+	const void* m_layer;
+	const void* m_image;
+	Array<CanvasVertex> m_batch;
+	bool    m_join;		// next vertex starts a new run of the strip
+	int     m_drawCalls;
+	int     m_vertices;
+	CanvasRecorder* m_recorder;
+
+	void beginStrip();
+	void addVertex(float x, float y, int c);
+	void addQuad(float x1, float y1, float x2, float y2, float hw, int c);
+	void addPolyline(const Path& path, int first, int end, float hw, int c);
+	// Backend: draws n vertices as a triangle strip.
+	void submit(const CanvasVertex* v, int n);
 	
 };
 
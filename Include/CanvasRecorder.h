@@ -0,0 +1,83 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __CANVAS_RECORDER_H__
+#define __CANVAS_RECORDER_H__
+
+#include "Array.h"
+#include "Canvas.h"
+#include "CanvasSoft.h"
+
+// What a frame cost to draw.
+struct RenderStats
+{
+	int   draws;		// calls that would reach the GPU
+	int   vertices;
+	int   uploads;		// textures whose pixels were copied up
+	int   uploadBytes;
+	float overdraw;		// area drawn over, in screens
+};
+
+// The draws a Canvas makes in a frame, kept as a compact list of commands
+// with their vertices and uploaded pixels alongside. Attached to a Canvas
+// with Canvas::record(); only the headless backend records.
+class CanvasRecorder
+{
+public:
+	enum Texture
+	{
+		TEX_PAPER,
+		TEX_PAPER_DARK,
+		TEX_LAYER,
+		TEX_EDIT,
+		TEX_PAUSE,
+		TEX_NEXT,
+		TEX_IMAGE,
+		TEX_COUNT
+	};
+
+	CanvasRecorder();
+
+	// Forgets the last frame's commands and stats. Uploaded textures are
+	// kept, as they are on the GPU.
+	void beginFrame();
+	void strip(const CanvasVertex* v, int n);
+	void texture(Texture t, int x, int y, int w, int h);
+	void upload(Texture t, const void* pixels, int w, int h);
+
+	const RenderStats& stats() const { return m_stats; }
+	int commandBytes() const;
+
+	// Draws the frame into canvas. The paper is the software canvas's own
+	// and icons, whose bitmaps aren't in the host build, are flat boxes.
+	void replay(CanvasSoft* canvas) const;
+
+private:
+	enum Op
+	{
+		OP_STRIP,	// first vertex, count
+		OP_TEXTURE	// texture, x, y, w, h
+	};
+
+	Array<int>          m_commands;
+	Array<CanvasVertex> m_vertices;
+	Array<char>         m_pixels[TEX_COUNT];
+	int                 m_width[TEX_COUNT];
+	int                 m_height[TEX_COUNT];
+	RenderStats         m_stats;
+};
+
+#endif //__CANVAS_RECORDER_H__
@@ -25,6 +25,7 @@
 
 #include "Config.h"
 #include "Common.h"
+#include "DirtyRegion.h"
 #include "Path.h"
 #include "SDL_Lite.h"
 
@@ -42,6 +43,16 @@ public:
 	int  makeColour(int r, int g, int b) const;
 	void resetClip();
 	void setClip(int x, int y, int w, int h);
+	// Paths are only drawn into the region's rectangles until the next
+	// setClip() or resetClip().
+	void setClip(const DirtyRegion& region);
+	// Paths, and the rectangles given to visible(), are scaled by sx
+	// across and sy down on their way to the canvas, so a scene can be
+	// drawn straight into a smaller one. Clips and clears are in canvas
+	// pixels.
+	void setScale(float sx, float sy);
+	// Whether a path inside r can touch any pixel being drawn into.
+	bool visible(const Rect& r) const;
 	void setBackground(int c);
 	void setBackground(CanvasSoft* bg);
 	void clear();
@@ -56,19 +67,52 @@ public:
 	void drawRect(int x, int y, int w, int h, int c, bool fill=true);
 	void drawRect2(char *dst,int x, int y, int w, int h, int c, bool fill=true);
 	void drawRect(const Rect& r, int c, bool fill=true);
+	// Pixels whose centres fall inside the triangle, within the clip.
+	void fillTriangle(float x0, float y0, float x1, float y1, float x2, float y2, int c);
 	void drawWorldLine(b2Vec2 pos1, b2Vec2 pos2, int color, bool thick=false);
 	void drawWorldPath(const Path& path, int color, bool thick=false);
 	int writeBMP(const char* filename) const;
 	
+	// Draw paths in RENDER_BANDS horizontal bands on up to this many
+	// threads. Between beginBands() and endBands(), drawPath() only sorts
+	// segments into the bands they touch; endBands() draws each band's
+	// list clipped to the band, bands in parallel. A pixel sees the same
+	// blends in the same order either way, so the result is identical.
+	// With one thread (the default) paths are drawn straight away.
+	void setThreads(int count);
+	void beginBands();
+	void endBands();
+
+	// Draw thick paths a row of pixels at a time, blending several to an
+	// instruction, rather than pixel by pixel. Only the benchmark turns
+	// this off, to compare the two.
+	static bool s_spanLines;
 	
 protected:
+	struct BandSegment
+	{
+		Vec2 p1, p2;
+		int  colour;
+	};
+
+	Vec2 scaled(const Vec2& p) const;
+	void drawSegment(const Vec2& p1, const Vec2& p2, int color, const Rect& to);
+	static void drawBand(void* context, int32 band, int32 worker);
+
 	typedef void* State;
 	CanvasSoft(State state=NULL);
 	State   m_state;
 	int     m_bgColour;
 	CanvasSoft* m_bgImage; 
 	Rect    m_clip;
-	short* m_paper_img;
+	DirtyRegion m_region;
+	const short* m_paper_img;
+	int     m_w, m_h;
+	float   m_scaleX, m_scaleY;
+	Path    m_scaled;
+	b2ThreadPool* m_pool;
+	bool    m_banding;
+	Array<BandSegment> m_bands[RENDER_BANDS];
 };
 
 #endif
@@ -23,9 +23,6 @@
 
 #define lerp(value, from_max, to_max) ((((value*10) * (to_max*10))/(from_max*10))/10)
 
-#include <psp2/ctrl.h>
-#include <psp2/touch.h>
-
 const int brush_colours[] = {
 	0xFF0000FF,//0xb80000, //red
 	0x3300FFFF,//0xeec900, //yellow
@@ -101,7 +98,6 @@ const int brush_colours[] = {
 
 struct Vec2 {
   Vec2() {}
-  Vec2( const Vec2& o ) : x(o.x), y(o.y) {}
   explicit Vec2( const b2Vec2& o ) : x((int)o.x), y((int)o.y) {}
   Vec2( int xx, int yy ) : x(xx), y(yy) {}
   void operator+=( const Vec2& o ) { x+=o.x; y+=o.y; }
@@ -29,6 +29,8 @@
 #define CANVAS_GROUNDf 30.0f
 #define PIXELS_PER_METREf 10.0f
 #define CLOSED_SHAPE_THREHOLDf 0.4f
+// A closed stroke needing more convex pieces than this stays an outline.
+#define CLOSED_MAX_PIECES 8
 #define SIMPLIFY_THRESHOLDf 1.0f //PIXELs //(1.0/PIXELS_PER_METREf)
 #define MULTI_VERTEX_LIMIT (b2_maxShapesPerBody)
 //#define USE_HILDON
@@ -53,6 +55,44 @@
 
 #define HIDE_STEPS (RENDER_RATE*4)
 
+// Rewind history: memory for it, and how often (in steps) a full snapshot
+// is taken. Resuming replays at most that many steps.
+#define REWIND_BYTES      (1024*1024)
+#define REWIND_KEY_STEPS  ITERATION_RATE
+// Frames L has to be held on its own before time runs backwards, so the
+// L+Left/Right level change can start with L without rewinding.
+#define REWIND_HOLD_FRAMES (RENDER_RATE/4)
+
+// Cell size of the screen-space grid used to find strokes near a point.
+#define STROKE_INDEX_CELL 32 //PIXELs
+
+// Redrawn parts of the screen: at most this many rectangles, and two are
+// only kept apart if that saves redrawing more than DIRTY_RECT_COST.
+#define DIRTY_RECTS     8
+#define DIRTY_RECT_COST 1024 //PIXELs
+
+// Whole-scene software renders (level thumbnails) are split into this
+// many horizontal bands, drawn on up to RENDER_THREADS threads. The Vita
+// leaves three cores to a game.
+#define RENDER_BANDS   16
+#define RENDER_THREADS 3
+
+// Level thumbnails are drawn at the size the next-level overlay shows
+// them, and kept: the last THUMB_CACHE in memory, all of them on disk in
+// THUMB_PATH, each good until its level file changes.
+#define THUMB_WIDTH  440
+#define THUMB_HEIGHT 220
+#define THUMB_CACHE  8
+#ifdef __vita__
+#  define THUMB_PATH "cache0:VitaDefilerClient/Documents/numptydata/thumbs"
+#else
+#  define THUMB_PATH USER_BASE_PATH "/thumbs"
+#endif
+
+// A stroke being drawn is simplified each time this many points have
+// been added, leaving little for pen-up to do.
+#define SIMPLIFY_FOLD_POINTS 32
+
 #ifndef INSTALL_BASE_PATH
 #  define INSTALL_BASE_PATH "data"
 #endif
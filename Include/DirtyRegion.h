@@ -0,0 +1,49 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __DIRTY_REGION_H__
+#define __DIRTY_REGION_H__
+
+#include "Array.h"
+#include "Common.h"
+#include "Config.h"
+
+// The parts of the screen to redraw, as a few disjoint rectangles.
+// Overlapping boxes are merged as they are added, and so are boxes close
+// enough that redrawing the gap between them costs less than another
+// rectangle (DIRTY_RECT_COST pixels). Past DIRTY_RECTS, the cheapest pair
+// is merged.
+class DirtyRegion
+{
+public:
+	DirtyRegion();
+
+	void clear();
+	void add(const Rect& r);
+
+	inline int size() const { return m_rects.size(); }
+	inline const Rect& rect(int i) const { return m_rects[i]; }
+	bool intersects(const Rect& r) const;
+	// Box around all the rectangles; only meaningful if size() > 0.
+	Rect bounds() const;
+	// Pixels covered.
+	int area() const;
+
+private:
+	Array<Rect, DIRTY_RECTS+1> m_rects;
+};
+
+#endif //__DIRTY_REGION_H__
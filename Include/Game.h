@@ -95,6 +95,8 @@ public:
 	
 private:
 	int iterateCounter;
+	int m_rewindBack;	// steps back being shown while L is held
+	int m_rewindHeld;	// frames L held alone, or -1 once used with Left/Right
 	int lastTick;
 	bool isComplete;
 	int scc;
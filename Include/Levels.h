@@ -26,7 +26,6 @@
 
 #include "Array.h"
 #include "zipfile.h"
-#include <psp2/io/dirent.h>
 
 class Levels
 {
@@ -35,6 +35,7 @@
 #include "Levels.h"
 #include "Overlay.h"
 #include "Scene.h"
+#include "ThumbnailCache.h"
 
 #include "SDL_Lite.h"
 
@@ -55,9 +56,9 @@ private:
 	bool genIcon();
 	int     m_selectedLevel;
 	int     m_levelIcon;
-	void* m_icon;
+	const Uint16* m_icon;
 	string  m_caption;
-	bool b;
+	ThumbnailCache m_thumbnails;
 };
 
 #endif
@@ -27,6 +27,8 @@
 #include <sstream>
 #include <fstream>
 
+#include <psp2/ctrl.h>
+#include <psp2/touch.h>
 #include <Box2D/Box2D.h>
 #include "Common.h"
 #include "Path.h"
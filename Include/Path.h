@@ -25,7 +25,11 @@
 #include "Array.h"
 #include "Segment.h"
 
-class Path : public Array<Vec2>
+// Points held inside a Path before it goes to the heap: enough for three
+// strokes in four as the levels come, after simplifying.
+#define PATH_INLINE_POINTS 16
+
+class Path : public Array<Vec2, PATH_INLINE_POINTS>
 {
 
 public:
@@ -87,11 +91,52 @@ public:
   inline Vec2& first() { return at(0); }
   inline Vec2& last() { return at(size()-1); }
 
-  void simplify( float threshold );
+  // Drop the points after first that lie within threshold of the line
+  // between the points kept either side of them (Douglas-Peucker).
+  void simplify( float threshold, int first=0 );
+  // The same, but also stop at maxPoints, keeping the points that stand
+  // furthest off the simplified line first.
+  void simplifyTo( int maxPoints, float threshold=0.0f );
   Rect bbox() const;
 
+  // Split the closed polygon through the points into convex pieces of at
+  // most maxVertices (<= b2_maxPolyVertices), wound with positive area.
+  // The pieces are appended to vertices, their sizes to counts. Fails if
+  // the polygon crosses itself or a piece is thinner than minWidth.
+  bool decompose( int maxVertices, float minWidth,
+		  Path& vertices, Array<int>& counts ) const;
+
+ private:
+  void simplify( int first, float threshold, int maxPoints );
+};
+
+// A path in 16 bit coordinates, half the size of a Path, for points kept
+// relative to a stroke's origin: anything on the canvas fits. Copy it out
+// to a Path to work on it and back in again.
+class PackedPath
+{
+public:
+  PackedPath() {}
+
+  inline int numPoints() const { return m_points.size(); }
+  inline Vec2 point(int i) const { return Vec2(m_points[i].x, m_points[i].y); }
+  inline Vec2 last() const { return point(numPoints()-1); }
+  void append( const Vec2& p );
+
+  // The points from first on, replacing what was in path.
+  void get( Path& path, int first=0 ) const;
+  // Replace the points from first on with those in path.
+  void set( const Path& path, int first=0 );
+  // Give back any room beyond the points held.
+  inline void shrink() { m_points.capacity(m_points.size()); }
+
  private:
-  void simplifySub(int first, int last, float threshold, bool* keepflags);  
+  struct Point
+  {
+    short x, y;
+  };
+
+  Array<Point, PATH_INLINE_POINTS> m_points;
 };
 
 #endif //PATH_H
@@ -0,0 +1,124 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __PIXEL_LANES_H__
+#define __PIXEL_LANES_H__
+
+#include "SDL_Lite.h"
+
+// 16-bit lanes for blending runs of RGB565 pixels in CanvasSoft. The width
+// follows the target: 16 lanes with AVX2, 8 with SSE2 or NEON, and 8 plain
+// shorts otherwise, which only keeps the code building: pix_simd is false
+// and nothing should prefer the lanes then. Arithmetic wraps at 16 bits,
+// which is all the scalar blend keeps once it masks its result. Loads and
+// stores are unaligned.
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+const int pix_simdWidth = 16;
+const bool pix_simd = true;
+typedef __m256i PixW;
+
+inline PixW pixSplatW(int a) { return _mm256_set1_epi16((short)a); }
+inline PixW pixLoadW(const Uint16* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline void pixStoreW(Uint16* p, PixW a) { _mm256_storeu_si256((__m256i*)p, a); }
+inline PixW pixAddW(PixW a, PixW b) { return _mm256_add_epi16(a, b); }
+inline PixW pixSubW(PixW a, PixW b) { return _mm256_sub_epi16(a, b); }
+inline PixW pixMulW(PixW a, PixW b) { return _mm256_mullo_epi16(a, b); }
+inline PixW pixAndW(PixW a, PixW b) { return _mm256_and_si256(a, b); }
+inline PixW pixOrW(PixW a, PixW b) { return _mm256_or_si256(a, b); }
+template <int N> inline PixW pixShrW(PixW a) { return _mm256_srli_epi16(a, N); }
+template <int N> inline PixW pixShlW(PixW a) { return _mm256_slli_epi16(a, N); }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+const int pix_simdWidth = 8;
+const bool pix_simd = true;
+typedef __m128i PixW;
+
+inline PixW pixSplatW(int a) { return _mm_set1_epi16((short)a); }
+inline PixW pixLoadW(const Uint16* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline void pixStoreW(Uint16* p, PixW a) { _mm_storeu_si128((__m128i*)p, a); }
+inline PixW pixAddW(PixW a, PixW b) { return _mm_add_epi16(a, b); }
+inline PixW pixSubW(PixW a, PixW b) { return _mm_sub_epi16(a, b); }
+inline PixW pixMulW(PixW a, PixW b) { return _mm_mullo_epi16(a, b); }
+inline PixW pixAndW(PixW a, PixW b) { return _mm_and_si128(a, b); }
+inline PixW pixOrW(PixW a, PixW b) { return _mm_or_si128(a, b); }
+template <int N> inline PixW pixShrW(PixW a) { return _mm_srli_epi16(a, N); }
+template <int N> inline PixW pixShlW(PixW a) { return _mm_slli_epi16(a, N); }
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+const int pix_simdWidth = 8;
+const bool pix_simd = true;
+typedef uint16x8_t PixW;
+
+inline PixW pixSplatW(int a) { return vdupq_n_u16((Uint16)a); }
+inline PixW pixLoadW(const Uint16* p) { return vld1q_u16(p); }
+inline void pixStoreW(Uint16* p, PixW a) { vst1q_u16(p, a); }
+inline PixW pixAddW(PixW a, PixW b) { return vaddq_u16(a, b); }
+inline PixW pixSubW(PixW a, PixW b) { return vsubq_u16(a, b); }
+inline PixW pixMulW(PixW a, PixW b) { return vmulq_u16(a, b); }
+inline PixW pixAndW(PixW a, PixW b) { return vandq_u16(a, b); }
+inline PixW pixOrW(PixW a, PixW b) { return vorrq_u16(a, b); }
+template <int N> inline PixW pixShrW(PixW a) { return vshrq_n_u16(a, N); }
+template <int N> inline PixW pixShlW(PixW a) { return vshlq_n_u16(a, N); }
+
+#else
+
+const int pix_simdWidth = 8;
+const bool pix_simd = false;
+struct PixW { Uint16 v[8]; };
+
+inline PixW pixSplatW(int a) { PixW r; for (int i = 0; i < 8; ++i) r.v[i] = (Uint16)a; return r; }
+inline PixW pixLoadW(const Uint16* p) { PixW r; for (int i = 0; i < 8; ++i) r.v[i] = p[i]; return r; }
+inline void pixStoreW(Uint16* p, PixW a) { for (int i = 0; i < 8; ++i) p[i] = a.v[i]; }
+
+#define PIX_LANEWISE(name, expr) \
+	inline PixW name(PixW a, PixW b) \
+	{ \
+		PixW r; \
+		for (int i = 0; i < 8; ++i) { Uint16 x = a.v[i], y = b.v[i]; r.v[i] = (Uint16)(expr); } \
+		return r; \
+	}
+
+PIX_LANEWISE(pixAddW, x + y)
+PIX_LANEWISE(pixSubW, x - y)
+PIX_LANEWISE(pixMulW, (unsigned)x * y)
+PIX_LANEWISE(pixAndW, x & y)
+PIX_LANEWISE(pixOrW, x | y)
+
+#undef PIX_LANEWISE
+
+template <int N> inline PixW pixShrW(PixW a) { for (int i = 0; i < 8; ++i) a.v[i] = (Uint16)(a.v[i] >> N); return a; }
+template <int N> inline PixW pixShlW(PixW a) { for (int i = 0; i < 8; ++i) a.v[i] = (Uint16)(a.v[i] << N); return a; }
+
+#endif
+
+// Lane i holds a + i*step.
+inline PixW pixRampW(int a, int step)
+{
+	static const Uint16 s_lanes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+	return pixAddW(pixSplatW(a), pixMulW(pixLoadW(s_lanes), pixSplatW(step)));
+}
+
+#endif //__PIXEL_LANES_H__
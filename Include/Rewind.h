@@ -0,0 +1,103 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include "Array.h"
+
+class Scene;
+
+// What the recording holds and what it has cost so far. Delta bytes count
+// the per-step frames only; key bytes are the periodic scene snapshots.
+struct RewindStats
+{
+	int frames;			// steps that can be rewound
+	int keyFrames;
+	int bytesUsed;
+	int capacity;
+	double keyBytes;	// recorded since the last clear
+	double deltaBytes;
+	double bodySteps;	// bodies times delta frames
+
+	double bytesPerBodyStep() const
+	{
+		return bodySteps > 0 ? deltaBytes / bodySteps : 0.0;
+	}
+};
+
+// Rewind buffer for the running simulation. Every step stores the pose of
+// each stroke, quantised and delta coded against the step before; every
+// keyInterval steps a full scene snapshot is stored as well. The lot lives
+// in one fixed block of memory and the oldest second or so is dropped as
+// it fills up.
+//
+// show() puts the strokes where they were some steps ago without running
+// the simulation, for scrubbing. resume() goes back to that step for real:
+// it restores the snapshot before it, replays the steps in between and
+// forgets everything later.
+class Rewind
+{
+public:
+	Rewind(int maxBytes, int keyInterval);
+	~Rewind();
+
+	// A maxBytes of 0 turns recording off.
+	void configure(int maxBytes, int keyInterval);
+	void clear();
+	void record(Scene& scene);
+
+	int frames() const;
+	bool show(Scene& scene, int back);
+	bool resume(Scene& scene, int back);
+	RewindStats stats() const;
+
+private:
+	struct Segment
+	{
+		int offset;		// of the key record
+		int first;		// frame number of the key
+		int count;		// frames, key included
+	};
+
+	void track(Scene& scene);
+	void encode(Scene& scene, bool key);
+	int allocate(int bytes);
+	void evict();
+	int findSegment(int frame) const;
+	int decodeKey(int offset, const char** snapshot, int* snapshotSize);
+	int decodeDelta(int offset);
+	int next(int offset) const;
+	void apply(Scene& scene);
+
+	char*          m_buf;
+	int            m_capacity;
+	int            m_keyInterval;
+	int            m_head;
+	int            m_tail;
+	int            m_last;		// frame number of the newest record
+	Array<Segment> m_segments;
+	int            m_strokeCount;	// in the scene being recorded
+	Array<int>     m_tracked;	// strokes with bodies, the only ones recorded
+	Array<int>     m_pose;		// quantised x, y, angle per tracked stroke
+	Array<float>   m_raw;		// body x, y, angle behind m_pose
+	Array<int>     m_decoded;	// the same, for the frame being shown
+	Array<char>    m_frame;		// record being encoded
+	Array<char>    m_snapshot;
+	RewindStats    m_stats;
+};
+
+#endif //__REWIND_H__
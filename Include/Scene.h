@@ -32,13 +32,18 @@
 #include "Path.h"
 #include "Canvas.h"
 #include "CanvasSoft.h"
+#include "DirtyRegion.h"
 #include "Config.h"
 #include "Stroke.h"
 #include "Image.h"
+#include "Rewind.h"
+#include "StrokeIndex.h"
 
 using namespace std;
 
-class Scene
+// The scene hears about goal hits and stray tokens from the world rather
+// than searching every contact and stroke after each step.
+class Scene : private b2ContactListener, private b2WorldListener
 {
 public:
 	Scene(bool noWorld=false);
@@ -53,15 +58,33 @@ public:
 	void step();
 	bool isCompleted();
 	Rect dirtyArea();
+	// Like dirtyArea(), but one rectangle per cluster of dirty strokes
+	// rather than one around them all.
+	void dirtyRegion(DirtyRegion& region);
 	void draw(Canvas* canvas, const Rect& area);
 	void draw(CanvasSoft* canvas, const Rect& area);
+	// Redraws only the region; the rest of the canvas keeps the last frame.
+	void draw(CanvasSoft* canvas, const DirtyRegion& region);
 	void reset(Stroke* s=NULL);
 	Stroke* strokeAtPoint(const Vec2 pt, float max);
 	void clear();
 	bool load(const string& file);
+	// Rebuild the last loaded level from the copy parsed by load, without
+	// touching the file. False if there is none or the scene was saved.
+	bool restart();
+	// Capture the running level (bodies, contacts, joints and goal state)
+	// and put it back later without rebuilding anything. Restoring fails if
+	// strokes have been added or removed since the snapshot was taken, and
+	// a failed restore leaves the scene as it was.
+	void saveSnapshot(Array<char>& snapshot);
+	bool restoreSnapshot(const Array<char>& snapshot);
 	void protect(int n=-1);
 	bool save(const std::string& file);
 	Array<Stroke*>& strokes();
+	b2World* world();
+	// History of the last few seconds of steps, cleared whenever strokes
+	// are added, removed or (re)activated other than by step itself.
+	Rewind& rewind();
 /*
 	Array<Stroke*>& strokes() 
 	{
@@ -72,11 +95,30 @@ public:
 private:
 	b2World        *m_world;
 	Array<Stroke*>  m_strokes;
+	Array<Stroke*>  m_template;
+	bool            m_haveTemplate;
 	string          m_title, m_author, m_bg;
 	Image          *m_bgImage;
 	static Image   *g_bgImage;
 	int             m_protect;
-	
+	Rewind          m_rewind;
+	// Filled during Step and draw, handled at the end of the next step.
+	Array<Stroke*>  m_goalHits;
+	Array<Stroke*>  m_strayTokens;
+	StrokeIndex     m_index;
+	Array<int>      m_near;
+	// Paper with the static strokes on it, made on the first draw to a
+	// Canvas and again whenever a static stroke comes or goes.
+	CanvasSoft     *m_layer;
+	bool            m_layerStale;
+
+	b2World* newWorld();
+	void clearTemplate();
+	void drawLayer();
+	void strayToken(Stroke* s);
+	void BeginContact(b2Contact* contact);
+	void NotifyJointDestroyed(b2Joint* joint);
+	b2BoundaryResponse NotifyBoundaryViolated(b2Body* body);
 };
 
 #endif
@@ -0,0 +1,62 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __SEGMENT_TREE_H__
+#define __SEGMENT_TREE_H__
+
+#include "Common.h"
+#include "Array.h"
+#include "Path.h"
+
+// Bounding box hierarchy over the segments of a path, each node covering a
+// run of consecutive segments. It is built once in the path's own frame
+// and queried with points moved into that frame, so it survives the path
+// being rotated and translated with its body.
+class SegmentTree
+{
+public:
+	SegmentTree();
+
+	void clear();
+	// True if built from a path of this many points.
+	bool covers(int points) const;
+	void build(const Path& path);
+
+	// Distance from pt to the nearest segment of measured, or best if none
+	// is nearer. measured must be the built path moved so that no point is
+	// more than slack from where local says pt is; only the segments whose
+	// boxes could hold something nearer are measured.
+	float distanceTo(const Path& measured, const Vec2& pt, const b2Vec2& local,
+					 float slack, float best) const;
+
+private:
+	struct Node
+	{
+		short x0, y0, x1, y1;	// paths are built in their own frame,
+								// where points fit a PackedPath
+		int   first;	// segment i joins points i and i+1
+		int   count;	// segments; children only when more than a leaf's
+		int   right;	// second child, the first follows this node
+	};
+
+	int build(const Path& path, int first, int count);
+	float boxDistanceSq(const Node& n, const b2Vec2& p) const;
+
+	Array<Node> m_nodes;
+	int         m_points;
+};
+
+#endif //__SEGMENT_TREE_H__
@@ -30,12 +30,15 @@
 #include <Box2D/Box2D.h>
 #include "Common.h"
 #include "Path.h"
+#include "SegmentTree.h"
 #include "Canvas.h"
 #include "Config.h"
 #include "CanvasSoft.h"
 
 using namespace std;
 
+struct StrokeXform;
+
 class Stroke
 {
 
@@ -64,44 +67,72 @@ private:
 		}
 	};
 
-	struct BoxDef : public b2BoxDef
+	struct ChainDef : public b2ChainDef
 	{
-		void init(const Vec2& p1, const Vec2& p2, int attr)
+		void init(const Path& path, int attr)
 		{
-			b2Vec2 barOrigin = p1;
-			b2Vec2 bar = p2 - p1;
-			bar *= 1.0f/PIXELS_PER_METREf;
-			barOrigin *= 1.0f/PIXELS_PER_METREf;;
-			extents.Set( bar.Length()/2.0f, 0.1f );
-			localPosition = 0.5f*bar + barOrigin;
-			localRotation = vec2Angle( bar );
-			friction = 0.3f;
-			if (attr & ATTRIB_GROUND)
-			{
-				density = 0.0f;
-			}
-			else
-			if (attr & ATTRIB_GOAL)
+			int n = path.numPoints();
+			if (n > MULTI_VERTEX_LIMIT) n = MULTI_VERTEX_LIMIT;
+			for (int i=0; i<n; i++)
 			{
-				density = 100.0f;
+				points[i] = path.point(i);
+				points[i] *= 1.0f/PIXELS_PER_METREf;
 			}
-			else
-			if (attr & ATTRIB_TOKEN)
-			{
-				density = 3.0f;
-				friction = 0.1f;
-			}
-			else
+			vertices = points;
+			vertexCount = n;
+			radius = 0.1f;
+			material(this, attr);
+		}
+
+		b2Vec2 points[MULTI_VERTEX_LIMIT];
+	};
+
+	// One convex piece of a closed stroke. densityScale keeps the filled
+	// body as heavy as the outline would have been.
+	struct PolyDef : public b2PolyDef
+	{
+		void init(const Vec2* p, int n, int attr, float densityScale)
+		{
+			for (int i=0; i<n; i++)
 			{
-				density = 5.0f;
+				vertices[i] = p[i];
+				vertices[i] *= 1.0f/PIXELS_PER_METREf;
 			}
-			restitution = 0.2f;
+			vertexCount = n;
+			material(this, attr);
+			density *= densityScale;
 		}
 	};
 
+	static void material(b2ShapeDef* def, int attr)
+	{
+		def->friction = 0.3f;
+		if (attr & ATTRIB_GROUND)
+		{
+			def->density = 0.0f;
+		}
+		else
+		if (attr & ATTRIB_GOAL)
+		{
+			def->density = 100.0f;
+		}
+		else
+		if (attr & ATTRIB_TOKEN)
+		{
+			def->density = 3.0f;
+			def->friction = 0.1f;
+		}
+		else
+		{
+			def->density = 5.0f;
+		}
+		def->restitution = 0.2f;
+	}
+
 public:
 	Stroke(const Path& path);
 	Stroke(const string& str);
+	~Stroke();
 
 	void reset(b2World* world=NULL);
 	string asString();
@@ -117,23 +148,67 @@ public:
 	b2Body* body();
 	float distanceTo(const Vec2& pt);
 	Rect bbox();
+	// bbox() without moving a hide animation on. A hiding stroke only
+	// shrinks, so its last box still covers it.
+	Rect extent();
 	Rect lastDrawnBbox();
 	bool isDirty();
 	void hide();
 	bool hidden();
+	// Ground and decoration don't move once made, so they can be drawn
+	// once into a cached layer rather than every frame.
+	bool isStatic();
+	// Progress of the hide animation, kept by scene snapshots.
+	int hideStep();
+	void hideStep(int n);
 	int numPoints();
+	bool filled();
+
+	// Which closed strokes are filled with convex polygons instead of an
+	// outline chain: by default only those the player draws, so levels
+	// play as they were made. Filling makes a drawn loop solid; it costs
+	// shapes rather than saving them. Only the benchmark changes this, to
+	// compare outlines with filling everything.
+	enum FillMode
+	{
+		FILL_NONE,
+		FILL_DRAWN,
+		FILL_ALL
+	};
+	static FillMode s_fillClosed;
+	// Measure distances through the segment tree rather than every
+	// segment. Only the benchmark turns this off, to compare the two.
+	static bool s_segmentTree;
+
+	// Bring the transformed paths of all the strokes whose awake bodies
+	// have moved up to date in one pass. Others catch up when used, from
+	// shared slots enough for all of them.
+	static void transformAll(Array<Stroke*>& strokes);
 
 private:
 	static float vec2Angle(b2Vec2 v);
 	void process();
 	bool transform();
+	bool moved();
+	void transformBody();
+	Rect transformRaw(Path& out);
+	Path& xformSlot(bool& held);
+	static void growXformSlots(int n);
+	const Path& xformed();
+	void forgetXformed();
+	void releaseAwake();
 
-	Path      m_rawPath;
+	PackedPath m_rawPath;	// relative to m_origin
+	int       m_folded;		// raw points up to here are simplified
 	int       m_colour;
 	int       m_attributes;
 	Vec2      m_origin;
-	Path      m_shapePath;
-	Path      m_xformedPath;
+	Array<int> m_convexCounts;
+	bool      m_playerDrawn;	// made in game rather than read from a level
+	bool      m_xformStale;	// raw path or origin changed since
+	int       m_xformSlot;	// where the transformed path was last held
+	StrokeXform* m_awake;	// own transformed path while the body is awake
+	SegmentTree m_tree;		// over m_rawPath
 	float     m_xformAngle;
 	b2Vec2    m_xformPos;
 	Rect      m_xformBbox;
@@ -142,6 +217,7 @@ private:
 	b2Body*   m_body;
 	bool      m_jointed[2];
 	int       m_hide;
+	bool      m_activated;	// bodies made at least once
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __STROKE_INDEX_H__
+#define __STROKE_INDEX_H__
+
+#include "Array.h"
+#include "Common.h"
+
+class Stroke;
+
+// Uniform grid over the screen holding the bounding box of every stroke,
+// so picking and joint discovery only measure the strokes near a point
+// rather than all of them. Strokes outside the grid land in its edge cells.
+//
+// Boxes go stale when strokes move. The scene invalidates the index after
+// anything that moves or adds strokes and the next update() rebuilds it.
+class StrokeIndex
+{
+public:
+	StrokeIndex(const Rect& bounds, int cellSize);
+
+	void invalidate();
+	void update(Array<Stroke*>& strokes);
+
+	// Indices of the strokes whose box meets r, in stroke order, each once.
+	void query(const Rect& r, Array<int>& found);
+
+private:
+	void cellRange(const Rect& r, int& x0, int& y0, int& x1, int& y1) const;
+
+	Rect       m_bounds;
+	int        m_cell;
+	int        m_cols;
+	int        m_rows;
+	bool       m_valid;
+	Array<Rect> m_boxes;	// per stroke
+	Array<int> m_start;		// per cell, into m_entries; one extra at the end
+	Array<int> m_entries;	// stroke indices grouped by cell
+	Array<int> m_stamp;		// per stroke, the last query that found it
+	int        m_query;
+};
+
+#endif //__STROKE_INDEX_H__
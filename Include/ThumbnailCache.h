@@ -0,0 +1,72 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __THUMBNAIL_CACHE_H__
+#define __THUMBNAIL_CACHE_H__
+
+#include <string>
+
+#include "Array.h"
+#include "CanvasSoft.h"
+#include "Config.h"
+
+// Level thumbnails for the next-level overlay, THUMB_WIDTH x THUMB_HEIGHT
+// RGB565 pixels. A level is drawn straight into a canvas that size, with
+// the paper averaged down and the strokes scaled, not drawn full size
+// and shrunk. Thumbnails are found by level file and its modification
+// time: among the last THUMB_CACHE used, then on disk in dir, and only
+// then drawn, and saved to dir for next time.
+class ThumbnailCache
+{
+public:
+	ThumbnailCache(const char* dir=THUMB_PATH);
+	~ThumbnailCache();
+
+	// The level's thumbnail, or NULL if it won't load. Good until the next
+	// call.
+	const Uint16* get(const std::string& file);
+
+	// Draws the level into pixels, leaving the cache alone.
+	bool render(const std::string& file, Uint16* pixels);
+
+	// Where the thumbnails get() returned came from.
+	int hits() const { return m_hits; }
+	int loads() const { return m_loads; }
+	int renders() const { return m_renders; }
+
+private:
+	struct Entry
+	{
+		std::string file;
+		long long   modified;	// -1 if nothing is held
+		unsigned    used;
+		Uint16      pixels[THUMB_WIDTH * THUMB_HEIGHT];
+	};
+
+	std::string diskFile(const std::string& file) const;
+	bool load(Entry* e) const;
+	void save(const Entry* e) const;
+
+	std::string    m_dir;
+	CanvasSoft     m_canvas;
+	Array<Entry*>  m_entries;
+	unsigned       m_clock;
+	int            m_hits;
+	int            m_loads;
+	int            m_renders;
+};
+
+#endif //__THUMBNAIL_CACHE_H__
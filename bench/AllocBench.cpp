@@ -0,0 +1,233 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string.h>
+#include <malloc.h>
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Heap traffic of the game loop. malloc, calloc and realloc are wrapped
+// for the whole numpty-bench binary (glibc only) and counted while a
+// measurement is running; operator new goes through malloc so it is
+// counted too. For every level it reports the calls made loading and
+// activating it, per frame of play (ITERATION_RATE/RENDER_RATE steps,
+// dirtyArea and a draw into the headless canvas) and per stroke drawn by
+// hand (newStroke, one addPoint per point, activate, deleteStroke).
+// Last, the heap held by long strokes scribbled into an empty scene, as
+// in levels people draw themselves.
+// Sanitizer builds keep their own allocator and count nothing.
+
+static bool s_counting = false;
+static long s_calls = 0;
+static long s_bytes = 0;
+static long s_held = 0;	// heap growth, in usable bytes
+
+#ifndef __SANITIZE_ADDRESS__
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void __libc_free(void* p);
+
+extern "C" void* malloc(size_t size)
+{
+	void* p = __libc_malloc(size);
+	if (s_counting)
+	{
+		s_calls++;
+		s_bytes += size;
+		s_held += malloc_usable_size(p);
+	}
+	return p;
+}
+
+extern "C" void* calloc(size_t n, size_t size)
+{
+	void* p = __libc_calloc(n, size);
+	if (s_counting)
+	{
+		s_calls++;
+		s_bytes += n * size;
+		s_held += malloc_usable_size(p);
+	}
+	return p;
+}
+
+extern "C" void* realloc(void* p, size_t size)
+{
+	long before = s_counting && p ? malloc_usable_size(p) : 0;
+	void* q = __libc_realloc(p, size);
+	if (s_counting)
+	{
+		s_calls++;
+		s_bytes += size;
+		s_held += malloc_usable_size(q) - before;
+	}
+	return q;
+}
+
+extern "C" void free(void* p)
+{
+	if (s_counting && p)
+	{
+		s_held -= malloc_usable_size(p);
+	}
+	__libc_free(p);
+}
+
+#endif
+
+static void startCounting()
+{
+	s_calls = 0;
+	s_bytes = 0;
+	s_held = 0;
+	s_counting = true;
+}
+
+static void stopCounting()
+{
+	s_counting = false;
+}
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+int benchAlloc(int argc, char** argv)
+{
+	int frames = 600, strokes = 20, points = 2000;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-f", frames)
+			&& !benchIntArg(argc, argv, i, "-s", strokes)
+			&& !benchIntArg(argc, argv, i, "-p", points))
+		{
+			paths.append(argv[i]);
+		}
+	}
+	frames = MAX(frames, 1);
+	strokes = MAX(strokes, 1);
+	points = MAX(points, 2);
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int stepsPerFrame = ITERATION_RATE / RENDER_RATE;
+	Scene scene;
+	Canvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	long loadCalls = 0, frameCalls = 0, frameBytes = 0, strokeCalls = 0;
+
+	printf("%-24s %10s %12s %12s %12s\n", "level", "load", "calls/frame", "bytes/frame", "calls/stroke");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		startCounting();
+		bool loaded = scene.load(levels.levelFile(l));
+		if (loaded)
+		{
+			scene.activateAll();
+		}
+		stopCounting();
+		if (!loaded)
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		long load = s_calls;
+
+		// One frame first so the canvas and rewind buffers are in place.
+		for (int f=0; f<=frames; f++)
+		{
+			if (f == 1)
+			{
+				startCounting();
+			}
+			for (int s=0; s<stepsPerFrame; s++)
+			{
+				scene.step();
+			}
+			scene.draw(&canvas, scene.dirtyArea());
+		}
+		stopCounting();
+		long calls = s_calls, bytes = s_bytes;
+
+		// A squiggle of 40 points, drawn, dropped into the level and taken
+		// out again.
+		startCounting();
+		for (int k=0; k<strokes; k++)
+		{
+			Vec2 p(100 + 20 * k, 100);
+			Stroke* stroke = scene.newStroke(Path() & p);
+			for (int i=1; i<40; i++)
+			{
+				stroke->addPoint(p + Vec2(4 * i, (i & 1) * 6));
+			}
+			scene.activate(stroke);
+			scene.deleteStroke(stroke);
+			delete stroke;  // deleteStroke only unlinks it
+		}
+		stopCounting();
+		long stroke = s_calls;
+
+		printf("%-24s %10ld %12.1f %12.0f %12.1f\n", baseName(levels.levelFile(l)), load,
+			   (double)calls / frames, (double)bytes / frames, (double)stroke / strokes);
+		loadCalls += load;
+		frameCalls += calls;
+		frameBytes += bytes;
+		strokeCalls += stroke;
+	}
+
+	int n = levels.numLevels();
+	printf("%-24s %10ld %12.1f %12.0f %12.1f\n", "total", loadCalls,
+		   (double)frameCalls / (frames * n), (double)frameBytes / (frames * n),
+		   (double)strokeCalls / (strokes * n));
+
+	// Random walks of a few pixels a point, each activated and then
+	// measured against, as drawing the next one would. They are ground so
+	// that the contacts of one overlapping the next aren't counted.
+	Scene drawn;
+	unsigned int seed = 1;
+	startCounting();
+	for (int k=0; k<strokes; k++)
+	{
+		Vec2 p(CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2);
+		Stroke* stroke = drawn.newStroke(Path() & p);
+		for (int i=1; i<points; i++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			p += Vec2((int)((seed >> 16) % 9) - 4, (int)((seed >> 20) % 9) - 4);
+			stroke->addPoint(p);
+		}
+		stroke->setAttribute(Stroke::ATTRIB_GROUND);
+		drawn.activate(stroke);
+		stroke->distanceTo(p);
+	}
+	stopCounting();
+	printf("%d drawn strokes of %d points hold %ld bytes each, %.1f a point\n",
+		   strokes, points, s_held / strokes, (double)s_held / (strokes * points));
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Whole-scene software renders, as for level thumbnails, with the canvas
+// split into RENDER_BANDS bands drawn on 1, 2, 4, ... up to -j threads.
+// Every level is loaded once and drawn -k times per thread count; the
+// pixels must match the single-threaded render exactly.
+
+static const Rect SCREEN_RECT(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
+
+static unsigned long long hashPixels(const CanvasSoft& canvas)
+{
+	const Uint16* p = (const Uint16*)canvas.scale(1);
+	unsigned long long h = 0;
+	for (int i=0; i<CANVAS_WIDTH*CANVAS_HEIGHT; i++)
+	{
+		h = h * 31 + p[i];
+	}
+	return h;
+}
+
+int benchBands(int argc, char** argv)
+{
+	int renders = 200;
+	int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-k", renders)
+			&& !benchIntArg(argc, argv, i, "-j", workers))
+		{
+			paths.append(argv[i]);
+		}
+	}
+	workers = MAX(1, MIN(workers, b2_maxWorkers));
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	Array<Scene*> scenes;
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		Scene* scene = new Scene(true);
+		if (scene->load(levels.levelFile(l)))
+		{
+			scenes.append(scene);
+		}
+		else
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			delete scene;
+		}
+	}
+
+	const int bytes = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
+	CanvasSoft serial(CANVAS_WIDTH, CANVAS_HEIGHT);
+	CanvasSoft banded(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+	printf("%d levels, %d renders each, %d bands\n", scenes.size(), renders, RENDER_BANDS);
+	printf("%7s %10s %8s %16s\n", "threads", "us/render", "speedup", "pixels");
+
+	double serialTime = 0.0;
+	bool identical = true;
+	for (int w=1; ; w = MIN(w * 2, workers))
+	{
+		banded.setThreads(w);
+		double t = 0.0;
+		unsigned long long h = 0;
+		bool match = true;
+		for (int l=0; l<scenes.size(); l++)
+		{
+			double t0 = benchNow();
+			for (int k=0; k<renders; k++)
+			{
+				scenes[l]->draw(&banded, SCREEN_RECT);
+			}
+			t += benchNow() - t0;
+
+			scenes[l]->draw(&serial, SCREEN_RECT);
+			match = match && memcmp(serial.scale(1), banded.scale(1), bytes) == 0;
+			h = h * 31 + hashPixels(banded);
+		}
+		if (w == 1)
+		{
+			serialTime = t;
+		}
+		identical = identical && match;
+
+		int n = scenes.size() * renders;
+		printf("%7d %10.1f %7.2fx %016llx%s\n", w, t * 1e6 / n, serialTime / t, h,
+			   match ? "" : "  MISMATCH");
+
+		if (w == workers)
+		{
+			break;
+		}
+	}
+
+	for (int l=0; l<scenes.size(); l++)
+	{
+		delete scenes[l];
+	}
+	printf("identical to one thread: %s\n", identical ? "yes" : "NO");
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Draws every level through the headless Canvas, which counts what would
+// reach the GPU, and checks that a frame of strokes is one batched draw
+// on top of the paper. A few fixed shapes check the vertex counts of the
+// strip itself.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+static bool expect(const char* what, int got, int want)
+{
+	if (got != want)
+	{
+		printf("%s: %d, expected %d\n", what, got, want);
+		return false;
+	}
+	return true;
+}
+
+// Two vertices a point, two more to join each run to the one before.
+static bool checkShapes(Canvas& canvas)
+{
+	bool ok = true;
+	Path line;
+	line.append(Vec2(10,10));
+	line.append(Vec2(50,10));
+	line.append(Vec2(50,60));
+	line.append(Vec2(10,10));
+
+	canvas.resetCounts();
+	canvas.drawPath(line, 0xff0000ff, true);
+	canvas.flush();
+	ok &= expect("path draws", canvas.drawCalls(), 1);
+	ok &= expect("path vertices", canvas.vertexCount(), 8);
+
+	// Off the screen in the middle: two runs of two points.
+	Path broken;
+	broken.append(Vec2(10,10));
+	broken.append(Vec2(20,10));
+	broken.append(Vec2(-50,10));
+	broken.append(Vec2(30,10));
+	broken.append(Vec2(40,10));
+	canvas.resetCounts();
+	canvas.drawPath(broken, 0xff0000ff, true);
+	canvas.flush();
+	ok &= expect("broken path vertices", canvas.vertexCount(), 4 + 2 + 4);
+
+	canvas.resetCounts();
+	canvas.drawRect(10, 10, 20, 20, 0xff000000, false);
+	canvas.drawRect(40, 40, 5, 5, 0xff000000, true);
+	canvas.drawPath(line, 0xff0000ff, true);
+	canvas.flush();
+	ok &= expect("mixed draws", canvas.drawCalls(), 1);
+	ok &= expect("mixed vertices", canvas.vertexCount(), 4*4 + 4 + 8 + 5*2);
+
+	// A texture in the middle splits the batch to keep the order.
+	canvas.resetCounts();
+	canvas.drawPath(line, 0xff0000ff, true);
+	canvas.drawPause(0, 0);
+	canvas.drawPath(line, 0xff0000ff, true);
+	canvas.flush();
+	ok &= expect("split draws", canvas.drawCalls(), 3);
+	return ok;
+}
+
+int benchBatch(int argc, char** argv)
+{
+	int frames = 300;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-f", frames))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Canvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	canvas.setClip(0, 0, CANVAS_WIDTH, CANVAS_HEIGHT);
+	bool ok = checkShapes(canvas);
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int stepsPerFrame = ITERATION_RATE / RENDER_RATE;
+	const Rect screen(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
+	double drawTotal = 0.0;
+	long verticesTotal = 0;
+	int framesTotal = 0, maxDraws = 0;
+
+	printf("%-24s %7s %9s %9s %9s\n", "level", "strokes", "draws", "vertices", "us");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		Scene scene;
+		if (!scene.load(levels.levelFile(l)))
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		scene.activateAll();
+
+		double drawTime = 0.0;
+		long vertices = 0;
+		int draws = 0;
+		for (int f=0; f<frames; f++)
+		{
+			for (int s=0; s<stepsPerFrame; s++)
+			{
+				scene.step();
+			}
+			canvas.resetCounts();
+			double t0 = benchNow();
+			scene.draw(&canvas, screen);
+			canvas.flush();
+			drawTime += benchNow() - t0;
+
+			// The paper (with the static layer) and one strip.
+			if (canvas.drawCalls() > 2)
+			{
+				printf("%s frame %d: %d draws\n", baseName(levels.levelFile(l)), f, canvas.drawCalls());
+				ok = false;
+			}
+			maxDraws = MAX(maxDraws, canvas.drawCalls());
+			draws += canvas.drawCalls();
+			vertices += canvas.vertexCount();
+		}
+
+		printf("%-24s %7d %9.2f %9.0f %9.2f\n", baseName(levels.levelFile(l)),
+			   scene.numStrokes(), (double)draws / frames, (double)vertices / frames,
+			   drawTime * 1e6 / frames);
+		drawTotal += drawTime;
+		verticesTotal += vertices;
+		framesTotal += frames;
+	}
+
+	if (framesTotal)
+	{
+		printf("%-24s %7s %9d %9.0f %9.2f\n", "total", "", maxDraws,
+			   (double)verticesTotal / framesTotal, drawTotal * 1e6 / framesTotal);
+	}
+	printf(ok ? "draw counts as expected\n" : "draw counts differ\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <algorithm>
+
+#include "Bench.h"
+#include "Config.h"
+
+int benchScene(int argc, char** argv);
+int benchIslands(int argc, char** argv);
+int benchBroadPhase(int argc, char** argv);
+int benchClosed(int argc, char** argv);
+int benchRestart(int argc, char** argv);
+int benchSnapshot(int argc, char** argv);
+int benchRewind(int argc, char** argv);
+int benchIndex(int argc, char** argv);
+int benchDistance(int argc, char** argv);
+int benchSimplify(int argc, char** argv);
+int benchAlloc(int argc, char** argv);
+int benchRedraw(int argc, char** argv);
+int benchBatch(int argc, char** argv);
+int benchRender(int argc, char** argv);
+int benchLines(int argc, char** argv);
+int benchBands(int argc, char** argv);
+int benchThumbs(int argc, char** argv);
+
+static const BenchSuite s_suites[] =
+{
+	{ "levels", "[-k thousands] [level.nph|dir ...]", benchScene },
+	{ "islands", "[-p piles] [-r rows] [-k steps] [-j workers] [level.nph|dir ...]", benchIslands },
+	{ "broadphase", "[-n max proxies] [-f frames] [-s spread]", benchBroadPhase },
+	{ "closed", "[-k thousands] [level.nph|dir ...]", benchClosed },
+	{ "restart", "[-n repeats] [level.nph|dir ...]", benchRestart },
+	{ "snapshot", "[-w warmup] [-s steps] [level.nph|dir ...]", benchSnapshot },
+	{ "rewind", "[-s steps] [-m bytes] [-n repeats] [level.nph|dir ...]", benchRewind },
+	{ "index", "[-n strokes] [-q picks]", benchIndex },
+	{ "distance", "[-n strokes] [-p points] [-q queries]", benchDistance },
+	{ "simplify", "[-n strokes] [-p points]", benchSimplify },
+	{ "alloc", "[-f frames] [-s strokes] [-p points] [level.nph|dir ...]", benchAlloc },
+	{ "redraw", "[-f frames] [level.nph|dir ...]", benchRedraw },
+	{ "batch", "[-f frames] [level.nph|dir ...]", benchBatch },
+	{ "render", "[-f frames] [level.nph|dir ...]", benchRender },
+	{ "lines", "[-n lines] [-l length] [-r repeats]", benchLines },
+	{ "bands", "[-k renders] [-j threads] [level.nph|dir ...]", benchBands },
+	{ "thumbs", "[-n repeats] [level.nph|dir ...]", benchThumbs },
+};
+
+double benchNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+long benchPeakRSS()
+{
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+	{
+		return 0;
+	}
+	return ru.ru_maxrss;
+}
+
+double benchPercentile(Array<double>& samples, double pct)
+{
+	int n = samples.size();
+	if (n == 0)
+	{
+		return 0.0;
+	}
+	std::sort(&samples[0], &samples[0] + n);
+	int i = (int)(pct / 100.0 * (n - 1) + 0.5);
+	return samples[MIN(MAX(i, 0), n - 1)];
+}
+
+void benchLevels(int argc, char** argv, Levels& levels)
+{
+	if (argc == 0)
+	{
+		levels.addPath(DEFAULT_LEVEL_PATH);
+	}
+	for (int i=0; i<argc; i++)
+	{
+		levels.addPath(argv[i]);
+	}
+}
+
+bool benchIntArg(int argc, char** argv, int& i, const char* flag, int& value)
+{
+	if (strcmp(argv[i], flag) == 0 && i+1 < argc)
+	{
+		value = atoi(argv[++i]);
+		return true;
+	}
+	return false;
+}
+
+static void usage(const char* prog)
+{
+	fprintf(stderr, "usage: %s <suite> [args]\n", prog);
+	for (int i=0; i<(int)ARRAY_SIZE(s_suites); i++)
+	{
+		fprintf(stderr, "  %s %s\n", s_suites[i].name, s_suites[i].usage);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* name = argc > 1 ? argv[1] : "levels";
+	for (int i=0; i<(int)ARRAY_SIZE(s_suites); i++)
+	{
+		if (strcmp(name, s_suites[i].name) == 0)
+		{
+			int skip = argc > 1 ? 2 : 1;
+			return s_suites[i].run(argc - skip, argv + skip);
+		}
+	}
+	usage(argv[0]);
+	return 1;
+}
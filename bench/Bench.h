@@ -0,0 +1,51 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <cstdio>
+#include "Array.h"
+#include "Levels.h"
+
+// numpty-bench: headless timing harness for the simulation core. Each suite
+// is a function taking its own argument list and returning a process exit
+// code; suites are listed in Bench.cpp.
+
+struct BenchSuite
+{
+	const char* name;
+	const char* usage;
+	int (*run)(int argc, char** argv);
+};
+
+// Monotonic wall clock in seconds.
+double benchNow();
+
+// Peak resident set size of the process in kilobytes.
+long benchPeakRSS();
+
+// Percentile (0..100) of a set of samples; sorts the samples in place.
+double benchPercentile(Array<double>& samples, double pct);
+
+// Adds the .nph files and directories named on the command line to levels,
+// or the bundled level directory when none are given.
+void benchLevels(int argc, char** argv, Levels& levels);
+
+// Integer option of the form "-x N"; advances i past the value.
+bool benchIntArg(int argc, char** argv, int& i, const char* flag, int& value);
+
+#endif //__BENCH_H__
@@ -0,0 +1,184 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+
+#include <string.h>
+
+#include "Bench.h"
+#include <Box2D/Box2D.h>
+
+// Broad-phase cost against proxy count. N boxes drift around a square whose
+// area grows with N, so each box keeps about the same number of neighbours;
+// every frame all proxies are moved and the pairs committed. Sweep and
+// prune stops at b2_maxProxies, the dynamic tree carries on. A small -s
+// packs the boxes tighter to load the sweep-and-prune pair manager.
+
+class CountingPairs : public b2PairCallback
+{
+public:
+	CountingPairs() : m_pairs(0), m_added(0) {}
+
+	void* PairAdded(void* proxyUserData1, void* proxyUserData2)
+	{
+		m_pairs++;
+		m_added++;
+		return this;
+	}
+
+	void PairRemoved(void* proxyUserData1, void* proxyUserData2, void* pairUserData)
+	{
+		m_pairs--;
+	}
+
+	int m_pairs;
+	int m_added;
+};
+
+struct Drifter
+{
+	b2Vec2 pos;
+	b2Vec2 vel;
+	int32 proxyId;
+};
+
+static float32 randomRange(unsigned& seed, float32 lo, float32 hi)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return lo + (hi - lo) * (float32)(seed >> 8) / (float32)(1 << 24);
+}
+
+static b2AABB boxAt(const b2Vec2& p)
+{
+	const float32 extent = 0.5f;
+	b2AABB aabb;
+	aabb.minVertex.Set(p.x - extent, p.y - extent);
+	aabb.maxVertex.Set(p.x + extent, p.y + extent);
+	return aabb;
+}
+
+// Returns microseconds per frame, or a negative value if the proxies do
+// not fit.
+static double runBroadPhase(b2BroadPhaseType type, int count, int frames, float32 spread,
+							int& pairs, int& added, b2PairStats* stats)
+{
+	const float32 side = spread * sqrtf((float32)count);
+	b2AABB worldAABB;
+	worldAABB.minVertex.Set(-1.0f, -1.0f);
+	worldAABB.maxVertex.Set(side + 1.0f, side + 1.0f);
+
+	CountingPairs callback;
+	b2BroadPhaseInterface* broadPhase;
+	if (type == b2_dynamicTree)
+	{
+		broadPhase = new b2TreeBroadPhase(worldAABB, &callback);
+	}
+	else
+	{
+		if (count > b2_maxProxies)
+		{
+			return -1.0;
+		}
+		broadPhase = new b2BroadPhase(worldAABB, &callback);
+	}
+
+	unsigned seed = 12345;
+	Drifter* drifters = new Drifter[count];
+	for (int i=0; i<count; i++)
+	{
+		Drifter& d = drifters[i];
+		d.pos.Set(randomRange(seed, 0.0f, side), randomRange(seed, 0.0f, side));
+		d.vel.Set(randomRange(seed, -0.05f, 0.05f), randomRange(seed, -0.05f, 0.05f));
+		d.proxyId = broadPhase->CreateProxy(boxAt(d.pos), &drifters[i]);
+	}
+	broadPhase->Commit();
+
+	double t0 = benchNow();
+	for (int f=0; f<frames; f++)
+	{
+		for (int i=0; i<count; i++)
+		{
+			Drifter& d = drifters[i];
+			d.pos += d.vel;
+			if (d.pos.x < 0.0f || d.pos.x > side) d.vel.x = -d.vel.x;
+			if (d.pos.y < 0.0f || d.pos.y > side) d.vel.y = -d.vel.y;
+			broadPhase->MoveProxy(d.proxyId, boxAt(d.pos));
+		}
+		broadPhase->Commit();
+	}
+	double t = benchNow() - t0;
+
+	pairs = broadPhase->GetPairCount();
+	added = callback.m_added;
+	b2Assert(pairs == callback.m_pairs);
+	if (type == b2_sweepAndPrune)
+	{
+		((b2BroadPhase*)broadPhase)->m_pairManager.GetStats(stats);
+	}
+
+	for (int i=0; i<count; i++)
+	{
+		broadPhase->DestroyProxy(drifters[i].proxyId);
+	}
+	b2Assert(callback.m_pairs == 0);
+
+	delete broadPhase;
+	delete [] drifters;
+	return t * 1e6 / frames;
+}
+
+int benchBroadPhase(int argc, char** argv)
+{
+	int maxCount = 16384, frames = 200, spread = 4;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", maxCount)
+			&& !benchIntArg(argc, argv, i, "-f", frames)
+			&& !benchIntArg(argc, argv, i, "-s", spread))
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	printf("%d frames per run, %d units of spread\n", frames, spread);
+	printf("%7s %12s %8s %13s %8s %8s\n",
+		   "proxies", "sap us/frame", "pairs", "tree us/frame", "pairs", "adds");
+
+	b2PairStats stats;
+	memset(&stats, 0, sizeof(stats));
+	for (int n=256; n<=maxCount; n*=2)
+	{
+		int sapPairs = 0, sapAdded = 0, treePairs = 0, treeAdded = 0;
+		double sap = runBroadPhase(b2_sweepAndPrune, n, frames, (float32)spread, sapPairs, sapAdded, &stats);
+		double tree = runBroadPhase(b2_dynamicTree, n, frames, (float32)spread, treePairs, treeAdded, &stats);
+		if (sap < 0.0)
+		{
+			printf("%7d %12s %8s %13.1f %8d %8d\n", n, "-", "-", tree, treePairs, treeAdded);
+		}
+		else
+		{
+			printf("%7d %12.1f %8d %13.1f %8d %8d\n", n, sap, sapPairs, tree, treePairs, treeAdded);
+		}
+	}
+
+	// Pair manager state after the largest sweep-and-prune run.
+	printf("sap pairs: %d of %d, table %d buckets (%d used), probes mean %.2f max %d, grown %d times, %d KB\n",
+		   stats.pairCount, stats.pairCapacity, stats.tableCapacity, stats.usedBuckets,
+		   stats.meanProbes, stats.maxProbes, stats.growCount, stats.byteCount / 1024);
+	printf("peak rss: %ld KB\n", benchPeakRSS());
+	return 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Closed strokes as an outline chain against the same strokes filled with
+// convex polygons (Stroke::s_fillClosed). The game only fills strokes the
+// player draws, so level strokes are filled here with FILL_ALL to stand in
+// for drawn ones of the same shape. Every level is stepped once each way
+// from a fresh load. Filling is there so nothing ends up inside a loop the
+// player draws, not to save work: the pieces usually outnumber the one
+// chain they replace. So besides the shape count, step time and average
+// number of touching contacts, each run reports how many bodies have their
+// centre inside a closed stroke at the end without having started there.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+struct ClosedRun
+{
+	int filled;
+	int shapes;
+	int trapped;
+	double seconds;
+	double contacts;
+};
+
+// An outline is tested as the polygon its chain would close to, so a body
+// inside the loop counts whether or not it touches the chain.
+static bool inside(b2Shape* shape, const b2Vec2& p)
+{
+	if (shape->GetType() != e_chainShape)
+	{
+		return shape->TestPoint(p);
+	}
+	b2ChainShape* chain = (b2ChainShape*)shape;
+	int n = chain->GetSegmentCount() + 1;
+	bool in = false;
+	b2Vec2 a = chain->GetVertex(n-1);
+	for (int i=0; i<n; i++)
+	{
+		b2Vec2 b = chain->GetVertex(i);
+		if ((a.y > p.y) != (b.y > p.y)
+			&& p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+		{
+			in = !in;
+		}
+		a = b;
+	}
+	return in;
+}
+
+// Marks the strokes whose dynamic body has its centre inside one of the
+// closed strokes it is free to collide with; a stroke jointed onto another
+// may overlap it. Returns how many there are.
+static int markInside(Scene& scene, const Array<int>& closed, Array<bool>& in)
+{
+	int count = 0;
+	in.empty();
+	for (int i=0; i<scene.strokes().size(); i++)
+	{
+		in.append(false);
+		b2Body* body = scene.strokes()[i]->body();
+		if (!body || body->IsStatic())
+		{
+			continue;
+		}
+		b2Vec2 p = body->GetCenterPosition();
+		for (int c=0; c<closed.size(); c++)
+		{
+			b2Body* outer = scene.strokes()[closed[c]]->body();
+			if (outer == body || !outer || body->IsConnected(outer))
+			{
+				continue;
+			}
+			for (b2Shape* s = outer->GetShapeList(); s && !in[i]; s = s->GetNext())
+			{
+				in[i] = inside(s, p);
+			}
+			if (in[i])
+			{
+				count++;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+// Steps a fresh load of file. The strokes filled are appended to closed,
+// and bodies that end up inside the strokes listed in it are counted.
+static bool runLevel(Scene& scene, const std::string& file, int steps,
+					 Array<int>& closed, ClosedRun& run)
+{
+	if (!scene.load(file))
+	{
+		return false;
+	}
+	scene.activateAll();
+
+	run.filled = 0;
+	run.shapes = 0;
+	for (int i=0; i<scene.strokes().size(); i++)
+	{
+		Stroke* stroke = scene.strokes()[i];
+		if (stroke->body())
+		{
+			if (stroke->filled())
+			{
+				run.filled++;
+				closed.append(i);
+			}
+			for (b2Shape* s = stroke->body()->GetShapeList(); s; s = s->GetNext())
+			{
+				run.shapes++;
+			}
+		}
+	}
+
+	Array<bool> before, after;
+	markInside(scene, closed, before);
+
+	run.seconds = 0.0;
+	run.contacts = 0.0;
+	for (int s=0; s<steps; s++)
+	{
+		double t0 = benchNow();
+		scene.step();
+		run.seconds += benchNow() - t0;
+
+		for (b2Contact* c = scene.world()->GetContactList(); c; c = c->GetNext())
+		{
+			run.contacts += c->GetManifoldCount();
+		}
+	}
+	run.contacts /= steps;
+	markInside(scene, closed, after);
+	run.trapped = 0;
+	for (int i=0; i<after.size(); i++)
+	{
+		if (after[i] && !before[i])
+		{
+			run.trapped++;
+		}
+	}
+	return true;
+}
+
+int benchClosed(int argc, char** argv)
+{
+	int thousands = 2;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-k", thousands))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int steps = thousands * 1000;
+	Scene scene;
+	double outlineTotal = 0.0, filledTotal = 0.0;
+	int outlineTrapped = 0, filledTrapped = 0;
+
+	printf("%-24s %6s %15s %15s %15s %15s\n", "level", "filled",
+		   "shapes", "us/step", "manifolds", "trapped");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		// Fill first to learn which strokes are closed, then check the
+		// same strokes as outlines.
+		ClosedRun outline, filled;
+		Array<int> closed;
+		Stroke::s_fillClosed = Stroke::FILL_ALL;
+		bool ok = runLevel(scene, levels.levelFile(l), steps, closed, filled);
+		Stroke::s_fillClosed = Stroke::FILL_NONE;
+		ok = ok && runLevel(scene, levels.levelFile(l), steps, closed, outline);
+		Stroke::s_fillClosed = Stroke::FILL_DRAWN;
+		if (!ok)
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		outlineTotal += outline.seconds;
+		filledTotal += filled.seconds;
+
+		outlineTrapped += outline.trapped;
+		filledTrapped += filled.trapped;
+
+		printf("%-24s %6d %7d -> %-5d %7.1f -> %-5.1f %7.1f -> %-5.1f %7d -> %-5d\n",
+			   baseName(levels.levelFile(l)), filled.filled,
+			   outline.shapes, filled.shapes,
+			   outline.seconds / steps * 1e6, filled.seconds / steps * 1e6,
+			   outline.contacts, filled.contacts,
+			   outline.trapped, filled.trapped);
+	}
+
+	double perStep = 1e6 / (steps * levels.numLevels());
+	printf("%-24s %6s %15s %7.1f -> %-5.1f %15s %7d -> %-5d\n", "total", "", "",
+		   outlineTotal * perStep, filledTotal * perStep, "",
+		   outlineTrapped, filledTrapped);
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string.h>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Stroke::distanceTo on long strokes through the segment tree against
+// measuring every segment (Stroke::s_segmentTree). The strokes are random
+// walks turned to random angles, the query points fall around their boxes,
+// and both ways must give the same distance for every point.
+
+static unsigned int s_seed;
+
+static int benchRand(int n)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (int)((s_seed >> 16) % (unsigned int)n);
+}
+
+struct DistanceQuery
+{
+	int stroke;
+	Vec2 pt;
+};
+
+static double runQueries(Scene& scene, const Array<DistanceQuery>& queries, Array<float>& results)
+{
+	results.empty();
+	double t0 = benchNow();
+	for (int q=0; q<queries.size(); q++)
+	{
+		results.append(scene.strokes()[queries[q].stroke]->distanceTo(queries[q].pt));
+	}
+	return benchNow() - t0;
+}
+
+int benchDistance(int argc, char** argv)
+{
+	int count = 20, points = 400, queries = 20000;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", count)
+			&& !benchIntArg(argc, argv, i, "-p", points)
+			&& !benchIntArg(argc, argv, i, "-q", queries))
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	count = MAX(count, 1);
+	points = MAX(points, 2);
+
+	Scene scene;
+	s_seed = 1;
+	for (int i=0; i<count; i++)
+	{
+		Vec2 p(benchRand(CANVAS_WIDTH), benchRand(CANVAS_HEIGHT));
+		Path path;
+		path & p;
+		for (int k=1; k<points; k++)
+		{
+			p += Vec2(benchRand(9) - 4, benchRand(9) - 4);
+			path & p;
+		}
+		scene.newStroke(path);
+	}
+	scene.activateAll();
+
+	for (int i=0; i<count; i++)
+	{
+		b2Body* body = scene.strokes()[i]->body();
+		if (body)
+		{
+			float angle = benchRand(6283) * 0.001f;
+			body->SetOriginPosition(body->GetOriginPosition(), angle);
+		}
+	}
+
+	Array<DistanceQuery> qs;
+	int segments = 0;
+	for (int i=0; i<count; i++)
+	{
+		segments += scene.strokes()[i]->numPoints() - 1;
+	}
+	for (int q=0; q<queries; q++)
+	{
+		DistanceQuery dq;
+		dq.stroke = benchRand(count);
+		Rect r = scene.strokes()[dq.stroke]->bbox();
+		int w = r.br.x - r.tl.x + 40, h = r.br.y - r.tl.y + 40;
+		dq.pt = Vec2(r.tl.x - 20 + benchRand(MAX(w, 1)), r.tl.y - 20 + benchRand(MAX(h, 1)));
+		qs.append(dq);
+	}
+
+	Array<float> tree, scan;
+	Stroke::s_segmentTree = true;
+	double tTree = runQueries(scene, qs, tree);
+	Stroke::s_segmentTree = false;
+	double tScan = runQueries(scene, qs, scan);
+	Stroke::s_segmentTree = true;
+
+	int mismatches = 0;
+	for (int q=0; q<queries; q++)
+	{
+		if (tree[q] != scan[q])
+		{
+			mismatches++;
+		}
+	}
+
+	printf("%d strokes, %.0f segments each, %d queries\n", count, (double)segments / count, queries);
+	printf("%-8s %10s %10s %8s\n", "", "tree(us)", "scan(us)", "speedup");
+	printf("%-8s %10.3f %10.3f %7.1fx\n", "distance", tTree * 1e6 / queries, tScan * 1e6 / queries, tScan / tTree);
+	printf("mismatches: %d\n", mismatches);
+	return mismatches ? 1 : 0;
+}
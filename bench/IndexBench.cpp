@@ -0,0 +1,192 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string.h>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Joint discovery and picking on a synthetic level of many short strokes,
+// through the scene's stroke index against the full scans it replaced.
+// The strokes are laid end to end in rows across the screen so each joins
+// its neighbours; both ways must make the same joints in the same order
+// and pick the same strokes.
+
+static unsigned int s_seed;
+
+static int benchRand(int n)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (int)((s_seed >> 16) % (unsigned int)n);
+}
+
+static void makeLevel(Scene& scene, int count)
+{
+	const int width = 20;
+	int cols = CANVAS_WIDTH / width;
+	int rows = (count + cols - 1) / cols;
+	int pitch = CANVAS_HEIGHT / (rows + 1);
+
+	s_seed = 1;
+	for (int i=0; i<count; i++)
+	{
+		Vec2 start((i % cols) * width, (i / cols + 1) * pitch);
+		Vec2 mid(start.x + width / 2, start.y - 2 - benchRand(MAX(pitch / 2, 1)));
+		Vec2 end(start.x + width, start.y);
+		Path p;
+		p & start & mid & end;
+		scene.newStroke(p);
+	}
+}
+
+// What Scene::createJoints did before the index: every other stroke, both
+// ways round, last stroke first.
+static void scanJoints(Scene& scene)
+{
+	Array<Stroke*>& strokes = scene.strokes();
+	for (int i=0; i<strokes.size(); i++)
+	{
+		strokes[i]->createBodies(*scene.world());
+	}
+	for (int i=0; i<strokes.size(); i++)
+	{
+		for (int j=strokes.size()-1; j>=0; j--)
+		{
+			if (strokes[i] != strokes[j])
+			{
+				strokes[i]->maybeCreateJoint(*scene.world(), strokes[j]);
+				strokes[j]->maybeCreateJoint(*scene.world(), strokes[i]);
+			}
+		}
+	}
+}
+
+static int scanPick(Scene& scene, const Vec2& pt, float max)
+{
+	Array<Stroke*>& strokes = scene.strokes();
+	int best = -1;
+	for (int i=0; i<strokes.size(); i++)
+	{
+		float d = strokes[i]->distanceTo(pt);
+		if (d < max)
+		{
+			max = d;
+			best = i;
+		}
+	}
+	return best;
+}
+
+static bool sameJoints(Scene& a, Scene& b, int& count)
+{
+	count = 0;
+	b2Joint* ja = a.world()->GetJointList();
+	b2Joint* jb = b.world()->GetJointList();
+	for (; ja && jb; ja = ja->GetNext(), jb = jb->GetNext(), count++)
+	{
+		int a1 = a.strokes().indexOf((Stroke*)ja->GetBody1()->GetUserData());
+		int a2 = a.strokes().indexOf((Stroke*)ja->GetBody2()->GetUserData());
+		int b1 = b.strokes().indexOf((Stroke*)jb->GetBody1()->GetUserData());
+		int b2 = b.strokes().indexOf((Stroke*)jb->GetBody2()->GetUserData());
+		b2Vec2 pa = ja->GetAnchor1();
+		b2Vec2 pb = jb->GetAnchor1();
+		if (a1 != b1 || a2 != b2 || pa.x != pb.x || pa.y != pb.y)
+		{
+			return false;
+		}
+	}
+	return ja == NULL && jb == NULL;
+}
+
+int benchIndex(int argc, char** argv)
+{
+	int count = 1200, queries = 20000;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", count)
+			&& !benchIntArg(argc, argv, i, "-q", queries))
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (count + 1 > b2_maxProxies)
+	{
+		fprintf(stderr, "%d strokes is more than the broad-phase holds\n", count);
+		return 1;
+	}
+
+	Scene indexed, scanned;
+	makeLevel(indexed, count);
+	makeLevel(scanned, count);
+
+	double t0 = benchNow();
+	indexed.activateAll();
+	double tIndexed = benchNow() - t0;
+
+	t0 = benchNow();
+	scanJoints(scanned);
+	double tScanned = benchNow() - t0;
+
+	int joints;
+	bool same = sameJoints(indexed, scanned, joints);
+
+	printf("%d strokes, %d joints\n", count, joints);
+	printf("%-12s %12s %12s %8s\n", "", "indexed(ms)", "scan(ms)", "speedup");
+	printf("%-12s %12.2f %12.2f %7.1fx\n", "activateAll", tIndexed * 1e3, tScanned * 1e3, tScanned / tIndexed);
+
+	// Picks at random points over the bounds, half of them on a stroke
+	// end so most find something.
+	Array<Vec2> points;
+	s_seed = 7;
+	for (int q=0; q<queries; q++)
+	{
+		if (q & 1)
+		{
+			points.append(Vec2(benchRand(CANVAS_WIDTH), benchRand(CANVAS_HEIGHT)));
+		}
+		else
+		{
+			Rect r = indexed.strokes()[benchRand(count)]->bbox();
+			points.append(Vec2(r.tl.x + benchRand(3), r.br.y - benchRand(3)));
+		}
+	}
+
+	Array<int> picks;
+	t0 = benchNow();
+	for (int q=0; q<queries; q++)
+	{
+		picks.append(indexed.strokes().indexOf(indexed.strokeAtPoint(points[q], SELECT_TOLERANCE)));
+	}
+	tIndexed = benchNow() - t0;
+
+	int found = 0;
+	t0 = benchNow();
+	for (int q=0; q<queries; q++)
+	{
+		int pick = scanPick(scanned, points[q], SELECT_TOLERANCE);
+		same = same && pick == picks[q];
+		found += pick >= 0;
+	}
+	tScanned = benchNow() - t0;
+
+	printf("%-12s %12.2f %12.2f %7.1fx   (%d of %d hit, us per pick)\n", "pick",
+		   tIndexed * 1e6 / queries, tScanned * 1e6 / queries, tScanned / tIndexed, found, queries);
+	printf("same result: %s\n", same ? "yes" : "NO");
+	printf("peak rss: %ld KB\n", benchPeakRSS());
+	return same ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "Scene.h"
+#include <Box2D/Box2D.h>
+
+// Scaling of the island solver over worker threads. The scene is a row of
+// separate box pyramids on one static ground, each pyramid its own island,
+// with sleeping disabled so every island is solved every step. The same
+// scene is stepped once per worker count (1, 2, 4, ... up to -j) and the
+// final body state must hash the same for all of them. Every level is then
+// run the same way, with joints, sleeping and static strokes shared
+// between islands, and must hash the same too.
+
+static b2World* makePiles(int piles, int rows)
+{
+	const float32 box = 0.5f;
+	const float32 spacing = (rows + 2) * 2.0f * box;
+
+	b2AABB worldAABB;
+	worldAABB.minVertex.Set(-spacing, -10.0f);
+	worldAABB.maxVertex.Set(piles * spacing + spacing, rows * 2.0f * box + 10.0f);
+	b2World* world = new b2World(worldAABB, b2Vec2(0.0f, -10.0f), false);
+
+	b2BoxDef groundDef;
+	groundDef.extents.Set(piles * spacing * 0.5f + spacing, 1.0f);
+	b2BodyDef ground;
+	ground.position.Set(piles * spacing * 0.5f, -1.0f);
+	ground.AddShape(&groundDef);
+	world->CreateBody(&ground);
+
+	b2BoxDef boxDef;
+	boxDef.extents.Set(box, box);
+	boxDef.density = 1.0f;
+	boxDef.friction = 0.6f;
+
+	for (int p=0; p<piles; p++)
+	{
+		for (int r=0; r<rows; r++)
+		{
+			for (int i=0; i<rows-r; i++)
+			{
+				b2BodyDef bd;
+				bd.AddShape(&boxDef);
+				bd.position.Set(p * spacing + (2*i + r) * 1.05f * box,
+								box + r * 2.0f * box);
+				world->CreateBody(&bd);
+			}
+		}
+	}
+	return world;
+}
+
+static unsigned long long hashBodies(b2World* world)
+{
+	unsigned long long h = 0;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetOriginPosition();
+		float32 a = b->GetRotation();
+		unsigned int u;
+		memcpy(&u, &p.x, 4); h = h * 31 + u;
+		memcpy(&u, &p.y, 4); h = h * 31 + u;
+		memcpy(&u, &a, 4); h = h * 31 + u;
+	}
+	return h;
+}
+
+// Steps each level with every worker count; true if all of them agree.
+static bool levelsMatch(Levels& levels, int steps, int workers)
+{
+	Scene scene;
+	bool match = true;
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		unsigned long long expected = 0;
+		for (int w=1; ; w = MIN(w * 2, workers))
+		{
+			scene.load(levels.levelFile(l));
+			scene.world()->SetWorkerCount(w);
+			scene.activateAll();
+			for (int s=0; s<steps; s++)
+			{
+				scene.step();
+			}
+
+			unsigned long long h = hashBodies(scene.world());
+			if (w == 1)
+			{
+				expected = h;
+			}
+			else if (h != expected)
+			{
+				printf("%s differs with %d workers\n", levels.levelFile(l).c_str(), w);
+				match = false;
+			}
+
+			if (w == workers)
+			{
+				break;
+			}
+		}
+	}
+	return match;
+}
+
+int benchIslands(int argc, char** argv)
+{
+	int piles = 48, rows = 6, steps = 1000;
+	int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-p", piles)
+			&& !benchIntArg(argc, argv, i, "-r", rows)
+			&& !benchIntArg(argc, argv, i, "-k", steps)
+			&& !benchIntArg(argc, argv, i, "-j", workers))
+		{
+			paths.append(argv[i]);
+		}
+	}
+	workers = MAX(1, MIN(workers, b2_maxWorkers));
+
+	int bodies = piles * rows * (rows + 1) / 2;
+	if (bodies + 1 > b2_maxProxies)
+	{
+		fprintf(stderr, "%d boxes is more than the broad-phase holds\n", bodies);
+		return 1;
+	}
+
+	printf("%d piles of %d boxes, %d steps\n", piles, bodies / piles, steps);
+	printf("%7s %9s %9s %8s %16s\n", "workers", "ms/step", "steps/s", "speedup", "state");
+
+	double serial = 0.0;
+	unsigned long long expected = 0;
+	bool deterministic = true;
+	for (int w=1; ; w = MIN(w * 2, workers))
+	{
+		b2World* world = makePiles(piles, rows);
+		world->SetWorkerCount(w);
+
+		double t0 = benchNow();
+		for (int s=0; s<steps; s++)
+		{
+			world->Step(1.0f / 60.0f, 10);
+		}
+		double t = benchNow() - t0;
+
+		unsigned long long h = hashBodies(world);
+		if (w == 1)
+		{
+			serial = t;
+			expected = h;
+		}
+		deterministic = deterministic && h == expected;
+
+		printf("%7d %9.3f %9.0f %7.2fx %016llx\n", w, t * 1e3 / steps, steps / t, serial / t, h);
+		delete world;
+
+		if (w == workers)
+		{
+			break;
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	bool levelsSame = levelsMatch(levels, steps, workers);
+	printf("%d levels match: %s\n", levels.numLevels(), levelsSame ? "yes" : "NO");
+	deterministic = deterministic && levelsSame;
+
+	printf("deterministic: %s\n", deterministic ? "yes" : "NO");
+	printf("peak rss: %ld KB\n", benchPeakRSS());
+	return deterministic ? 0 : 1;
+}
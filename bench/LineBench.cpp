@@ -0,0 +1,143 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+
+#include "Bench.h"
+#include "CanvasSoft.h"
+#include "PixelLanes.h"
+
+// Thick strokes drawn into the software canvas a row of pixels at a
+// time (with SIMD blending) against pixel by pixel, as CanvasSoft used
+// to. The two must leave the same pixels behind. Throughput is counted
+// in pixels written, three per step.
+
+static unsigned int s_seed;
+
+static int benchRand(int n)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (int)((s_seed >> 16) % (unsigned int)n);
+}
+
+// Random paper so that every blend has something to mix with.
+static void noise(CanvasSoft& canvas, unsigned int seed)
+{
+	s_seed = seed;
+	Uint16* p = (Uint16*)canvas.scale(1);
+	for (int i=0; i<CANVAS_WIDTH*CANVAS_HEIGHT; i++)
+	{
+		p[i] = (Uint16)(benchRand(256) << 8 | benchRand(256));
+	}
+}
+
+struct Line
+{
+	Vec2 a, b;
+	int  colour;
+};
+
+// flat: the lines run no steeper than 1 in 16, so they are drawn as runs.
+static void makeLines(Array<Line>& lines, int n, int maxLength, bool flat)
+{
+	s_seed = 99;
+	lines.empty();
+	for (int i=0; i<n; i++)
+	{
+		Line l;
+		l.a = Vec2(2 + benchRand(CANVAS_WIDTH-4), 2 + benchRand(CANVAS_HEIGHT-4));
+		int dx = benchRand(2*maxLength+1) - maxLength;
+		int dy = benchRand(2*maxLength+1) - maxLength;
+		if (flat) dy /= 16;
+		l.b = Vec2(MAX(2, MIN(CANVAS_WIDTH-3, l.a.x+dx)), MAX(2, MIN(CANVAS_HEIGHT-3, l.a.y+dy)));
+		l.colour = benchRand(0x10000);
+		lines.append(l);
+	}
+}
+
+static long linePixels(const Array<Line>& lines)
+{
+	long n = 0;
+	for (int i=0; i<lines.size(); i++)
+	{
+		n += 3 * MAX(ABS(lines[i].b.x - lines[i].a.x), ABS(lines[i].b.y - lines[i].a.y));
+	}
+	return n;
+}
+
+static double drawLines(CanvasSoft& canvas, const Array<Line>& lines, int repeats)
+{
+	Path path;
+	double t0 = benchNow();
+	for (int r=0; r<repeats; r++)
+	{
+		for (int i=0; i<lines.size(); i++)
+		{
+			path.empty();
+			path.append(lines[i].a);
+			path.append(lines[i].b);
+			canvas.drawPath(path, lines[i].colour, true);
+		}
+	}
+	return benchNow() - t0;
+}
+
+int benchLines(int argc, char** argv)
+{
+	int count = 20000;
+	int length = 200;
+	int repeats = 5;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", count)
+			&& !benchIntArg(argc, argv, i, "-l", length)
+			&& !benchIntArg(argc, argv, i, "-r", repeats))
+		{
+			fprintf(stderr, "unknown argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	CanvasSoft pixels(CANVAS_WIDTH, CANVAS_HEIGHT);
+	CanvasSoft spans(CANVAS_WIDTH, CANVAS_HEIGHT);
+	Array<Line> lines;
+	const int bytes = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
+	bool ok = true;
+
+	printf("%-22s %10s %14s %14s %8s\n", "lines", "Mpixels", "pixels Mpix/s", "spans Mpix/s", "match");
+	for (int kind=0; kind<2; kind++)
+	{
+		bool flat = kind == 0;
+		makeLines(lines, count, length, flat);
+		long n = linePixels(lines) * repeats;
+
+		noise(pixels, 7);
+		CanvasSoft::s_spanLines = false;
+		double tPixels = drawLines(pixels, lines, repeats);
+
+		noise(spans, 7);
+		CanvasSoft::s_spanLines = true;
+		double tSpans = drawLines(spans, lines, repeats);
+
+		bool match = memcmp(pixels.scale(1), spans.scale(1), bytes) == 0;
+		ok &= match;
+		printf("%-22s %10.1f %14.1f %14.1f %8s\n",
+			   flat ? "flat" : "any direction",
+			   n * 1e-6, n * 1e-6 / tPixels, n * 1e-6 / tSpans, match ? "yes" : "NO");
+	}
+	printf("pixels to a SIMD blend: %d\n", pix_simdWidth);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Plays each level twice in step, drawing one copy into a software canvas
+// the old way (clear and redraw the whole screen every frame) and the other
+// through Scene::dirtyRegion, redrawing only the dirty rectangles. The two
+// canvases are compared after every frame and must match to the pixel.
+
+static const Rect SCREEN_RECT(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+// Pixels of the region that are on the screen.
+static int screenArea(const DirtyRegion& region)
+{
+	int a = 0;
+	for (int i=0; i<region.size(); i++)
+	{
+		const Rect& r = region.rect(i);
+		int w = MIN(r.br.x, SCREEN_RECT.br.x) - MAX(r.tl.x, 0) + 1;
+		int h = MIN(r.br.y, SCREEN_RECT.br.y) - MAX(r.tl.y, 0) + 1;
+		if (w > 0 && h > 0) a += w * h;
+	}
+	return a;
+}
+
+int benchRedraw(int argc, char** argv)
+{
+	int frames = 600;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-f", frames))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int stepsPerFrame = ITERATION_RATE / RENDER_RATE;
+	const int bytes = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
+	CanvasSoft fullCanvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	CanvasSoft partCanvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	DirtyRegion fullRegion, partRegion;
+	double fullTotal = 0.0, partTotal = 0.0, areaTotal = 0.0;
+	int framesTotal = 0, mismatches = 0;
+
+	printf("%-24s %7s %9s %9s %9s %6s\n", "level", "strokes", "full(us)", "part(us)", "redrawn", "rects");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		Scene full, part;
+		if (!full.load(levels.levelFile(l)) || !part.load(levels.levelFile(l)))
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		full.activateAll();
+		part.activateAll();
+
+		double fullTime = 0.0, partTime = 0.0, area = 0.0;
+		int rects = 0, levelMismatches = 0;
+		for (int f=0; f<frames; f++)
+		{
+			for (int s=0; s<stepsPerFrame; s++)
+			{
+				full.step();
+				part.step();
+			}
+
+			double t0 = benchNow();
+			full.dirtyRegion(fullRegion);
+			full.draw(&fullCanvas, SCREEN_RECT);
+			double t1 = benchNow();
+			part.dirtyRegion(partRegion);
+			if (f == 0)
+			{
+				// Nothing on the canvas from this level yet.
+				partRegion.clear();
+				partRegion.add(SCREEN_RECT);
+			}
+			part.draw(&partCanvas, partRegion);
+			double t2 = benchNow();
+
+			fullTime += t1 - t0;
+			partTime += t2 - t1;
+			area += screenArea(partRegion);
+			rects += partRegion.size();
+			if (memcmp(fullCanvas.scale(1), partCanvas.scale(1), bytes) != 0)
+			{
+				levelMismatches++;
+			}
+		}
+
+		printf("%-24s %7d %9.1f %9.1f %8.1f%% %6.1f%s\n", baseName(levels.levelFile(l)),
+			   part.numStrokes(), fullTime * 1e6 / frames, partTime * 1e6 / frames,
+			   area * 100.0 / ((double)frames * CANVAS_WIDTH * CANVAS_HEIGHT),
+			   (double)rects / frames, levelMismatches ? "  MISMATCH" : "");
+		fullTotal += fullTime;
+		partTotal += partTime;
+		areaTotal += area;
+		framesTotal += frames;
+		mismatches += levelMismatches;
+	}
+
+	if (framesTotal)
+	{
+		printf("%-24s %7s %9.1f %9.1f %8.1f%%\n", "total", "",
+			   fullTotal * 1e6 / framesTotal, partTotal * 1e6 / framesTotal,
+			   areaTotal * 100.0 / ((double)framesTotal * CANVAS_WIDTH * CANVAS_HEIGHT));
+	}
+	if (mismatches)
+	{
+		printf("%d frames differ from a full redraw\n", mismatches);
+		return 1;
+	}
+	printf("all frames match a full redraw\n");
+	return 0;
+}
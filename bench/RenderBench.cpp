@@ -0,0 +1,117 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <string>
+
+#include "Bench.h"
+#include "CanvasRecorder.h"
+#include "Scene.h"
+
+// Records every frame each level draws through the headless Canvas and
+// reports what it would cost the GPU: draws, vertices, texture uploads
+// and overdraw per frame. The last frame is replayed into a software
+// canvas and its pixels hashed. Nothing here is timed, so two runs can
+// be compared line by line to catch a change in rendering cost.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+static unsigned int pixelHash(CanvasSoft& canvas)
+{
+	const unsigned char* p = (const unsigned char*)canvas.scale(1);
+	unsigned int h = 2166136261u;
+	for (int i=0; i<CANVAS_WIDTH*CANVAS_HEIGHT*2; i++)
+	{
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return h;
+}
+
+int benchRender(int argc, char** argv)
+{
+	int frames = 300;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-f", frames))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int stepsPerFrame = ITERATION_RATE / RENDER_RATE;
+	const Rect screen(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
+	Canvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	canvas.setClip(0, 0, CANVAS_WIDTH, CANVAS_HEIGHT);
+	CanvasRecorder recorder;
+	canvas.record(&recorder);
+	CanvasSoft replay(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+	printf("%-24s %6s %8s %7s %8s %8s %7s %8s\n", "level", "draws", "vertices",
+		   "uploads", "KB up", "overdraw", "cmd KB", "replay");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		Scene scene;
+		if (!scene.load(levels.levelFile(l)))
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		scene.activateAll();
+
+		RenderStats total;
+		memset(&total, 0, sizeof(total));
+		int cmdBytes = 0;
+		for (int f=0; f<frames; f++)
+		{
+			for (int s=0; s<stepsPerFrame; s++)
+			{
+				scene.step();
+			}
+			recorder.beginFrame();
+			scene.draw(&canvas, screen);
+			canvas.flush();
+
+			const RenderStats& st = recorder.stats();
+			total.draws += st.draws;
+			total.vertices += st.vertices;
+			total.uploads += st.uploads;
+			total.uploadBytes += st.uploadBytes;
+			total.overdraw += st.overdraw;
+			cmdBytes = MAX(cmdBytes, recorder.commandBytes());
+		}
+		recorder.replay(&replay);
+
+		printf("%-24s %6.2f %8.1f %7d %8d %8.3f %7.1f %08x\n", baseName(levels.levelFile(l)),
+			   (double)total.draws / frames, (double)total.vertices / frames,
+			   total.uploads, total.uploadBytes / 1024, total.overdraw / frames,
+			   cmdBytes / 1024.0, pixelHash(replay));
+	}
+	canvas.record(NULL);
+	return 0;
+}
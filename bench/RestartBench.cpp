@@ -0,0 +1,91 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Level restart latency, as Game::gotoLevel pays it: Scene::load (parse
+// the file, reset the world) against Scene::restart (rebuild from the
+// parsed copy), each followed by activateAll. A few steps run between
+// restarts so the world has contacts to throw away.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+int benchRestart(int argc, char** argv)
+{
+	int repeats = 50;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", repeats))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0 || repeats < 1)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	Scene scene;
+	Array<double> loads(repeats), restarts(repeats);
+	Array<double> allLoads, allRestarts;
+
+	printf("%-24s %7s %14s %14s\n", "level", "strokes", "load p50(us)", "restart p50(us)");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		const std::string& file = levels.levelFile(l);
+		loads.empty();
+		restarts.empty();
+		for (int r=0; r<repeats; r++)
+		{
+			double t0 = benchNow();
+			scene.load(file);
+			scene.activateAll();
+			double t1 = benchNow();
+			for (int s=0; s<10; s++) scene.step();
+
+			double t2 = benchNow();
+			scene.restart();
+			scene.activateAll();
+			double t3 = benchNow();
+			for (int s=0; s<10; s++) scene.step();
+
+			loads.append(t1 - t0);
+			restarts.append(t3 - t2);
+			allLoads.append(t1 - t0);
+			allRestarts.append(t3 - t2);
+		}
+
+		printf("%-24s %7d %14.1f %14.1f\n", baseName(file), scene.numStrokes(),
+			   benchPercentile(loads, 50) * 1e6, benchPercentile(restarts, 50) * 1e6);
+	}
+
+	printf("%-24s %7s %14.1f %14.1f\n", "total", "",
+		   benchPercentile(allLoads, 50) * 1e6, benchPercentile(allRestarts, 50) * 1e6);
+	return 0;
+}
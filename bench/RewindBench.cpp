@@ -0,0 +1,139 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string>
+#include <cstring>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Rewind recording: what it adds to Scene::step, how small the per-step
+// frames are, and whether resuming from the middle of the history and
+// stepping back up to the present lands every body where it was.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+static void bodyStates(b2World* world, Array<float>& states)
+{
+	states.empty();
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetCenterPosition();
+		states.append(p.x);
+		states.append(p.y);
+		states.append(b->GetRotation());
+	}
+}
+
+static double runSteps(Scene& scene, const std::string& file, int steps)
+{
+	scene.load(file);
+	scene.activateAll();
+	double t0 = benchNow();
+	for (int s=0; s<steps; s++) scene.step();
+	return benchNow() - t0;
+}
+
+int benchRewind(int argc, char** argv)
+{
+	int steps = 600;
+	int maxBytes = REWIND_BYTES;
+	int repeats = 3;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-s", steps)
+			&& !benchIntArg(argc, argv, i, "-m", maxBytes)
+			&& !benchIntArg(argc, argv, i, "-n", repeats))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0 || steps < 2 || repeats < 1)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	Scene scene;
+	Array<float> first, second;
+	double totalOff = 0, totalOn = 0, totalDelta = 0, totalBodySteps = 0;
+	int totalDiverged = 0;
+
+	printf("%-24s %8s %8s %9s %8s %9s %11s %9s\n", "level", "off(ms)", "on(ms)",
+		   "overhead", "B/body", "held(s)", "resume(ms)", "diverged");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		const std::string& file = levels.levelFile(l);
+
+		// Best of a few runs each way, interleaved.
+		double off = 1e9, on = 1e9;
+		for (int r=0; r<repeats; r++)
+		{
+			scene.rewind().configure(0, REWIND_KEY_STEPS);
+			off = b2Min(off, runSteps(scene, file, steps));
+			scene.rewind().configure(maxBytes, REWIND_KEY_STEPS);
+			on = b2Min(on, runSteps(scene, file, steps));
+		}
+
+		RewindStats stats = scene.rewind().stats();
+		bodyStates(scene.world(), first);
+
+		int back = b2Min(steps / 2, stats.frames - 1);
+		double t0 = benchNow();
+		bool resumed = scene.rewind().resume(scene, back);
+		double t1 = benchNow();
+		for (int s=0; s<back; s++) scene.step();
+		bodyStates(scene.world(), second);
+
+		int diverged = 0;
+		if (!resumed || first.size() != second.size())
+		{
+			diverged = first.size() / 3;
+		}
+		else
+		{
+			for (int i=0; i<first.size(); i+=3)
+			{
+				if (memcmp(&first[i], &second[i], 3 * sizeof(float)) != 0) diverged++;
+			}
+		}
+
+		totalOff += off;
+		totalOn += on;
+		totalDelta += stats.deltaBytes;
+		totalBodySteps += stats.bodySteps;
+		totalDiverged += diverged;
+
+		printf("%-24s %8.2f %8.2f %8.1f%% %8.2f %9.1f %11.2f %9d%s\n", baseName(file),
+			   off * 1e3, on * 1e3, (on / off - 1.0) * 100.0, stats.bytesPerBodyStep(),
+			   stats.frames / (float)ITERATION_RATE, (t1 - t0) * 1e3, diverged,
+			   resumed ? "" : " (resume failed)");
+	}
+
+	printf("%-24s %8.2f %8.2f %8.1f%% %8.2f %9s %11s %9d\n", "total",
+		   totalOff * 1e3, totalOn * 1e3, (totalOn / totalOff - 1.0) * 100.0,
+		   totalBodySteps > 0 ? totalDelta / totalBodySteps : 0.0, "", "", totalDiverged);
+	return 0;
+}
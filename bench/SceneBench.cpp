@@ -0,0 +1,122 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Replays every level through Scene::step the way Game::run drives it: a
+// frame is ITERATION_RATE/RENDER_RATE steps followed by dirtyArea() and a
+// draw into a headless canvas. The steps are timed one by one, the frames
+// (stroke transforms, dirty area and drawing) in total.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+int benchScene(int argc, char** argv)
+{
+	int thousands = 10;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-k", thousands))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	const int steps = thousands * 1000;
+	const int stepsPerFrame = ITERATION_RATE / RENDER_RATE;
+	Scene scene;
+	Canvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT);
+	Array<double> all(steps * levels.numLevels());
+	Array<double> times(steps);
+	double total = 0.0;
+	double frameTime = 0.0;
+	int frames = 0;
+
+	// Sum of b2World::GetProfile() over all steps.
+	double islands = 0.0, integrate = 0.0, broadphase = 0.0, collide = 0.0, positions = 0.0;
+	int rebuilds = 0;
+
+	printf("%-24s %7s %10s %9s %9s\n", "level", "strokes", "steps/s", "p50(us)", "p99(us)");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		if (!scene.load(levels.levelFile(l)))
+		{
+			fprintf(stderr, "failed to load %s\n", levels.levelFile(l).c_str());
+			continue;
+		}
+		scene.activateAll();
+
+		times.empty();
+		double levelTime = 0.0;
+		for (int s=0; s<steps; s++)
+		{
+			double t0 = benchNow();
+			scene.step();
+			double dt = benchNow() - t0;
+			times.append(dt);
+			all.append(dt);
+			levelTime += dt;
+
+			const b2Profile& p = scene.world()->GetProfile();
+			islands += p.islands;
+			integrate += p.integrate;
+			broadphase += p.broadphase;
+			collide += p.collide;
+			positions += p.positions;
+			rebuilds += p.islandRebuilds;
+
+			if ((s+1) % stepsPerFrame == 0)
+			{
+				t0 = benchNow();
+				scene.draw(&canvas, scene.dirtyArea());
+				frameTime += benchNow() - t0;
+				frames++;
+			}
+		}
+		total += levelTime;
+
+		printf("%-24s %7d %10.0f %9.1f %9.1f\n", baseName(levels.levelFile(l)),
+			   scene.numStrokes(), steps / levelTime,
+			   benchPercentile(times, 50) * 1e6, benchPercentile(times, 99) * 1e6);
+	}
+
+	printf("%-24s %7s %10.0f %9.1f %9.1f\n", "total", "", all.size() / total,
+		   benchPercentile(all, 50) * 1e6, benchPercentile(all, 99) * 1e6);
+
+	double perStep = 1000.0 / all.size();
+	printf("phase us/step: islands %.2f integrate %.2f broadphase %.2f collide %.2f positions %.2f\n",
+		   islands * perStep, integrate * perStep, broadphase * perStep, collide * perStep, positions * perStep);
+	printf("island rebuilds: %d of %d steps\n", rebuilds, all.size());
+	printf("frame us: %.2f\n", frames ? frameTime * 1e6 / frames : 0.0);
+	printf("peak rss: %ld KB\n", benchPeakRSS());
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string.h>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// Fitting long strokes to MULTI_VERTEX_LIMIT points: one budgeted pass
+// (Path::simplifyTo) against raising the threshold a pixel at a time and
+// simplifying again, as Stroke::process used to. Then the pen-up cost of
+// a stroke drawn point by point, simplified as it grows, against the same
+// stroke handed over whole.
+
+static unsigned int s_seed;
+
+static int benchRand(int n)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (int)((s_seed >> 16) % (unsigned int)n);
+}
+
+// Furthest any point of raw lies from the simplified line.
+static float simplifyError(const Path& raw, const Path& simple)
+{
+	float worst = 0.0f;
+	for (int i=0; i<raw.numPoints(); i++)
+	{
+		float best = 100000.0f;
+		for (int j=1; j<simple.numPoints(); j++)
+		{
+			Segment s(simple.point(j-1), simple.point(j));
+			best = MIN(best, s.distanceTo(raw.point(i)));
+		}
+		worst = MAX(worst, best);
+	}
+	return worst;
+}
+
+static void fitByThreshold(Path& path)
+{
+	float thresh = 0.1*SIMPLIFY_THRESHOLDf;
+	path.simplify(thresh);
+	while (path.numPoints() > MULTI_VERTEX_LIMIT)
+	{
+		thresh += SIMPLIFY_THRESHOLDf;
+		path.simplify(thresh);
+	}
+}
+
+static void fitToBudget(Path& path)
+{
+	float thresh = 0.1*SIMPLIFY_THRESHOLDf;
+	path.simplify(thresh);
+	if (path.numPoints() > MULTI_VERTEX_LIMIT)
+	{
+		path.simplifyTo(MULTI_VERTEX_LIMIT, thresh);
+	}
+}
+
+static double timeFit(const Array<Path>& paths, void (*fit)(Path&), int& points, float& error)
+{
+	Array<Path> work(paths);
+	double t0 = benchNow();
+	for (int i=0; i<work.size(); i++)
+	{
+		fit(work[i]);
+	}
+	double t = benchNow() - t0;
+
+	points = 0;
+	error = 0.0f;
+	for (int i=0; i<work.size(); i++)
+	{
+		points = MAX(points, work[i].numPoints());
+		error += simplifyError(paths[i], work[i]) / work.size();
+	}
+	return t;
+}
+
+// Time spent drawing (in addPoint) and at pen-up (in activate).
+static void timeStrokes(const Array<Path>& paths, bool drawn, double& draw, double& penUp)
+{
+	Scene scene;
+	draw = penUp = 0.0;
+	for (int i=0; i<paths.size(); i++)
+	{
+		const Path& p = paths[i];
+		Stroke* stroke;
+		if (drawn)
+		{
+			stroke = scene.newStroke(Path() & p.point(0));
+			double t0 = benchNow();
+			for (int k=1; k<p.numPoints(); k++)
+			{
+				stroke->addPoint(p.point(k));
+			}
+			draw += benchNow() - t0;
+		}
+		else
+		{
+			stroke = scene.newStroke(p);
+		}
+		double t0 = benchNow();
+		scene.activate(stroke);
+		penUp += benchNow() - t0;
+	}
+}
+
+int benchSimplify(int argc, char** argv)
+{
+	int count = 20, points = 4000;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", count)
+			&& !benchIntArg(argc, argv, i, "-p", points))
+		{
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	count = MAX(count, 1);
+	points = MAX(points, 2);
+
+	Array<Path> paths;
+	s_seed = 1;
+	for (int i=0; i<count; i++)
+	{
+		Vec2 p(CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2);
+		Path path;
+		path & p;
+		for (int k=1; k<points; k++)
+		{
+			p += Vec2(benchRand(9) - 4, benchRand(9) - 4);
+			path & p;
+		}
+		paths.append(path);
+	}
+
+	int maxThresh, maxBudget;
+	float errThresh, errBudget;
+	double tThresh = timeFit(paths, fitByThreshold, maxThresh, errThresh);
+	double tBudget = timeFit(paths, fitToBudget, maxBudget, errBudget);
+
+	double drawWhole, penUpWhole, drawDrawn, penUpDrawn;
+	timeStrokes(paths, false, drawWhole, penUpWhole);
+	timeStrokes(paths, true, drawDrawn, penUpDrawn);
+
+	printf("%d strokes of %d points, fitted to %d\n", count, points, MULTI_VERTEX_LIMIT);
+	printf("%-10s %10s %8s %10s\n", "", "us/stroke", "points", "error(px)");
+	printf("%-10s %10.1f %8d %10.2f\n", "threshold", tThresh * 1e6 / count, maxThresh, errThresh);
+	printf("%-10s %10.1f %8d %10.2f\n", "budget", tBudget * 1e6 / count, maxBudget, errBudget);
+	printf("%-10s %10s %10s\n", "", "pen-up(us)", "draw(us/pt)");
+	printf("%-10s %10.1f %10s\n", "whole", penUpWhole * 1e6 / count, "-");
+	printf("%-10s %10.1f %10.3f\n", "drawn", penUpDrawn * 1e6 / count, drawDrawn * 1e6 / (count * (points - 1)));
+	return maxBudget > MULTI_VERTEX_LIMIT ? 1 : 0;
+}
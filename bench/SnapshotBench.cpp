@@ -0,0 +1,152 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+
+#include <string>
+#include <cstring>
+
+#include "Bench.h"
+#include "Scene.h"
+
+// World snapshots: each level runs for a while, is snapshotted, runs on,
+// then is restored and run again over the same steps. Reports the snapshot
+// size, the cost of saving and restoring it against replaying the level
+// from a restart, and how many bodies ended up somewhere else the second
+// time round (0 when the restore is exact). The snapshot is also restored
+// into a second scene, run up to the same point with its own allocation
+// history, which must end up in the same place. Any divergence fails the
+// run.
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+static void bodyStates(b2World* world, Array<float>& states)
+{
+	states.empty();
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetCenterPosition();
+		b2Vec2 v = b->GetLinearVelocity();
+		states.append(p.x);
+		states.append(p.y);
+		states.append(b->GetRotation());
+		states.append(v.x);
+		states.append(v.y);
+		states.append(b->GetAngularVelocity());
+	}
+}
+
+static int divergedBodies(const Array<float>& a, const Array<float>& b)
+{
+	if (a.size() != b.size())
+	{
+		return a.size() / 6;
+	}
+
+	int count = 0;
+	for (int i=0; i<a.size(); i+=6)
+	{
+		if (memcmp(&a[i], &b[i], 6 * sizeof(float)) != 0)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+int benchSnapshot(int argc, char** argv)
+{
+	int warmup = 300;
+	int steps = 300;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-w", warmup)
+			&& !benchIntArg(argc, argv, i, "-s", steps))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	Scene scene, fresh;
+	Array<char> snapshot;
+	Array<float> first, second, third;
+	int totalDiverged = 0, totalFresh = 0, totalBodies = 0;
+
+	printf("%-24s %7s %9s %9s %11s %12s %9s %9s\n", "level", "bodies", "bytes",
+		   "save(us)", "restore(us)", "replay(us)", "diverged", "fresh");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		const std::string& file = levels.levelFile(l);
+
+		double t0 = benchNow();
+		scene.load(file);
+		scene.activateAll();
+		for (int s=0; s<warmup; s++) scene.step();
+		double t1 = benchNow();
+
+		scene.saveSnapshot(snapshot);
+		double t2 = benchNow();
+
+		for (int s=0; s<steps; s++) scene.step();
+		bodyStates(scene.world(), first);
+
+		double t3 = benchNow();
+		bool restored = scene.restoreSnapshot(snapshot);
+		double t4 = benchNow();
+
+		for (int s=0; s<steps; s++) scene.step();
+		bodyStates(scene.world(), second);
+
+		fresh.load(file);
+		fresh.activateAll();
+		for (int s=0; s<warmup; s++) fresh.step();
+		bool freshRestored = fresh.restoreSnapshot(snapshot);
+		for (int s=0; s<steps; s++) fresh.step();
+		bodyStates(fresh.world(), third);
+
+		int diverged = restored ? divergedBodies(first, second) : first.size() / 6;
+		int freshDiverged = freshRestored ? divergedBodies(first, third) : first.size() / 6;
+		totalDiverged += diverged;
+		totalFresh += freshDiverged;
+		totalBodies += first.size() / 6;
+
+		printf("%-24s %7d %9d %9.1f %11.1f %12.1f %9d %9d%s\n", baseName(file),
+			   first.size() / 6, snapshot.size(), (t2 - t1) * 1e6, (t4 - t3) * 1e6,
+			   (t1 - t0) * 1e6, diverged, freshDiverged,
+			   restored && freshRestored ? "" : " (restore failed)");
+	}
+
+	printf("%-24s %7d %9s %9s %11s %12s %9d %9d\n", "total", totalBodies, "", "", "", "",
+		   totalDiverged, totalFresh);
+	if (totalDiverged + totalFresh > 0)
+	{
+		fprintf(stderr, "restored snapshots diverged\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include "Bench.h"
+#include "Scene.h"
+#include "ThumbnailCache.h"
+
+// Level thumbnails four ways: drawn full size and copied out, as the
+// next-level overlay used to; drawn straight at thumbnail size; read back
+// from the disk cache by a fresh ThumbnailCache; and found in memory.
+// The thumbnail read from disk must match the one drawn.
+
+static const Rect SCREEN_RECT(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
+
+static const char* baseName(const std::string& path)
+{
+	size_t i = path.rfind('/');
+	return path.c_str() + (i == std::string::npos ? 0 : i+1);
+}
+
+static double fullSize(const std::string& file, int repeats)
+{
+	double t0 = benchNow();
+	for (int r=0; r<repeats; r++)
+	{
+		Scene scene(true);
+		scene.load(file);
+		CanvasSoft* temp = new CanvasSoft(CANVAS_WIDTH, CANVAS_HEIGHT);
+		scene.draw(temp, SCREEN_RECT);
+		char* icon = (char*)malloc(CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+		memcpy(icon, temp->scale(1), CANVAS_WIDTH * CANVAS_HEIGHT * 2);
+		free(icon);
+		delete temp;
+	}
+	return (benchNow() - t0) / repeats;
+}
+
+int benchThumbs(int argc, char** argv)
+{
+	int repeats = 20;
+	Array<char*> paths;
+	for (int i=0; i<argc; i++)
+	{
+		if (!benchIntArg(argc, argv, i, "-n", repeats))
+		{
+			paths.append(argv[i]);
+		}
+	}
+
+	Levels levels;
+	benchLevels(paths.size(), paths.size() ? &paths[0] : NULL, levels);
+	if (levels.numLevels() == 0)
+	{
+		fprintf(stderr, "no levels found\n");
+		return 1;
+	}
+
+	char dir[] = "/tmp/numpty-thumbs-XXXXXX";
+	if (!mkdtemp(dir))
+	{
+		perror("mkdtemp");
+		return 1;
+	}
+
+	ThumbnailCache drawn(dir);
+	Array<Uint16> pixels;
+	pixels.resize(THUMB_WIDTH * THUMB_HEIGHT);
+	double fullTotal = 0.0, directTotal = 0.0, diskTotal = 0.0, memoryTotal = 0.0;
+	int n = 0, mismatches = 0;
+
+	printf("%dx%d thumbnails, mean of %d\n", THUMB_WIDTH, THUMB_HEIGHT, repeats);
+	printf("%-24s %9s %9s %9s %9s\n", "level", "full(us)", "drawn(us)", "disk(us)", "memory(us)");
+	for (int l=0; l<levels.numLevels(); l++)
+	{
+		const std::string& file = levels.levelFile(l);
+		double full = fullSize(file, repeats);
+
+		double t0 = benchNow();
+		for (int r=0; r<repeats; r++)
+		{
+			drawn.render(file, &pixels[0]);
+		}
+		double direct = (benchNow() - t0) / repeats;
+
+		// Fills the disk cache, then reads it back with nothing in memory.
+		const Uint16* saved = drawn.get(file);
+		if (!saved)
+		{
+			fprintf(stderr, "failed to load %s\n", file.c_str());
+			continue;
+		}
+		t0 = benchNow();
+		for (int r=0; r<repeats; r++)
+		{
+			ThumbnailCache fresh(dir);
+			const Uint16* loaded = fresh.get(file);
+			if (!loaded || fresh.loads() != 1 || memcmp(loaded, saved, THUMB_WIDTH * THUMB_HEIGHT * 2) != 0)
+			{
+				mismatches++;
+				break;
+			}
+		}
+		double disk = (benchNow() - t0) / repeats;
+
+		t0 = benchNow();
+		for (int r=0; r<repeats; r++)
+		{
+			drawn.get(file);
+		}
+		double memory = (benchNow() - t0) / repeats;
+
+		printf("%-24s %9.1f %9.1f %9.1f %9.2f\n", baseName(file),
+			   full * 1e6, direct * 1e6, disk * 1e6, memory * 1e6);
+		fullTotal += full;
+		directTotal += direct;
+		diskTotal += disk;
+		memoryTotal += memory;
+		n++;
+	}
+
+	if (n)
+	{
+		printf("%-24s %9.1f %9.1f %9.1f %9.2f\n", "mean", fullTotal * 1e6 / n,
+			   directTotal * 1e6 / n, diskTotal * 1e6 / n, memoryTotal * 1e6 / n);
+	}
+	printf("drawn %d, read from disk %d, found in memory %d\n",
+		   drawn.renders(), drawn.loads(), drawn.hits());
+
+	std::string rm = std::string("rm -rf ") + dir;
+	if (system(rm.c_str()) != 0)
+	{
+		fprintf(stderr, "could not remove %s\n", dir);
+	}
+
+	if (mismatches)
+	{
+		printf("%d thumbnails read back differ from those drawn\n", mismatches);
+		return 1;
+	}
+	printf("all thumbnails read back match\n");
+	return 0;
+}
@@ -19,58 +19,29 @@
 */
 
 #include "Canvas.h"
-#include "Pics.h"
-#include <vita2d.h>
 
 #define SCREEN_PITCH 	(960*2)
 #define SCREEN_W		(960)
 #define SCREEN_H		(544)
 
-//int i_fade = 0;
-
-vita2d_texture *paper_pic, *paper_pic_dark, *pause_pic, *next_pic, *img_pic, *edit_pic;
-unsigned short *paper_pic_data, *paper_pic_dark_data, *pause_pic_data, *next_pic_data, *img_pic_data, *edit_pic_data;
-
-struct Vertex
-{
-	float x,y,z;
-};
+// Half the width of lines and of thick (stroke) lines, in pixels.
+#define LINE_HALF_WIDTHf		0.5f
+#define THICK_HALF_WIDTHf		1.0f
+// Sharp corners are mitered out to at most this many half widths.
+#define MITER_LIMITf			2.0f
 
-struct VertexUV
-{
-	float u, v;
-	unsigned int color;
-	float x,y,z;
-};
+//int i_fade = 0;
 
-struct Vertex __attribute__((aligned(16))) plane[2*3] =
-{
-	{2,		1,	0},
-	{-1,	1,	0},
-	{-1,	-1,	0},
-	{-1,	-1, 0},
-	{2,		-1, 0},
-	{2,		1,	0}
-};
-
-struct VertexUV __attribute__((aligned(16))) vertices[2*3] =
-{
-	{0, 0, 0, 4.9,		1.95, 	0},
-	{1, 0, 0, -1.95,	1.95, 	0},
-	{1, 1, 0, -1.9,		-1.95, 	0},
-	{1, 1, 0, -1.95,	-1.95,	0},
-	{0, 1, 0, 4.9,		-1.95, 	0},
-	{0, 0, 0, 4.9,		1.95, 	0}
-};
-
-Canvas::Canvas(int w, int h):m_state(NULL),m_bgColour(0),m_bgImage(NULL)
+Canvas::Canvas(int w, int h):m_state(NULL),m_bgColour(0),m_bgImage(NULL),m_layer(NULL),m_image(NULL),
+	m_join(false),m_drawCalls(0),m_vertices(0),m_recorder(NULL)
 {
 	b_fade = false;
 	resetClip();
 }
 
 
-Canvas::Canvas(State state):m_state(state),m_bgColour(0),m_bgImage(NULL)
+Canvas::Canvas(State state):m_state(state),m_bgColour(0),m_bgImage(NULL),m_layer(NULL),m_image(NULL),
+	m_join(false),m_drawCalls(0),m_vertices(0),m_recorder(NULL)
 {
 	b_fade = false;
 	resetClip();
@@ -125,68 +96,19 @@ void Canvas::setBackground(Canvas* bg)
 	m_bgImage = bg;
 }
 
-void Canvas::LoadAssets()
+void Canvas::fade(bool f) 
 {
-
-	paper_pic = vita2d_create_empty_texture_format(512, 512, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	paper_pic_data = (unsigned short*)vita2d_texture_get_datap(paper_pic);
-
-	for (int i = 0; i < 512; i++)
-	{
-		for (int j = 0; j < 512; j++)
-			paper_pic_data[j + 512 * i] = PaperPic[j * 2 + 512 * i * 2] | PaperPic[j * 2 + 1 + 512 * i * 2] << 8;
-	}
-
-	paper_pic_dark = vita2d_create_empty_texture_format(512, 512, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	paper_pic_dark_data = (unsigned short*)vita2d_texture_get_datap(paper_pic_dark);
-
-	for (int i = 0; i < 512; i++)
-	{
-		for (int j = 0; j < 512; j++)
-			paper_pic_dark_data[j + 512 * i] = PaperDarkPic[j * 2 + 512 * i * 2] | PaperDarkPic[j * 2 + 1 + 512 * i * 2] << 8;
-	}
-
-	next_pic = vita2d_create_empty_texture_format(320, 192, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	next_pic_data = (unsigned short*)vita2d_texture_get_datap(next_pic);
-
-	for (int i = 0; i < 192; i++)
-	{
-		for (int j = 0; j < 320; j++)
-			next_pic_data[j + 320 * i] = NextPic[j * 2 + 512 * i * 2] | NextPic[j * 2 + 1 + 512 * i * 2] << 8;
-	}
-
-	img_pic = vita2d_create_empty_texture_format(960, 544, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	img_pic_data = (unsigned short*)vita2d_texture_get_datap(img_pic);
-
-	edit_pic = vita2d_create_empty_texture_format(128, 256, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	edit_pic_data = (unsigned short*)vita2d_texture_get_datap(edit_pic);
-
-	for (int i = 0; i < 256; i++)
-	{
-		for (int j = 0; j < 128; j++)
-			edit_pic_data[j + 128 * i] = EditPic[j * 2 + 128 * i * 2] | EditPic[j * 2 + 1 + 128 * i * 2] << 8;
-	}
-
-	pause_pic = vita2d_create_empty_texture_format(32, 32, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
-	pause_pic_data = (unsigned short*)vita2d_texture_get_datap(pause_pic);
-
-	for (int i = 0; i < 32; i++)
-	{
-		for (int j = 0; j < 32; j++)
-			pause_pic_data[j + 32 * i] = PausePic[j * 2 + 32 * i * 2] | PausePic[j * 2 + 1 + 32 * i * 2] << 8;
-	}
-
+	b_fade = f;
 }
 
-void Canvas::clear()
+const void* Canvas::layer() const
 {
-	if (b_fade) vita2d_draw_texture_scale(paper_pic_dark, 0.0f, 0.0f, 2.0f, 2.0f);
-	else vita2d_draw_texture_scale(paper_pic, 0.0f, 0.0f, 2.0f, 2.0f);
+	return m_layer;
 }
 
-void Canvas::fade(bool f) 
+bool Canvas::layered() const
 {
-	b_fade = f;
+	return m_layer && !b_fade;
 }
 
 Canvas* Canvas::scale(int factor) const
@@ -204,48 +126,128 @@ void Canvas::drawImage(Canvas *canvas, int x, int y)
 
 }
 
-void Canvas::drawLine(int x1, int y1, int x2, int y2, int color)
+int Canvas::drawCalls() const
 {
-	vita2d_draw_line(x1, y1, x2, y2, color);
+	return m_drawCalls;
 }
 
-void Canvas::drawPath(const Path& path, int color, bool thick)
+int Canvas::vertexCount() const
 {
-	Rect clip = m_clip;
-	clip.tl.x++; clip.tl.y++;
-	clip.br.x--; clip.br.y--;
+	return m_vertices;
+}
 
-	int i=0;
-	const int n = path.numPoints();
+void Canvas::resetCounts()
+{
+	m_drawCalls = 0;
+	m_vertices = 0;
+}
+
+void Canvas::record(CanvasRecorder* recorder)
+{
+	m_recorder = recorder;
+}
+
+void Canvas::flush()
+{
+	if (m_batch.size())
+	{
+		submit(&m_batch[0], m_batch.size());
+	}
+	m_batch.empty();
+	m_join = false;
+}
 
-	for ( ;i<n && !clip.contains(path.point(i));i++)
+// Runs of the strip are joined by repeating the last vertex of one and
+// the first of the next, which makes triangles with no area between them.
+void Canvas::beginStrip()
+{
+	if (m_batch.size())
 	{
+		m_batch.append(m_batch[m_batch.size()-1]);
+		m_join = true;
 	}
-	i++;
-	for ( ;i<n;i++)
+}
+
+void Canvas::addVertex(float x, float y, int c)
+{
+	CanvasVertex v;
+	v.x = x;
+	v.y = y;
+	v.colour = c;
+	if (m_join)
+	{
+		m_batch.append(v);
+		m_join = false;
+	}
+	m_batch.append(v);
+}
+
+void Canvas::addQuad(float x1, float y1, float x2, float y2, float hw, int c)
+{
+	b2Vec2 d(x2-x1, y2-y1);
+	if (d.Normalize() < FLT_EPSILON)
+	{
+		d.Set(1.0f, 0.0f);
+	}
+	b2Vec2 n(-d.y*hw, d.x*hw);
+	beginStrip();
+	addVertex(x1+n.x, y1+n.y, c);
+	addVertex(x1-n.x, y1-n.y, c);
+	addVertex(x2+n.x, y2+n.y, c);
+	addVertex(x2-n.x, y2-n.y, c);
+}
+
+// Two vertices per point, either side of it along the bisector of the
+// segments meeting there. The far side is shaded a little, as the
+// offset lines used to be.
+void Canvas::addPolyline(const Path& path, int first, int end, float hw, int c)
+{
+	beginStrip();
+	b2Vec2 nIn(0.0f, 0.0f);
+	for (int i=first; i<end; i++)
 	{
-		const Vec2& p2 = path.point(i);
-		if (clip.contains(p2))
+		b2Vec2 p = path.point(i);
+		b2Vec2 nOut(0.0f, 0.0f);
+		if (i+1 < end)
+		{
+			b2Vec2 d = b2Vec2(path.point(i+1)) - p;
+			if (d.Normalize() >= FLT_EPSILON) nOut.Set(-d.y, d.x);
+		}
+		if (nOut.x == 0.0f && nOut.y == 0.0f) nOut = nIn;
+		if (nIn.x == 0.0f && nIn.y == 0.0f) nIn = nOut;
+		if (nIn.x == 0.0f && nIn.y == 0.0f) nIn = nOut = b2Vec2(0.0f, 1.0f);
+
+		b2Vec2 m = nIn + nOut;
+		float scale = hw;
+		if (m.Normalize() < FLT_EPSILON)
 		{
-			const Vec2& p1 = path.point(i-1);
-			drawLine(p1.x, p1.y, p2.x, p2.y, color);
-			drawLine(p1.x+1, p1.y, p2.x+1, p2.y, color&0xFFEEFFEE);
-			drawLine(p1.x, p1.y+1, p2.x, p2.y+1, color&0xFFFFEEFF);
+			// Doubles straight back: square the end off.
+			m = nIn;
 		}
 		else
 		{
-			for ( ;i<n && !clip.contains( path.point(i) ); i++)
-			{
-			}
+			scale = hw / b2Max(b2Dot(m, nIn), 1.0f/MITER_LIMITf);
 		}
+		addVertex(p.x + m.x*scale, p.y + m.y*scale, c);
+		addVertex(p.x - m.x*scale, p.y - m.y*scale, c & 0xFFEEFFEE);
+		nIn = nOut;
 	}
 }
 
+void Canvas::drawLine(int x1, int y1, int x2, int y2, int color)
+{
+	addQuad(x1, y1, x2, y2, LINE_HALF_WIDTHf, color);
+}
+
 void Canvas::drawRect(int x, int y, int w, int h, int c, bool fill)
 {
 	if(fill)
 	{
-		vita2d_draw_rectangle(x, y, w, h, c);
+		beginStrip();
+		addVertex(x, y, c);
+		addVertex(x, y+h, c);
+		addVertex(x+w, y, c);
+		addVertex(x+w, y+h, c);
 	}
 	else
 	{
@@ -256,6 +258,33 @@ void Canvas::drawRect(int x, int y, int w, int h, int c, bool fill)
 	}
 }
 
+// Each run of points inside the clip is one run of the strip; a segment
+// with an end outside is left out, as before.
+void Canvas::drawPath(const Path& path, int color, bool thick)
+{
+	Rect clip = m_clip;
+	clip.tl.x++; clip.tl.y++;
+	clip.br.x--; clip.br.y--;
+
+	int i=0;
+	const int n = path.numPoints();
+
+	while (i<n)
+	{
+		for ( ;i<n && !clip.contains(path.point(i)); i++)
+		{
+		}
+		int first = i;
+		for ( ;i<n && clip.contains(path.point(i)); i++)
+		{
+		}
+		if (i-first > 1)
+		{
+			addPolyline(path, first, i, thick ? THICK_HALF_WIDTHf : LINE_HALF_WIDTHf, color);
+		}
+	}
+}
+
 void Canvas::drawRect(const Rect& r, int c, bool fill)
 {
 	drawRect(r.tl.x, r.tl.y, r.br.x-r.tl.x, r.br.y-r.tl.y, c, fill);
@@ -300,24 +329,3 @@ void Canvas::drawWorldPath(const Path& path, int color, bool thick)
 		drawWorldLine(path.point(i-1), path.point(i), color, thick);
 	}  
 }
-
-void Canvas::drawEdit(int x, int y)
-{
-	vita2d_draw_texture(edit_pic, x, y);
-}
-
-void Canvas::drawPause(int x, int y)
-{
-	vita2d_draw_texture_scale(pause_pic, x, y, 2.0f, 2.0f);
-}
-
-void Canvas::drawNext(int x, int y)
-{
-	vita2d_draw_texture_scale(next_pic, x, y, 2.0f, 2.0f);
-}
-
-void Canvas::drawImage(void *img, int x, int y, int w, int h)
-{
-	memcpy(img_pic_data, img, 960 * 544 * 2);
-	vita2d_draw_texture_scale(img_pic, x, y, w * 2.0f / 960, h * 2.0f / 544);
-}
@@ -0,0 +1,92 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+/*
+* PSP port by rock88: rock88a@gmail.com
+* http://rock88dev.blogspot.com
+*/
+
+// Headless backend for the Canvas primitives, used by the host build.
+// Nothing is put on screen; the portable parts of Canvas (clipping,
+// colours, path walking, batching) still run as they do on the Vita, and
+// the draws that would reach the GPU are counted and, given a recorder,
+// recorded.
+
+#include "Canvas.h"
+#include "CanvasRecorder.h"
+
+#define SCREEN_W		(960)
+#define SCREEN_H		(544)
+
+// The bitmap assets are not part of the host build so the software
+// canvas gets blank paper.
+unsigned char PaperPic[524288];
+
+// Textures are drawn as a quad each, at the size CanvasVita draws them.
+#define DRAW_TEXTURE(t, x, y, w, h) \
+	flush(); \
+	m_drawCalls++; \
+	m_vertices += 4; \
+	if (m_recorder) m_recorder->texture(CanvasRecorder::t, x, y, w, h)
+
+void Canvas::LoadAssets()
+{
+}
+
+void Canvas::clear()
+{
+	if (b_fade) { DRAW_TEXTURE(TEX_PAPER_DARK, 0, 0, SCREEN_W, SCREEN_H); }
+	else if (m_layer) { DRAW_TEXTURE(TEX_LAYER, 0, 0, SCREEN_W, SCREEN_H); }
+	else { DRAW_TEXTURE(TEX_PAPER, 0, 0, SCREEN_W, SCREEN_H); }
+}
+
+void Canvas::setLayer(const void* pixels)
+{
+	m_layer = pixels;
+	if (pixels && m_recorder) m_recorder->upload(CanvasRecorder::TEX_LAYER, pixels, SCREEN_W, SCREEN_H);
+}
+
+void Canvas::submit(const CanvasVertex* v, int n)
+{
+	m_drawCalls++;
+	m_vertices += n;
+	if (m_recorder) m_recorder->strip(v, n);
+}
+
+void Canvas::drawEdit(int x, int y)
+{
+	DRAW_TEXTURE(TEX_EDIT, x, y, 128, 256);
+}
+
+void Canvas::drawPause(int x, int y)
+{
+	DRAW_TEXTURE(TEX_PAUSE, x, y, 64, 64);
+}
+
+void Canvas::drawNext(int x, int y)
+{
+	DRAW_TEXTURE(TEX_NEXT, x, y, 640, 384);
+}
+
+void Canvas::setImage(const void* pixels)
+{
+	m_image = pixels;
+	if (pixels && m_recorder) m_recorder->upload(CanvasRecorder::TEX_IMAGE, pixels, THUMB_WIDTH, THUMB_HEIGHT);
+}
+
+void Canvas::drawImage(int x, int y)
+{
+	if (m_image) { DRAW_TEXTURE(TEX_IMAGE, x, y, THUMB_WIDTH, THUMB_HEIGHT); }
+}
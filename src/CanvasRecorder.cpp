@@ -0,0 +1,145 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <string.h>
+
+#include "CanvasRecorder.h"
+
+#define SCREEN_W		(960)
+#define SCREEN_H		(544)
+
+// Flat colour the icons are replayed in.
+#define ICON_COLOUR		0xff808080
+
+static inline float triangleArea(const CanvasVertex& a, const CanvasVertex& b, const CanvasVertex& c)
+{
+	return 0.5f * ABS((b.x-a.x)*(c.y-a.y) - (c.x-a.x)*(b.y-a.y));
+}
+
+CanvasRecorder::CanvasRecorder()
+{
+	for (int t=0; t<TEX_COUNT; t++)
+	{
+		m_width[t] = m_height[t] = 0;
+	}
+	beginFrame();
+}
+
+void CanvasRecorder::beginFrame()
+{
+	m_commands.empty();
+	m_vertices.empty();
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void CanvasRecorder::strip(const CanvasVertex* v, int n)
+{
+	m_commands.append(OP_STRIP);
+	m_commands.append(m_vertices.size());
+	m_commands.append(n);
+	float area = 0.0f;
+	for (int i=0; i<n; i++)
+	{
+		m_vertices.append(v[i]);
+		if (i >= 2) area += triangleArea(v[i-2], v[i-1], v[i]);
+	}
+	m_stats.draws++;
+	m_stats.vertices += n;
+	m_stats.overdraw += area / (SCREEN_W * SCREEN_H);
+}
+
+void CanvasRecorder::texture(Texture t, int x, int y, int w, int h)
+{
+	m_commands.append(OP_TEXTURE);
+	m_commands.append(t);
+	m_commands.append(x);
+	m_commands.append(y);
+	m_commands.append(w);
+	m_commands.append(h);
+	m_stats.draws++;
+	m_stats.vertices += 4;
+	m_stats.overdraw += (float)w * h / (SCREEN_W * SCREEN_H);
+}
+
+void CanvasRecorder::upload(Texture t, const void* pixels, int w, int h)
+{
+	int bytes = w * h * 2;
+	m_width[t] = w;
+	m_height[t] = h;
+	m_pixels[t].resize(bytes);
+	memcpy(&m_pixels[t][0], pixels, bytes);
+	m_stats.uploads++;
+	m_stats.uploadBytes += bytes;
+}
+
+int CanvasRecorder::commandBytes() const
+{
+	return m_commands.size() * sizeof(int) + m_vertices.size() * sizeof(CanvasVertex);
+}
+
+// Uploaded textures are copied across, scaled to fit and clipped to the
+// canvas, which need not be screen sized.
+static void replayImage(CanvasSoft* canvas, const Array<char>& pixels, int tw, int th, int x, int y, int w, int h)
+{
+	const Uint16* src = (const Uint16*)&pixels[0];
+	Uint16* dst = (Uint16*)canvas->scale(1);
+	int cw = canvas->width(), ch = canvas->height();
+	for (int j=MAX(y,0); j<MIN(y+h,ch); j++)
+	{
+		const Uint16* row = src + (j-y) * th / h * tw;
+		for (int i=MAX(x,0); i<MIN(x+w,cw); i++)
+		{
+			dst[j*cw + i] = row[(i-x) * tw / w];
+		}
+	}
+}
+
+void CanvasRecorder::replay(CanvasSoft* canvas) const
+{
+	for (int c=0; c<m_commands.size(); )
+	{
+		if (m_commands[c] == OP_STRIP)
+		{
+			const CanvasVertex* v = &m_vertices[m_commands[c+1]];
+			int n = m_commands[c+2];
+			for (int i=2; i<n; i++)
+			{
+				canvas->fillTriangle(v[i-2].x, v[i-2].y, v[i-1].x, v[i-1].y, v[i].x, v[i].y,
+									 canvas->makeColour(v[i-2].colour));
+			}
+			c += 3;
+		}
+		else
+		{
+			Texture t = (Texture)m_commands[c+1];
+			int x = m_commands[c+2], y = m_commands[c+3];
+			int w = m_commands[c+4], h = m_commands[c+5];
+			if (m_pixels[t].size())
+			{
+				replayImage(canvas, m_pixels[t], m_width[t], m_height[t], x, y, w, h);
+			}
+			else if (t == TEX_PAPER || t == TEX_PAPER_DARK)
+			{
+				canvas->clear();
+			}
+			else
+			{
+				canvas->drawRect(x, y, w, h, canvas->makeColour(ICON_COLOUR), true);
+			}
+			c += 6;
+		}
+	}
+}
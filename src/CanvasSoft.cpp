@@ -18,11 +18,11 @@
 * http://rock88dev.blogspot.com
 */
 
-#define SCREEN_PITCH 	(960*2)
 #define SCREEN_W		(960)
 #define SCREEN_H		(544)
 
 #include "CanvasSoft.h"
+#include "PixelLanes.h"
 
 #define SURFACE(cANVASpTR) (m_state)
 
@@ -130,14 +130,123 @@ struct AlphaBrush<PIX,3>
 		*(pix) = m_c;
 		AlphaBlend(*(pix+step), m_r, m_g, m_b, ia, a);
 	}
+	// Only the pixels lo..hi steps away from pix.
+	inline void ink(PIX* pix, int step, int a, int lo, int hi) 
+	{
+		int ia = ALPHA_MAX - a;
+		if (lo <= -1 && hi >= -1) AlphaBlend(*(pix-step), m_r, m_g, m_b, a, ia);
+		if (lo <= 0 && hi >= 0) *(pix) = m_c;
+		if (lo <= 1 && hi >= 1) AlphaBlend(*(pix+step), m_r, m_g, m_b, ia, a);
+	}
 };
 
 
+// Runs of pixels along a row: filled with the colour, or blended with
+// it at an alpha that changes by a fixed step from pixel to pixel.
+// Pixel for pixel the same as AlphaBrush.
+template <typename PIX>
+struct SpanBrush
+{
+	int m_r, m_g, m_b;
+	PIX m_c;
+	inline SpanBrush(PIX c)
+	{
+		m_c = c;
+		ExtractRgb(c, m_r, m_g, m_b);
+	}
+	inline void fill(PIX* pix, int n)
+	{
+		for (int i=0; i<n; i++) pix[i] = m_c;
+	}
+	// Pixel i gets alpha a+i*step; the far side of the line (swap) takes
+	// what is left of it.
+	inline void blend(PIX* pix, int n, int a, int step, bool swap)
+	{
+		for (int i=0; i<n; i++, a+=step)
+		{
+			int ia = ALPHA_MAX - a;
+			if (swap) AlphaBlend(pix[i], m_r, m_g, m_b, ia, a);
+			else      AlphaBlend(pix[i], m_r, m_g, m_b, a, ia);
+		}
+	}
+};
+
+// RGB565 runs go pix_simdWidth pixels at a time.
+template <>
+struct SpanBrush<Uint16>
+{
+	int m_r, m_g, m_b;
+	Uint16 m_c;
+	PixW m_cr, m_cg, m_cb;
+	inline SpanBrush(Uint16 c)
+	{
+		m_c = c;
+		ExtractRgb(c, m_r, m_g, m_b);
+		m_cr = pixSplatW(m_r);
+		m_cg = pixSplatW(m_g);
+		m_cb = pixSplatW(m_b);
+	}
+	inline void fill(Uint16* pix, int n)
+	{
+		int i = 0;
+		PixW c = pixSplatW(m_c);
+		for ( ; i+pix_simdWidth <= n; i+=pix_simdWidth) pixStoreW(pix+i, c);
+		for ( ; i<n; i++) pix[i] = m_c;
+	}
+	inline void blend(Uint16* pix, int n, int a, int step, bool swap)
+	{
+		int i = 0;
+		PixW alpha = pixRampW(a, step);
+		PixW alphaStep = pixSplatW(step * pix_simdWidth);
+		PixW max = pixSplatW(ALPHA_MAX);
+		for ( ; i+pix_simdWidth <= n; i+=pix_simdWidth)
+		{
+			PixW p = pixLoadW(pix+i);
+			PixW ca = swap ? pixSubW(max, alpha) : alpha;
+			PixW pa = pixSubW(max, ca);
+			PixW r = pixAddW(pixMulW(ca, m_cr), pixMulW(pa, pixAndW(pixShrW<8>(p), pixSplatW(0xf8))));
+			PixW g = pixAddW(pixMulW(ca, m_cg), pixMulW(pa, pixAndW(pixShrW<3>(p), pixSplatW(0xfc))));
+			PixW b = pixAddW(pixMulW(ca, m_cb), pixMulW(pa, pixAndW(pixShlW<3>(p), pixSplatW(0xf8))));
+			p = pixOrW(pixOrW(pixAndW(r, pixSplatW(0xf800)),
+							  pixAndW(pixShrW<5>(g), pixSplatW(0x07e0))),
+					   pixShrW<11>(b));
+			pixStoreW(pix+i, p);
+			alpha = pixAddW(alpha, alphaStep);
+		}
+		for ( ; i<n; i++)
+		{
+			int ai = a + i*step;
+			int ia = ALPHA_MAX - ai;
+			if (swap) AlphaBlend(pix[i], m_r, m_g, m_b, ia, ai);
+			else      AlphaBlend(pix[i], m_r, m_g, m_b, ai, ia);
+		}
+	}
+};
+
+// Steps (of sgn pixels along the minor axis) from m that stay within
+// [lo,hi].
+static inline void minorSpan(int m, int sgn, int lo, int hi, int& from, int& to)
+{
+	if (sgn > 0)
+	{
+		from = lo - m;
+		to = hi - m;
+	}
+	else
+	{
+		from = m - hi;
+		to = m - lo;
+	}
+}
 
-template <typename PIX, unsigned THICK> 
-void renderLine(void *buf,int byteStride,int x1, int y1, int x2, int y2,PIX color)
+// With CLIP, only pixels inside clip are touched: the same pixels get the
+// same values as without it, the rest are left alone.
+template <typename PIX, unsigned THICK, bool CLIP> 
+void renderLine(void *buf,int byteStride,int x1, int y1, int x2, int y2,PIX color,
+		const Rect* clip=NULL)
 {
 	PIX *pix = (PIX*)((char*)buf+byteStride*y1) + x1;
+	int x = x1, y = y1, from, to;
 	int lg_delta, sh_delta, cycle, lg_step, sh_step;
 	int alpha, alpha_step, alpha_reset;
 	int pixStride = byteStride/sizeof(PIX);
@@ -158,18 +267,73 @@ void renderLine(void *buf,int byteStride,int x1, int y1, int x2, int y2,PIX colo
 		alpha_step = -(ALPHA_MAX * sh_delta/(lg_delta+1));
 		alpha_reset = alpha_step < 0 ? ALPHA_MAX : 0;
 		int count = lg_step>0 ? x2-x1 : x1-x2;
+
+		// Between steps along the minor axis the brush paints the same three
+		// rows, so those go as runs. Each pixel is painted by one step only,
+		// so the order they are done in doesn't matter.
+		// Only lines flat enough to give runs a SIMD blend wide are
+		// worth the division per run.
+		if (!CLIP && THICK == 3 && CanvasSoft::s_spanLines
+		    && sh_delta * pix_simdWidth <= lg_delta)
+		{
+			SpanBrush<PIX> span(color);
+			while (count > 0)
+			{
+				int run = sh_delta ? (lg_delta - cycle) / sh_delta + 1 : count;
+				if (run > count) run = count;
+				if (run >= pix_simdWidth)
+				{
+					PIX* lo = lg_step > 0 ? pix : pix - (run-1);
+					int a = lg_step > 0 ? alpha : alpha + (run-1) * alpha_step;
+					int step = lg_step > 0 ? alpha_step : -alpha_step;
+					span.blend(lo - pixStride, run, a, step, false);
+					span.fill(lo, run);
+					span.blend(lo + pixStride, run, a, step, true);
+					alpha += run * alpha_step;
+					pix += run * lg_step;
+				}
+				else
+				{
+					// Too short to be worth it.
+					for (int i=0; i<run; i++)
+					{
+						brush.ink(pix, pixStride, alpha);
+						alpha += alpha_step;
+						pix += lg_step;
+					}
+				}
+				cycle += run * sh_delta;
+				count -= run;
+				if (cycle > lg_delta)
+				{
+					cycle -= lg_delta;
+					alpha = alpha_reset;
+					pix += pixStride;
+				}
+			}
+		}
 		
 		while (count--)
 		{
-			brush.ink(pix, pixStride, alpha);
+			if (!CLIP)
+			{
+				brush.ink(pix, pixStride, alpha);
+			}
+			else if (x >= clip->tl.x && x <= clip->br.x)
+			{
+				minorSpan(y, sh_step, clip->tl.y, clip->br.y, from, to);
+				brush.ink(pix, pixStride, alpha, from, to);
+			}
 			cycle += sh_delta;
 			alpha += alpha_step;
 			pix += lg_step;
+			x += lg_step;
 			if (cycle > lg_delta)
 			{
 				cycle -= lg_delta;
 				alpha = alpha_reset;
 				pix += pixStride;
+				y += sh_step;
 			}
 		}
 	}
@@ -183,42 +347,103 @@ void renderLine(void *buf,int byteStride,int x1, int y1, int x2, int y2,PIX colo
 		
 		while (count--)
 		{
-			brush.ink(pix, 1, alpha);
+			if (!CLIP)
+			{
+				brush.ink(pix, 1, alpha);
+			}
+			else if (y >= clip->tl.y && y <= clip->br.y)
+			{
+				minorSpan(x, 1, clip->tl.x, clip->br.x, from, to);
+				brush.ink(pix, 1, alpha, from, to);
+			}
 			cycle += lg_delta;
 			alpha += alpha_step;
 			pix += pixStride;
+			y += sh_step;
 			if (cycle > sh_delta)
 			{
 				cycle -= sh_delta;
 				alpha = alpha_reset;
 				pix += lg_step;
+				x += lg_step;
 			}
 		}
 	}
 }
 
-CanvasSoft::CanvasSoft(int w, int h):m_state(NULL),m_bgColour(0),m_bgImage(NULL)
+bool CanvasSoft::s_spanLines = pix_simd;
+
+// The paper bitmap is 480x272 in a 512 pixel pitch.
+#define PAPER_W 480
+#define PAPER_H 272
+
+static inline int paperPixel(int x, int y)
 {
-	m_state = (char*)malloc(960*544*2);
-	m_paper_img = (short*)malloc(960 * 544 * 2);
+	return PaperPic[x*2 + 512 * y*2] | PaperPic[x*2 + 1 + 512 * y*2] << 8;
+}
 
-	for (int i = 0; i < 272; i++)
+// Each canvas pixel is the average of the paper under it, weighted by how
+// much of each paper pixel it covers. Lengths are counted in 1/w of a
+// paper pixel across and 1/h down, so every overlap is a whole number.
+static void scalePaper(short* dst, int w, int h)
+{
+	const int area = PAPER_W * PAPER_H;
+	for (int y=0; y<h; y++)
 	{
-		for (int j = 0; j < 480; j++)
+		int y0 = y * PAPER_H, y1 = y0 + PAPER_H;
+		for (int x=0; x<w; x++)
 		{
-			short color = PaperPic[j*2 + 512 * i*2] | PaperPic[j*2 + 1 + 512 * i*2] << 8;
-			m_paper_img[j*2 + 960 * i*2] = color;
-			m_paper_img[j*2+1 + 960 * i*2] = color;
-			m_paper_img[j*2 + 960 * (i*2+1)] = color;
-			m_paper_img[j*2+1 + 960 * (i*2+1)] = color;
+			int x0 = x * PAPER_W, x1 = x0 + PAPER_W;
+			int r = 0, g = 0, b = 0;
+			for (int j=y0/h; j*h<y1; j++)
+			{
+				int wy = MIN(y1, (j+1)*h) - MAX(y0, j*h);
+				for (int i=x0/w; i*w<x1; i++)
+				{
+					int wxy = (MIN(x1, (i+1)*w) - MAX(x0, i*w)) * wy;
+					int p = paperPixel(i, j);
+					r += (p >> 11) * wxy;
+					g += (p >> 5 & 0x3f) * wxy;
+					b += (p & 0x1f) * wxy;
+				}
+			}
+			dst[x + w*y] = ((r + area/2) / area << 11) | ((g + area/2) / area << 5) | ((b + area/2) / area);
+		}
+	}
+}
+
+// Made once for each canvas size and shared, never freed.
+static const short* paperImage(int w, int h)
+{
+	struct Paper
+	{
+		int w, h;
+		short* pixels;
+	};
+	static Array<Paper> s_papers;
+	for (int i=0; i<s_papers.size(); i++)
+	{
+		if (s_papers[i].w == w && s_papers[i].h == h)
+		{
+			return s_papers[i].pixels;
 		}
 	}
+	Paper paper = { w, h, (short*)malloc(w * h * 2) };
+	scalePaper(paper.pixels, w, h);
+	s_papers.append(paper);
+	return paper.pixels;
+}
+
+CanvasSoft::CanvasSoft(int w, int h):m_state(NULL),m_bgColour(0),m_bgImage(NULL),m_w(w),m_h(h),m_scaleX(1.0f),m_scaleY(1.0f),m_pool(NULL),m_banding(false)
+{
+	m_state = (char*)malloc(w*h*2);
+	m_paper_img = paperImage(w, h);
 
 	setClip(0, 0, width(), height());
 }
 
 
-CanvasSoft::CanvasSoft(State state):m_state(state),m_bgColour(0),m_bgImage(NULL)
+CanvasSoft::CanvasSoft(State state):m_state(state),m_bgColour(0),m_bgImage(NULL),m_paper_img(NULL),m_w(SCREEN_W),m_h(SCREEN_H),m_scaleX(1.0f),m_scaleY(1.0f),m_pool(NULL),m_banding(false)
 {
 	resetClip();
 }
@@ -226,16 +451,17 @@ CanvasSoft::CanvasSoft(State state):m_state(state),m_bgColour(0),m_bgImage(NULL)
 CanvasSoft::~CanvasSoft()
 {
 	free(m_state);
+	delete m_pool;
 }
 
 int CanvasSoft::width() const
 {
-	return SCREEN_W;
+	return m_w;
 }
 
 int CanvasSoft::height() const
 {
-	return SCREEN_H;
+	return m_h;
 }
 
 int CanvasSoft::makeColour(int r, int g, int b) const
@@ -263,6 +489,92 @@ void CanvasSoft::resetClip()
 void CanvasSoft::setClip(int x, int y, int w, int h)
 {
 	m_clip = Rect(x,y,x+w-1,y+h-1);
+	m_region.clear();
+	m_region.add(m_clip);
+}
+
+void CanvasSoft::setClip(const DirtyRegion& region)
+{
+	m_region = region;
+}
+
+void CanvasSoft::setThreads(int count)
+{
+	count = MAX(1, MIN(count, b2_maxWorkers));
+	if (count == (m_pool ? m_pool->GetWorkerCount() : 1))
+	{
+		return;
+	}
+	delete m_pool;
+	m_pool = count > 1 ? new b2ThreadPool(count) : NULL;
+}
+
+void CanvasSoft::beginBands()
+{
+	m_banding = m_pool != NULL;
+}
+
+void CanvasSoft::endBands()
+{
+	if (!m_banding)
+	{
+		return;
+	}
+	m_banding = false;
+	m_pool->Run(drawBand, this, RENDER_BANDS);
+	for (int b=0; b<RENDER_BANDS; b++)
+	{
+		m_bands[b].empty();
+	}
+}
+
+void CanvasSoft::drawBand(void* context, int32 band, int32 worker)
+{
+	CanvasSoft* canvas = (CanvasSoft*)context;
+	const int rows = (canvas->m_h + RENDER_BANDS - 1) / RENDER_BANDS;
+	const int top = band * rows;
+	const int bottom = MIN(top + rows, canvas->m_h) - 1;
+
+	// The region's rectangles cut to the band, not re-added to a
+	// DirtyRegion: merging them would draw outside the region.
+	Array<Rect, DIRTY_RECTS+1> rects;
+	for (int r=0; r<canvas->m_region.size(); r++)
+	{
+		Rect to = canvas->m_region.rect(r);
+		to.tl.y = MAX(to.tl.y, top);
+		to.br.y = MIN(to.br.y, bottom);
+		if (to.tl.y <= to.br.y)
+		{
+			rects.append(to);
+		}
+	}
+
+	const Array<BandSegment>& segments = canvas->m_bands[band];
+	for (int i=0; i<segments.size(); i++)
+	{
+		const BandSegment& s = segments[i];
+		for (int r=0; r<rects.size(); r++)
+		{
+			canvas->drawSegment(s.p1, s.p2, s.colour, rects[r]);
+		}
+	}
+}
+
+void CanvasSoft::setScale(float sx, float sy)
+{
+	m_scaleX = sx;
+	m_scaleY = sy;
+}
+
+Vec2 CanvasSoft::scaled(const Vec2& p) const
+{
+	return Vec2((int)floorf(p.x * m_scaleX + 0.5f), (int)floorf(p.y * m_scaleY + 0.5f));
+}
+
+bool CanvasSoft::visible(const Rect& r) const
+{
+	// The brush reaches a pixel either side of the path.
+	return m_region.intersects(Rect(scaled(r.tl) - Vec2(1,1), scaled(r.br) + Vec2(1,1)));
 }
 
 void CanvasSoft::setBackground(int c)
@@ -277,7 +589,7 @@ void CanvasSoft::setBackground(CanvasSoft* bg)
 
 void CanvasSoft::clear()
 {
-	memcpy(m_state, m_paper_img,SCREEN_W*SCREEN_H*2);
+	memcpy(m_state, m_paper_img,m_w*m_h*2);
 }
 
 void CanvasSoft::fade() 
@@ -292,7 +604,12 @@ void* CanvasSoft::scale(int factor) const
 
 void CanvasSoft::clear(const Rect& r)
 {	
-
+	int x1 = MAX(r.tl.x, 0), y1 = MAX(r.tl.y, 0);
+	int x2 = MIN(r.br.x, m_w-1), y2 = MIN(r.br.y, m_h-1);
+	for (int y=y1; y<=y2 && x1<=x2; y++)
+	{
+		memcpy((char*)m_state + y*m_w*2 + x1*2, m_paper_img + y*m_w + x1, (x2-x1+1)*2);
+	}
 }
 
 void CanvasSoft::drawImage(CanvasSoft *canvas, int x, int y)
@@ -305,7 +622,7 @@ void CanvasSoft::drawPixel(int x, int y, int c)
 	Uint32 bpp, ofs;
 
 	bpp = 2;//SURFACE(this)->format->BytesPerPixel;
-	ofs = SCREEN_PITCH*y;//SURFACE(this)->pitch*y;
+	ofs = m_w*2*y;//SURFACE(this)->pitch*y;
 	char* row = (char*)m_state+ofs;//(char*)SURFACE(this)->pixels + ofs;
 
 	switch(bpp)
@@ -321,7 +638,7 @@ int CanvasSoft::readPixel(int x, int y) const
 	int c;
 
 	bpp = 2;//SURFACE(this)->format->BytesPerPixel;
-	ofs = SCREEN_PITCH*y;//SURFACE(this)->pitch*y;
+	ofs = m_w*2*y;//SURFACE(this)->pitch*y;
 	char* row = (char*)m_state+ofs;//(char*)SURFACE(this)->pixels + ofs;
 
 	switch(bpp)
@@ -374,8 +691,20 @@ void CanvasSoft::drawLine(int x1, int y1, int x2, int y2, int color)
 	drawPixel(x1, y1, color);
 }
 
-void CanvasSoft::drawPath(const Path& path, int color, bool thick)
+void CanvasSoft::drawPath(const Path& p, int color, bool thick)
 {
+	const Path* from = &p;
+	if (m_scaleX != 1.0f || m_scaleY != 1.0f)
+	{
+		m_scaled.empty();
+		for (int i=0; i<p.numPoints(); i++)
+		{
+			m_scaled.append(scaled(p.point(i)));
+		}
+		from = &m_scaled;
+	}
+	const Path& path = *from;
+
 	Rect clip = m_clip;
 	clip.tl.x++; clip.tl.y++;
 	clip.br.x--; clip.br.y--;
@@ -393,7 +722,23 @@ void CanvasSoft::drawPath(const Path& path, int color, bool thick)
 		if (clip.contains(p2))
 		{
 			const Vec2& p1 = path.point(i-1);
-			renderLine<Uint16,3>(SURFACE(this),SCREEN_PITCH,p1.x, p1.y, p2.x, p2.y, color);
+			if (m_banding)
+			{
+				const int rows = (m_h + RENDER_BANDS - 1) / RENDER_BANDS;
+				BandSegment s = { p1, p2, color };
+				int last = (MAX(p1.y, p2.y) + 1) / rows;
+				for (int b=(MIN(p1.y, p2.y) - 1) / rows; b<=last; b++)
+				{
+					m_bands[b].append(s);
+				}
+			}
+			else
+			{
+				for (int r=0; r<m_region.size(); r++)
+				{
+					drawSegment(p1, p2, color, m_region.rect(r));
+				}
+			}
 			////DEBUG2(p1.x, p1.y, p2.x, p2.y);
 		}
 		else
@@ -405,9 +750,76 @@ void CanvasSoft::drawPath(const Path& path, int color, bool thick)
 	}
 }
 
+void CanvasSoft::drawSegment(const Vec2& p1, const Vec2& p2, int color, const Rect& to)
+{
+	// Pixels inked: the segment less p2, one either side.
+	Rect seg(MIN(p1,p2) - Vec2(1,1), MAX(p1,p2) + Vec2(1,1));
+	if (to.contains(seg))
+	{
+		renderLine<Uint16,3,false>(SURFACE(this),m_w*2,p1.x, p1.y, p2.x, p2.y, color);
+	}
+	else if (to.intersects(seg))
+	{
+		renderLine<Uint16,3,true>(SURFACE(this),m_w*2,p1.x, p1.y, p2.x, p2.y, color, &to);
+	}
+}
+
 void CanvasSoft::drawRect(int x, int y, int w, int h, int c, bool fill)
 {
+	if (!fill)
+	{
+		drawRect(x, y, w, 1, c, true);
+		drawRect(x, y+h-1, w, 1, c, true);
+		drawRect(x, y, 1, h, c, true);
+		drawRect(x+w-1, y, 1, h, c, true);
+		return;
+	}
 
+	int x1 = MAX(x, m_clip.tl.x), y1 = MAX(y, m_clip.tl.y);
+	int x2 = MIN(x+w-1, m_clip.br.x), y2 = MIN(y+h-1, m_clip.br.y);
+	for (int j=y1; j<=y2; j++)
+	{
+		Uint16* row = (Uint16*)m_state + j*m_w;
+		for (int i=x1; i<=x2; i++)
+		{
+			row[i] = c;
+		}
+	}
+}
+
+void CanvasSoft::fillTriangle(float x0, float y0, float x1, float y1, float x2, float y2, int c)
+{
+	float area = (x1-x0)*(y2-y0) - (x2-x0)*(y1-y0);
+	if (area == 0.0f)
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		float t;
+		t = x1; x1 = x2; x2 = t;
+		t = y1; y1 = y2; y2 = t;
+	}
+
+	int left = MAX((int)MIN(x0, MIN(x1, x2)), m_clip.tl.x);
+	int right = MIN((int)MAX(x0, MAX(x1, x2)) + 1, m_clip.br.x);
+	int top = MAX((int)MIN(y0, MIN(y1, y2)), m_clip.tl.y);
+	int bottom = MIN((int)MAX(y0, MAX(y1, y2)) + 1, m_clip.br.y);
+	for (int j=top; j<=bottom; j++)
+	{
+		Uint16* row = (Uint16*)m_state + j*m_w;
+		float py = j + 0.5f;
+		for (int i=left; i<=right; i++)
+		{
+			float px = i + 0.5f;
+			if ((x1-x0)*(py-y0) - (y1-y0)*(px-x0) >= 0.0f
+				&& (x2-x1)*(py-y1) - (y2-y1)*(px-x1) >= 0.0f
+				&& (x0-x2)*(py-y2) - (y0-y2)*(px-x2) >= 0.0f)
+			{
+				row[i] = c;
+			}
+		}
+	}
 }
 
 void CanvasSoft::drawRect2(char *dst,int x, int y, int w, int h, int c, bool fill)
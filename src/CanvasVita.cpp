@@ -0,0 +1,182 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+/*
+* PSP port by rock88: rock88a@gmail.com
+* http://rock88dev.blogspot.com
+*/
+
+// vita2d backend for the Canvas primitives; the portable parts of Canvas
+// live in Canvas.cpp.
+
+#include "Canvas.h"
+#include "Pics.h"
+#include <vita2d.h>
+
+vita2d_texture *paper_pic, *paper_pic_dark, *pause_pic, *next_pic, *img_pic, *edit_pic, *layer_pic;
+unsigned short *paper_pic_data, *paper_pic_dark_data, *pause_pic_data, *next_pic_data, *img_pic_data, *edit_pic_data, *layer_pic_data;
+
+struct Vertex
+{
+	float x,y,z;
+};
+
+struct VertexUV
+{
+	float u, v;
+	unsigned int color;
+	float x,y,z;
+};
+
+struct Vertex __attribute__((aligned(16))) plane[2*3] =
+{
+	{2,		1,	0},
+	{-1,	1,	0},
+	{-1,	-1,	0},
+	{-1,	-1, 0},
+	{2,		-1, 0},
+	{2,		1,	0}
+};
+
+struct VertexUV __attribute__((aligned(16))) vertices[2*3] =
+{
+	{0, 0, 0, 4.9,		1.95, 	0},
+	{1, 0, 0, -1.95,	1.95, 	0},
+	{1, 1, 0, -1.9,		-1.95, 	0},
+	{1, 1, 0, -1.95,	-1.95,	0},
+	{0, 1, 0, 4.9,		-1.95, 	0},
+	{0, 0, 0, 4.9,		1.95, 	0}
+};
+
+void Canvas::LoadAssets()
+{
+
+	paper_pic = vita2d_create_empty_texture_format(512, 512, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	paper_pic_data = (unsigned short*)vita2d_texture_get_datap(paper_pic);
+
+	for (int i = 0; i < 512; i++)
+	{
+		for (int j = 0; j < 512; j++)
+			paper_pic_data[j + 512 * i] = PaperPic[j * 2 + 512 * i * 2] | PaperPic[j * 2 + 1 + 512 * i * 2] << 8;
+	}
+
+	paper_pic_dark = vita2d_create_empty_texture_format(512, 512, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	paper_pic_dark_data = (unsigned short*)vita2d_texture_get_datap(paper_pic_dark);
+
+	for (int i = 0; i < 512; i++)
+	{
+		for (int j = 0; j < 512; j++)
+			paper_pic_dark_data[j + 512 * i] = PaperDarkPic[j * 2 + 512 * i * 2] | PaperDarkPic[j * 2 + 1 + 512 * i * 2] << 8;
+	}
+
+	next_pic = vita2d_create_empty_texture_format(320, 192, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	next_pic_data = (unsigned short*)vita2d_texture_get_datap(next_pic);
+
+	for (int i = 0; i < 192; i++)
+	{
+		for (int j = 0; j < 320; j++)
+			next_pic_data[j + 320 * i] = NextPic[j * 2 + 512 * i * 2] | NextPic[j * 2 + 1 + 512 * i * 2] << 8;
+	}
+
+	img_pic = vita2d_create_empty_texture_format(THUMB_WIDTH, THUMB_HEIGHT, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	img_pic_data = (unsigned short*)vita2d_texture_get_datap(img_pic);
+
+	layer_pic = vita2d_create_empty_texture_format(960, 544, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	layer_pic_data = (unsigned short*)vita2d_texture_get_datap(layer_pic);
+
+	edit_pic = vita2d_create_empty_texture_format(128, 256, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	edit_pic_data = (unsigned short*)vita2d_texture_get_datap(edit_pic);
+
+	for (int i = 0; i < 256; i++)
+	{
+		for (int j = 0; j < 128; j++)
+			edit_pic_data[j + 128 * i] = EditPic[j * 2 + 128 * i * 2] | EditPic[j * 2 + 1 + 128 * i * 2] << 8;
+	}
+
+	pause_pic = vita2d_create_empty_texture_format(32, 32, SCE_GXM_TEXTURE_FORMAT_U5U6U5_BGR);
+	pause_pic_data = (unsigned short*)vita2d_texture_get_datap(pause_pic);
+
+	for (int i = 0; i < 32; i++)
+	{
+		for (int j = 0; j < 32; j++)
+			pause_pic_data[j + 32 * i] = PausePic[j * 2 + 32 * i * 2] | PausePic[j * 2 + 1 + 32 * i * 2] << 8;
+	}
+
+}
+
+void Canvas::clear()
+{
+	flush();
+	if (b_fade) vita2d_draw_texture_scale(paper_pic_dark, 0.0f, 0.0f, 2.0f, 2.0f);
+	else if (m_layer) vita2d_draw_texture(layer_pic, 0.0f, 0.0f);
+	else vita2d_draw_texture_scale(paper_pic, 0.0f, 0.0f, 2.0f, 2.0f);
+}
+
+// There is one layer texture; the pixels are copied up once here rather
+// than every frame.
+void Canvas::setLayer(const void* pixels)
+{
+	m_layer = pixels;
+	if (pixels) memcpy(layer_pic_data, pixels, 960 * 544 * 2);
+}
+
+// The vertices have to last until the GPU is done with the frame, so they
+// go in vita2d's per-frame pool.
+void Canvas::submit(const CanvasVertex* v, int n)
+{
+	vita2d_color_vertex* out = (vita2d_color_vertex*)vita2d_pool_memalign(
+		n * sizeof(vita2d_color_vertex), sizeof(vita2d_color_vertex));
+	if (!out) return;
+
+	for (int i=0; i<n; i++)
+	{
+		out[i].x = v[i].x;
+		out[i].y = v[i].y;
+		out[i].z = +0.5f;
+		out[i].color = v[i].colour;
+	}
+	vita2d_draw_array(SCE_GXM_PRIMITIVE_TRIANGLE_STRIP, out, n);
+}
+
+void Canvas::drawEdit(int x, int y)
+{
+	flush();
+	vita2d_draw_texture(edit_pic, x, y);
+}
+
+void Canvas::drawPause(int x, int y)
+{
+	flush();
+	vita2d_draw_texture_scale(pause_pic, x, y, 2.0f, 2.0f);
+}
+
+void Canvas::drawNext(int x, int y)
+{
+	flush();
+	vita2d_draw_texture_scale(next_pic, x, y, 2.0f, 2.0f);
+}
+
+void Canvas::setImage(const void* pixels)
+{
+	m_image = pixels;
+	if (pixels) memcpy(img_pic_data, pixels, THUMB_WIDTH * THUMB_HEIGHT * 2);
+}
+
+void Canvas::drawImage(int x, int y)
+{
+	if (!m_image) return;
+	flush();
+	vita2d_draw_texture(img_pic, x, y);
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include "DirtyRegion.h"
+
+static inline int rectArea(const Rect& r)
+{
+	return (r.br.x - r.tl.x + 1) * (r.br.y - r.tl.y + 1);
+}
+
+static inline Rect rectUnion(const Rect& a, const Rect& b)
+{
+	return Rect(MIN(a.tl, b.tl), MAX(a.br, b.br));
+}
+
+// Pixels redrawn for nothing if a and b, which don't overlap, are drawn
+// as one rectangle.
+static inline int mergeCost(const Rect& a, const Rect& b)
+{
+	return rectArea(rectUnion(a, b)) - rectArea(a) - rectArea(b);
+}
+
+DirtyRegion::DirtyRegion()
+{
+}
+
+void DirtyRegion::clear()
+{
+	m_rects.empty();
+}
+
+void DirtyRegion::add(const Rect& r)
+{
+	// A merged box can reach ones already passed over, so start again
+	// after each merge.
+	Rect u = r;
+	for (int i=0; i<m_rects.size(); )
+	{
+		if (m_rects[i].intersects(u) || mergeCost(m_rects[i], u) <= DIRTY_RECT_COST)
+		{
+			u = rectUnion(m_rects[i], u);
+			m_rects.erase(i);
+			i = 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	m_rects.append(u);
+
+	if (m_rects.size() > DIRTY_RECTS)
+	{
+		int bi = 0, bj = 1, best = mergeCost(m_rects[0], m_rects[1]);
+		for (int i=0; i<m_rects.size(); i++)
+		{
+			for (int j=i+1; j<m_rects.size(); j++)
+			{
+				int cost = mergeCost(m_rects[i], m_rects[j]);
+				if (cost < best)
+				{
+					best = cost;
+					bi = i;
+					bj = j;
+				}
+			}
+		}
+		Rect m = rectUnion(m_rects[bi], m_rects[bj]);
+		m_rects.erase(bj);
+		m_rects.erase(bi);
+		add(m);
+	}
+}
+
+bool DirtyRegion::intersects(const Rect& r) const
+{
+	for (int i=0; i<m_rects.size(); i++)
+	{
+		if (m_rects[i].intersects(r))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+Rect DirtyRegion::bounds() const
+{
+	Rect b = m_rects[0];
+	for (int i=1; i<m_rects.size(); i++)
+	{
+		b = rectUnion(b, m_rects[i]);
+	}
+	return b;
+}
+
+int DirtyRegion::area() const
+{
+	int a = 0;
+	for (int i=0; i<m_rects.size(); i++)
+	{
+		a += rectArea(m_rects[i]);
+	}
+	return a;
+}
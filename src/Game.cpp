@@ -24,11 +24,11 @@ Uint8 keys[20];
 
 const Rect FULLSCREEN_RECT( 0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1 );
 
-Image *Scene::g_bgImage = NULL;
-
 Game::Game(int t):m_pauseOverlay(*this, 2 * 430, 2 * 10, 2 * 32, 2 * 32),m_editOverlay(*this,0,0, 100, 200),completedOverlay(*this,2*80, 2 * 20, 2 * 320, 2 * 192)
 {
 	iterateCounter = 0;
+	m_rewindBack = 0;
+	m_rewindHeld = 0;
 	SDL_StartTicks();
 	lastTick = SDL_GetTicks();
 	isComplete = false;
@@ -56,9 +56,14 @@ void Game::gotoLevel(int l)
 	if (l >= 0 && l < m_levels.numLevels())
 	{
 		
-		m_scene.load( m_levels.levelFile(l).c_str() );
+		// Restarting the same level rebuilds it from memory.
+		if (l != m_level || !m_scene.restart())
+		{
+			m_scene.load( m_levels.levelFile(l).c_str() );
+		}
 		m_scene.activateAll();
 		m_level = l;
+		m_rewindBack = 0;	// the history went with the old scene
 		//m_window.setSubName(m_levels.levelFile(l).c_str());
 		m_refresh = true;
 		if (m_edit) m_scene.protect(0);
@@ -236,7 +241,7 @@ bool Game::handlePlayEvent(SceCtrlData &pad, SceTouchData &touch)
 				if (touch.reportNum > 0)
 				{
 					c_x = lerp(touch.report[0].x, 1920, 960);
-					x = c_x;
+					x = c_x;
 					c_y = lerp(touch.report[0].y, 1088, 544);
 					y = c_y;
 				}
@@ -489,13 +494,46 @@ void Game::run()
 
 		if (!m_pause)
 		{
-			//assumes RENDER_RATE <= ITERATION_RATE
-			while(iterateCounter < ITERATION_RATE)
+			// Holding L on its own runs time backwards at normal speed;
+			// letting go carries on from wherever it got to. L also
+			// starts a level change with Left/Right, so it only rewinds
+			// once held alone for a moment, and not again until let go
+			// after a level change.
+			if (!(pad.buttons & SCE_CTRL_LTRIGGER))
+			{
+				m_rewindHeld = 0;
+			}
+			else if (pad.buttons & (SCE_CTRL_LEFT|SCE_CTRL_RIGHT))
+			{
+				m_rewindHeld = -1;
+			}
+			else if (m_rewindHeld >= 0 && m_rewindHeld < REWIND_HOLD_FRAMES)
+			{
+				m_rewindHeld++;
+			}
+
+			if (m_rewindHeld >= REWIND_HOLD_FRAMES)
 			{
-				m_scene.step();
-				iterateCounter += RENDER_RATE;
+				m_rewindBack = b2Min(m_rewindBack + ITERATION_RATE / RENDER_RATE,
+									 b2Max(m_scene.rewind().frames() - 1, 0));
+				m_scene.rewind().show(m_scene, m_rewindBack);
+			}
+			else
+			{
+				if (m_rewindBack > 0)
+				{
+					m_scene.rewind().resume(m_scene, m_rewindBack);
+					m_rewindBack = 0;
+				}
+
+				//assumes RENDER_RATE <= ITERATION_RATE
+				while(iterateCounter < ITERATION_RATE)
+				{
+					m_scene.step();
+					iterateCounter += RENDER_RATE;
+				}
+				iterateCounter -= ITERATION_RATE;
 			}
-			iterateCounter -= ITERATION_RATE;
 		}
 
 		int sleepMs = lastTick + RENDER_INTERVAL -  SDL_GetTicks();
@@ -504,5 +542,6 @@ void Game::run()
 
 		m_window->drawRect(x-3, y-3, 7, 7, 0xFF000000, true);
 		m_window->drawRect(x-1, y-1, 3, 3, 0xFFFFFFFF, true);
+		m_window->flush();
 	}
 }
@@ -20,6 +20,13 @@
 
 #include "Levels.h"
 
+#ifdef __vita__
+#include <psp2/io/dirent.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
 using namespace std;
 
 static int rankFromPath(const string& p)
@@ -61,6 +68,7 @@ bool Levels::addPath(const char* path)
 	}
 	else
 	{
+#ifdef __vita__
 		int dir = sceIoDopen(path);
 		if (dir)
 		{
@@ -87,6 +95,33 @@ bool Levels::addPath(const char* path)
 			}
 			sceIoDclose(dir);
 		}
+#else
+		DIR *dir = opendir(path);
+		if (dir)
+		{
+			struct dirent *entry;
+			while ((entry = readdir(dir)) != NULL)
+			{
+				string full(path);
+				full += "/";
+				full += entry->d_name;
+				int n = strlen(entry->d_name);
+				struct stat st;
+				if (n >= 4 && stat(full.c_str(), &st) == 0 && !S_ISDIR(st.st_mode))
+				{
+					if (strcasecmp(entry->d_name + n - 4, ".zip") == 0)
+					{
+						scanCollection(full, rankFromPath(full));
+					}
+					else if (strcasecmp(entry->d_name + n - 4, ".nph") == 0)
+					{
+						addLevel(full, rankFromPath(full));
+					}
+				}
+			}
+			closedir(dir);
+		}
+#endif
 		else
 		{
 			printf("bogus level path %s\n",path);
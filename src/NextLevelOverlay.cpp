@@ -19,9 +19,6 @@
 */
 
 #include "NextLevelOverlay.h"
-#include "CanvasSoft.h"
-
-const Rect FULLSCREEN_RECT(0, 0, CANVAS_WIDTH-1, CANVAS_HEIGHT-1);
 
 NextLevelOverlay::NextLevelOverlay(GameParams& game, int x, int y, int w, int h):Overlay(game,x,y),m_levelIcon(-2),m_icon(NULL)
 {
@@ -29,12 +26,10 @@ NextLevelOverlay::NextLevelOverlay(GameParams& game, int x, int y, int w, int h)
 	m_y = y;
 	m_w = w;
 	m_h = h;
-	b = false;
 }
 
 NextLevelOverlay::~NextLevelOverlay()
 {
-	if(b) free(m_icon);
 }
 
 void NextLevelOverlay::onShow()
@@ -46,11 +41,12 @@ void NextLevelOverlay::draw(Canvas* screen)
 {
 	screen->fade(true);
 	screen->drawNext(m_x,m_y);
-	genIcon();
-	if(b)
+	// The screen keeps the thumbnail until the selection changes.
+	if (genIcon())
 	{
-		screen->drawImage(m_icon,m_x+50*2,m_y+38*2, 220, 110);
+		screen->setImage(m_icon);
 	}
+	screen->drawImage(m_x+50*2,m_y+38*2);
 }
 
 bool NextLevelOverlay::onClick(int x, int y)
@@ -85,20 +81,8 @@ bool NextLevelOverlay::genIcon()
 		//m_icon = NULL;
 		if (m_selectedLevel < m_game.m_levels.numLevels())
 		{
-			Scene scene(true);
-			if (scene.load( m_game.m_levels.levelFile(m_selectedLevel)))
-			{
-				if (b) free(m_icon);
-				printf("generating thumbnail %s\n",m_game.m_levels.levelFile(m_selectedLevel).c_str());
-				CanvasSoft* temp = new CanvasSoft(CANVAS_WIDTH, CANVAS_HEIGHT);
-				scene.draw(temp, FULLSCREEN_RECT);
-				m_icon = (char*)malloc(960*544*2);
-				b = true;
-				memcpy(m_icon,temp->scale(m_selectedLevel),960*544*2);
-				delete temp;
-				printf("generating thumbnail %s done\n",m_game.m_levels.levelFile(m_selectedLevel).c_str());
-			}
-			else
+			m_icon = m_thumbnails.get(m_game.m_levels.levelFile(m_selectedLevel));
+			if (!m_icon)
 			{
 				printf("failed to gen scene thumbnail %s\n",
 				m_game.m_levels.levelFile(m_selectedLevel).c_str());
@@ -107,15 +91,12 @@ bool NextLevelOverlay::genIcon()
 		else
 		{
 			//m_icon = new Image("theend.bmp");
-			if (b) 
-			{
-				free(m_icon);
-				b=false;
-			}
+			m_icon = NULL;
 			m_caption = "no more levels!";
 			m_selectedLevel = m_game.m_levels.numLevels();
 		}
 	m_levelIcon = m_selectedLevel;
+	return true;
 	}
-	return 0;//m_icon;
+	return false;
 }
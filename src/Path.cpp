@@ -19,15 +19,16 @@
 */
 
 
+#include <algorithm>
 #include "Path.h"
 
 
-Path::Path():Array<Vec2>()
+Path::Path():Array<Vec2, PATH_INLINE_POINTS>()
 {
 
 }
 
-Path::Path(int n, Vec2* p):Array<Vec2>(n, p)
+Path::Path(int n, Vec2* p):Array<Vec2, PATH_INLINE_POINTS>(n, p)
 {
 
 }
@@ -75,59 +76,128 @@ Path& Path::scale(float factor)
 	return *this;
 }
 
-void Path::simplify(float threshold)
+void Path::simplify(float threshold, int first)
 {
-	bool keepflags[size()];
-	memset(&keepflags[0], 0, sizeof(keepflags));
+	simplify(first, threshold, size());
+}
+
+void Path::simplifyTo(int maxPoints, float threshold)
+{
+	simplify(0, threshold, maxPoints);
+}
 
-	keepflags[0] = keepflags[size()-1] = true;
-	simplifySub(0, size()-1, threshold, &keepflags[0]);
+// A run of points between two kept ones, and the one furthest off the
+// line joining them.
+struct SimplifySpan
+{
+	int first, last;
+	int furthest;
+	float dist;
 
-	int k=0;
-	for (int i=0; i<size(); i++)
+	bool operator<(const SimplifySpan& o) const
 	{
-		if (keepflags[i])
-		{
-			at(k++) = at(i);
-		}
+		return dist < o.dist || (dist == o.dist && first > o.first);
 	}
-	
-	trim(size() - k);
+};
 
-	for (int i=size()-1; i>0; i--)
+static void pushSpan(const Path& path, int first, int last, float threshold,
+		     Array<SimplifySpan, 32>& heap)
+{
+	if (last - first < 2) return;
+
+	SimplifySpan s = { first, last, 0, threshold };
+	Segment seg(path.point(first), path.point(last));
+	for (int i=first+1; i<last; i++)
 	{
-		if (at(i) == at(i-1))
+		float d = seg.distanceTo(path.point(i));
+		if (d > s.dist)
 		{
-			erase(i);
+			s.dist = d;
+			s.furthest = i;
 		}
 	}
+	if (s.furthest != 0)
+	{
+		heap.append(s);
+		std::push_heap(&heap[0], &heap[0] + heap.size());
+	}
 }
 
-void Path::simplifySub(int first, int last, float threshold, bool* keepflags)
+// Splits the spans furthest first, so cutting it short at maxPoints
+// leaves the best maxPoints points, and letting it run gives the same
+// points as plain Douglas-Peucker. One pass, no recursion.
+void Path::simplify(int first, float threshold, int maxPoints)
 {
-	float furthestDist = threshold;
-	int furthestIndex = 0;
-	if (last - first > 1)
+	int n = size();
+	if (n - first > 2)
 	{
-		Segment s(at(first), at(last));
-		for (int i=first+1; i<last; i++)
+		Array<char, 256> keep(n);
+		keep.resize(n);
+		memset(&keep[0], 0, n);
+		memset(&keep[0], 1, first+1);
+		keep[n-1] = 1;
+		int kept = first + 2;
+
+		Array<SimplifySpan, 32> heap;
+		pushSpan(*this, first, n-1, threshold, heap);
+		while (heap.size() > 0 && kept < maxPoints)
 		{
-			float d = s.distanceTo(at(i));
-			if (d > furthestDist)
+			std::pop_heap(&heap[0], &heap[0] + heap.size());
+			SimplifySpan s = heap[heap.size()-1];
+			heap.erase(heap.size()-1);
+			keep[s.furthest] = 1;
+			kept++;
+			pushSpan(*this, s.first, s.furthest, threshold, heap);
+			pushSpan(*this, s.furthest, s.last, threshold, heap);
+		}
+
+		int k = first+1;
+		for (int i=first+1; i<n; i++)
+		{
+			if (keep[i])
 			{
-				furthestDist = d;
-				furthestIndex = i;
+				at(k++) = at(i);
 			}
 		}
-		if (furthestIndex != 0)
+		trim(n - k);
+	}
+
+	for (int i=size()-1; i>first && i>0; i--)
+	{
+		if (at(i) == at(i-1))
 		{
-			keepflags[furthestIndex] = true;
-			simplifySub(first, furthestIndex, threshold, keepflags);
-			simplifySub(furthestIndex, last, threshold, keepflags);
+			erase(i);
 		}
 	}
 }
 
+void PackedPath::append(const Vec2& p)
+{
+	ASSERT( p.x == (short)p.x && p.y == (short)p.y );
+	Point q = { (short)p.x, (short)p.y };
+	m_points.append(q);
+}
+
+void PackedPath::get(Path& path, int first) const
+{
+	int n = numPoints() - first;
+	path.resize(MAX(n, 0));
+	for (int i=0; i<n; i++)
+	{
+		path[i] = point(first + i);
+	}
+}
+
+void PackedPath::set(const Path& path, int first)
+{
+	m_points.resize(first);
+	m_points.reserve(first + path.numPoints());
+	for (int i=0; i<path.numPoints(); i++)
+	{
+		append(path.point(i));
+	}
+}
+
 Rect Path::bbox() const
 {
   Rect r( at(0), at(0) );
@@ -136,3 +206,248 @@ Rect Path::bbox() const
   }
   return r;
 }
+
+// Twice the signed area of triangle o,a,b.
+static inline long cross( const Vec2& o, const Vec2& a, const Vec2& b )
+{
+	return (long)(a.x-o.x)*(b.y-o.y) - (long)(a.y-o.y)*(b.x-o.x);
+}
+
+// Corners flatter than this (sine of the turn) are dropped or refused,
+// Box2D needs a clear turn between neighbouring edge normals.
+static inline bool sharpTurn( const Vec2& o, const Vec2& a, const Vec2& b )
+{
+	b2Vec2 e1 = b2Vec2(a) - b2Vec2(o);
+	b2Vec2 e2 = b2Vec2(b) - b2Vec2(a);
+	return (float)cross(o,a,b) > 0.01f * e1.Length() * e2.Length();
+}
+
+static bool segmentsTouch( const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& d )
+{
+	long d1 = cross(a,b,c), d2 = cross(a,b,d);
+	long d3 = cross(c,d,a), d4 = cross(c,d,b);
+	if (((d1>0 && d2<0) || (d1<0 && d2>0)) && ((d3>0 && d4<0) || (d3<0 && d4>0)))
+	{
+		return true;
+	}
+	Rect ab( MIN(a,b), MAX(a,b) ), cd( MIN(c,d), MAX(c,d) );
+	return (d1==0 && ab.contains(c))
+		|| (d2==0 && ab.contains(d))
+		|| (d3==0 && cd.contains(a))
+		|| (d4==0 && cd.contains(b));
+}
+
+struct ConvexPiece
+{
+	int n;
+	int v[b2_maxPolyVertices];
+};
+
+bool Path::decompose( int maxVertices, float minWidth,
+		      Path& vertices, Array<int>& counts ) const
+{
+	ASSERT( maxVertices >= 3 && maxVertices <= b2_maxPolyVertices );
+
+	// The ring, without the repeated end point and without flat corners.
+	Path ring( *this );
+	while (ring.size() > 1 && ring.at(0).x == ring.at(ring.size()-1).x
+	       && ring.at(0).y == ring.at(ring.size()-1).y)
+	{
+		ring.erase( ring.size()-1 );
+	}
+	for (int i=0; i<ring.size() && ring.size()>=3; )
+	{
+		const Vec2& o = ring.at( (i+ring.size()-1) % ring.size() );
+		const Vec2& a = ring.at( i );
+		const Vec2& b = ring.at( (i+1) % ring.size() );
+		long c = cross(o,a,b);
+		if (c==0 || (c>0 && !sharpTurn(o,a,b)) || (c<0 && !sharpTurn(b,a,o)))
+		{
+			ring.erase( i );
+			i = i>0 ? i-1 : 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	int n = ring.size();
+	if (n < 3)
+	{
+		return false;
+	}
+
+	long area = 0;
+	for (int i=0; i<n; i++)
+	{
+		area += cross( Vec2(0,0), ring.at(i), ring.at((i+1)%n) );
+	}
+	if (area == 0)
+	{
+		return false;
+	}
+	if (area < 0)
+	{
+		for (int i=0, j=n-1; i<j; i++, j--)
+		{
+			Vec2 t = ring.at(i);
+			ring.at(i) = ring.at(j);
+			ring.at(j) = t;
+		}
+	}
+
+	// Only simple polygons can be triangulated.
+	for (int i=0; i<n; i++)
+	{
+		for (int j=i+2; j<n; j++)
+		{
+			if (i==0 && j==n-1) continue;
+			if (segmentsTouch( ring.at(i), ring.at(i+1), ring.at(j), ring.at((j+1)%n) ))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Ear clipping.
+	Array<ConvexPiece> pieces( n-2 );
+	Array<int> left( n );
+	for (int i=0; i<n; i++)
+	{
+		left.append( i );
+	}
+	while (left.size() > 3)
+	{
+		int m = left.size();
+		int ear = -1;
+		for (int k=0; k<m && ear<0; k++)
+		{
+			const Vec2& o = ring.at( left[(k+m-1)%m] );
+			const Vec2& a = ring.at( left[k] );
+			const Vec2& b = ring.at( left[(k+1)%m] );
+			if (cross(o,a,b) <= 0) continue;
+
+			ear = k;
+			for (int j=0; j<m; j++)
+			{
+				if (j==k || j==(k+1)%m || j==(k+m-1)%m) continue;
+				const Vec2& p = ring.at( left[j] );
+				if (cross(o,a,p) >= 0 && cross(a,b,p) >= 0 && cross(b,o,p) >= 0)
+				{
+					ear = -1;
+					break;
+				}
+			}
+		}
+		if (ear < 0)
+		{
+			return false;
+		}
+
+		ConvexPiece t;
+		t.n = 3;
+		t.v[0] = left[(ear+m-1)%m];
+		t.v[1] = left[ear];
+		t.v[2] = left[(ear+1)%m];
+		pieces.append( t );
+		left.erase( ear );
+	}
+	ConvexPiece last;
+	last.n = 3;
+	last.v[0] = left[0];
+	last.v[1] = left[1];
+	last.v[2] = left[2];
+	pieces.append( last );
+
+	// Hertel-Mehlhorn: remove diagonals while the two pieces either side
+	// stay convex and small enough.
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (int a=0; a<pieces.size() && !merged; a++)
+		{
+			for (int b=a+1; b<pieces.size() && !merged; b++)
+			{
+				const ConvexPiece& pa = pieces[a];
+				const ConvexPiece& pb = pieces[b];
+				if (pa.n + pb.n - 2 > maxVertices) continue;
+
+				for (int i=0; i<pa.n && !merged; i++)
+				{
+					int u = pa.v[i], w = pa.v[(i+1)%pa.n];
+					int j = 0;
+					while (j<pb.n && !(pb.v[j]==w && pb.v[(j+1)%pb.n]==u)) j++;
+					if (j == pb.n) continue;
+
+					ConvexPiece r;
+					r.n = 0;
+					for (int k=1; k<=pa.n; k++)
+					{
+						r.v[r.n++] = pa.v[(i+k)%pa.n];
+					}
+					for (int k=2; k<pb.n; k++)
+					{
+						r.v[r.n++] = pb.v[(j+k)%pb.n];
+					}
+
+					bool convex = true;
+					for (int k=0; k<r.n && convex; k++)
+					{
+						convex = sharpTurn( ring.at(r.v[(k+r.n-1)%r.n]),
+						                    ring.at(r.v[k]),
+						                    ring.at(r.v[(k+1)%r.n]) );
+					}
+					if (convex)
+					{
+						pieces[a] = r;
+						pieces.erase( b );
+						merged = true;
+					}
+				}
+			}
+		}
+	}
+
+	// Refuse slivers: Box2D shifts every edge inwards by its slop and the
+	// result must still surround the centroid.
+	for (int p=0; p<pieces.size(); p++)
+	{
+		const ConvexPiece& piece = pieces[p];
+		b2Vec2 p0 = b2Vec2( ring.at(piece.v[0]) );
+		b2Vec2 c( 0.0f, 0.0f );
+		float sum = 0.0f;
+		for (int k=1; k+1<piece.n; k++)
+		{
+			b2Vec2 a = b2Vec2( ring.at(piece.v[k]) );
+			b2Vec2 b = b2Vec2( ring.at(piece.v[k+1]) );
+			float t = b2Cross( a - p0, b - p0 );
+			c += t * (p0 + a + b);
+			sum += t;
+		}
+		c *= 1.0f / (3.0f * sum);
+		for (int k=0; k<piece.n; k++)
+		{
+			const Vec2& o = ring.at( piece.v[(k+piece.n-1)%piece.n] );
+			const Vec2& a = ring.at( piece.v[k] );
+			const Vec2& b = ring.at( piece.v[(k+1)%piece.n] );
+			b2Vec2 e = b2Vec2(b) - b2Vec2(a);
+			float d = b2Cross( e, c - b2Vec2(a) ) / e.Length();
+			if (d < minWidth || !sharpTurn(o,a,b))
+			{
+				return false;
+			}
+		}
+	}
+
+	for (int p=0; p<pieces.size(); p++)
+	{
+		for (int k=0; k<pieces[p].n; k++)
+		{
+			vertices.append( ring.at(pieces[p].v[k]) );
+		}
+		counts.append( pieces[p].n );
+	}
+	return true;
+}
@@ -0,0 +1,494 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include "Rewind.h"
+#include "Scene.h"
+
+// Stroke poses are kept to 1/16 pixel and 1/4096 radian: plenty for
+// drawing, and small enough deltas that a moving stroke costs 4-6 bytes a
+// step. Resuming never uses them, it replays from a snapshot.
+#define REWIND_POS_SCALEf   (PIXELS_PER_METREf * 16.0f)
+#define REWIND_ANGLE_SCALEf 4096.0f
+
+// A record is a 4 byte length, a type byte and the payload. A length of -1
+// (or no room for a length) sends the reader back to the start.
+#define REWIND_WRAP  -1
+#define REWIND_KEY   'K'
+#define REWIND_DELTA 'D'
+
+static char* putInt(char* p, int v)
+{
+	memcpy(p, &v, sizeof(int));
+	return p + sizeof(int);
+}
+
+static int getInt(const char* p)
+{
+	int v;
+	memcpy(&v, p, sizeof(int));
+	return v;
+}
+
+// Zigzag varints: small values of either sign take one byte, none more
+// than REWIND_VAR_MAX.
+#define REWIND_VAR_MAX 5
+
+static char* putVar(char* p, int v)
+{
+	unsigned u = ((unsigned)v << 1) ^ (unsigned)(v >> 31);
+	while (u >= 0x80)
+	{
+		*p++ = (char)(u | 0x80);
+		u >>= 7;
+	}
+	*p++ = (char)u;
+	return p;
+}
+
+static int getVar(const char*& p)
+{
+	unsigned u = 0;
+	int shift = 0;
+	unsigned char c;
+	do
+	{
+		c = *p++;
+		u |= (unsigned)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return (int)(u >> 1) ^ -(int)(u & 1);
+}
+
+// Quantise the stroke's pose into q, unless its body has not moved since
+// raw was last filled in. Most bodies are asleep or static.
+static void quantise(Stroke* s, int* q, float* raw)
+{
+	b2Body* b = s->body();
+	if (b && (b->m_position.x != raw[0] || b->m_position.y != raw[1] || b->m_rotation != raw[2]))
+	{
+		raw[0] = b->m_position.x;
+		raw[1] = b->m_position.y;
+		raw[2] = b->m_rotation;
+
+		b2Vec2 p = b->GetOriginPosition();
+		q[0] = (int)floorf(p.x * REWIND_POS_SCALEf + 0.5f);
+		q[1] = (int)floorf(p.y * REWIND_POS_SCALEf + 0.5f);
+		q[2] = (int)floorf(b->GetRotation() * REWIND_ANGLE_SCALEf + 0.5f);
+	}
+}
+
+Rewind::Rewind(int maxBytes, int keyInterval)
+	: m_buf(NULL), m_capacity(0), m_keyInterval(1)
+{
+	configure(maxBytes, keyInterval);
+}
+
+Rewind::~Rewind()
+{
+	free(m_buf);
+}
+
+void Rewind::configure(int maxBytes, int keyInterval)
+{
+	if (maxBytes != m_capacity)
+	{
+		free(m_buf);
+		m_buf = maxBytes > 0 ? (char*)malloc(maxBytes) : NULL;
+		m_capacity = m_buf ? maxBytes : 0;
+	}
+	m_keyInterval = keyInterval > 0 ? keyInterval : 1;
+	clear();
+}
+
+void Rewind::clear()
+{
+	m_head = m_tail = 0;
+	m_last = -1;
+	m_segments.empty();
+	m_strokeCount = -1;
+	m_tracked.empty();
+	m_pose.empty();
+	m_raw.empty();
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+// Only strokes with bodies can move. Decor strokes never get one, and
+// strokes that do are only ever given one by Scene::activate, which
+// clears the history.
+void Rewind::track(Scene& scene)
+{
+	Array<Stroke*>& strokes = scene.strokes();
+	m_strokeCount = strokes.size();
+	for (int i=0; i<strokes.size(); i++)
+	{
+		if (strokes[i]->body())
+		{
+			m_tracked.append(i);
+		}
+	}
+
+	m_pose.resize(3 * m_tracked.size());
+	m_raw.resize(3 * m_tracked.size());
+	for (int i=0; i<m_pose.size(); i++)
+	{
+		m_pose[i] = 0;
+		m_raw[i] = NAN;
+	}
+}
+
+void Rewind::encode(Scene& scene, bool key)
+{
+	Array<Stroke*>& strokes = scene.strokes();
+	int header = sizeof(int) + 1;
+	int poses = 3 * REWIND_VAR_MAX * m_tracked.size();
+	char* p;
+
+	if (key)
+	{
+		scene.saveSnapshot(m_snapshot);
+		m_frame.resize(header + 2 * sizeof(int) + m_snapshot.size() + poses);
+		p = &m_frame[0] + header;
+		p = putInt(p, m_tracked.size());
+		p = putInt(p, m_snapshot.size());
+		memcpy(p, &m_snapshot[0], m_snapshot.size());
+		p += m_snapshot.size();
+
+		for (int i=0; i<m_tracked.size(); i++)
+		{
+			int* q = &m_pose[3*i];
+			quantise(strokes[m_tracked[i]], q, &m_raw[3*i]);
+			p = putVar(p, q[0]);
+			p = putVar(p, q[1]);
+			p = putVar(p, q[2]);
+		}
+	}
+	else
+	{
+		// A bit per stroke for whether it moved, then the moves.
+		int maskBytes = (m_tracked.size() + 7) / 8;
+		m_frame.resize(header + maskBytes + poses);
+		char* mask = &m_frame[0] + header;
+		memset(mask, 0, maskBytes);
+		p = mask + maskBytes;
+
+		for (int i=0; i<m_tracked.size(); i++)
+		{
+			int* q = &m_pose[3*i];
+			int o[3] = { q[0], q[1], q[2] };
+			quantise(strokes[m_tracked[i]], q, &m_raw[3*i]);
+			if (o[0] != q[0] || o[1] != q[1] || o[2] != q[2])
+			{
+				mask[i/8] |= 1 << (i%8);
+				p = putVar(p, q[0] - o[0]);
+				p = putVar(p, q[1] - o[1]);
+				p = putVar(p, q[2] - o[2]);
+			}
+		}
+		m_stats.bodySteps += m_tracked.size();
+	}
+
+	m_frame[sizeof(int)] = key ? REWIND_KEY : REWIND_DELTA;
+	m_frame.resize(p - &m_frame[0]);
+	putInt(&m_frame[0], m_frame.size() - sizeof(int));
+}
+
+void Rewind::evict()
+{
+	m_segments.erase(0);
+	if (m_segments.size() > 0)
+	{
+		m_head = m_segments[0].offset;
+	}
+	else
+	{
+		m_head = m_tail = 0;
+	}
+}
+
+// Find room for a record of the given size at the tail, dropping the
+// oldest segments as needed. -1 if it would not fit in an empty buffer.
+int Rewind::allocate(int bytes)
+{
+	if (bytes > m_capacity)
+	{
+		return -1;
+	}
+
+	while (true)
+	{
+		if (m_segments.size() == 0)
+		{
+			m_head = m_tail = 0;
+			return 0;
+		}
+
+		if (m_tail > m_head)
+		{
+			if (m_tail + bytes <= m_capacity)
+			{
+				return m_tail;
+			}
+			if (m_head == 0)
+			{
+				evict();
+				continue;
+			}
+			if (m_capacity - m_tail >= (int)sizeof(int))
+			{
+				int wrap = REWIND_WRAP;
+				memcpy(m_buf + m_tail, &wrap, sizeof(int));
+			}
+			m_tail = 0;
+		}
+		else if (m_tail + bytes <= m_head)
+		{
+			return m_tail;
+		}
+		else
+		{
+			evict();
+		}
+	}
+}
+
+void Rewind::record(Scene& scene)
+{
+	if (m_capacity == 0 || scene.world() == NULL)
+	{
+		return;
+	}
+
+	// Strokes added or removed: the history no longer fits the scene.
+	if (m_strokeCount != scene.strokes().size())
+	{
+		clear();
+		track(scene);
+	}
+
+	bool key = m_segments.size() == 0 || m_segments[m_segments.size()-1].count >= m_keyInterval;
+	encode(scene, key);
+	int offset = allocate(m_frame.size());
+	if (!key && m_segments.size() == 0)
+	{
+		// The segment this delta belonged to had to go to make room.
+		key = true;
+		encode(scene, key);
+		offset = allocate(m_frame.size());
+	}
+
+	if (offset < 0)
+	{
+		clear();
+		return;
+	}
+
+	memcpy(m_buf + offset, &m_frame[0], m_frame.size());
+	m_tail = offset + m_frame.size();
+	m_last++;
+
+	if (key)
+	{
+		Segment s = { offset, m_last, 1 };
+		m_segments.append(s);
+		m_stats.keyBytes += m_frame.size();
+	}
+	else
+	{
+		m_segments[m_segments.size()-1].count++;
+		m_stats.deltaBytes += m_frame.size();
+	}
+}
+
+int Rewind::frames() const
+{
+	return m_segments.size() ? m_last - m_segments[0].first + 1 : 0;
+}
+
+int Rewind::findSegment(int frame) const
+{
+	int lo = 0, hi = m_segments.size() - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (m_segments[mid].first <= frame)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+int Rewind::next(int offset) const
+{
+	if (m_capacity - offset < (int)sizeof(int) || getInt(m_buf + offset) == REWIND_WRAP)
+	{
+		return 0;
+	}
+	return offset;
+}
+
+// Decode the record at offset into m_decoded; returns where the next
+// record starts.
+int Rewind::decodeKey(int offset, const char** snapshot, int* snapshotSize)
+{
+	const char* p = m_buf + offset + sizeof(int);
+	ASSERT(*p == REWIND_KEY);
+	p++;
+
+	int tracked = getInt(p);
+	*snapshotSize = getInt(p + sizeof(int));
+	*snapshot = p + 2 * sizeof(int);
+	p = *snapshot + *snapshotSize;
+
+	m_decoded.resize(3 * tracked);
+	for (int i=0; i<m_decoded.size(); i++)
+	{
+		m_decoded[i] = getVar(p);
+	}
+	return next(p - m_buf);
+}
+
+int Rewind::decodeDelta(int offset)
+{
+	const char* p = m_buf + offset + sizeof(int);
+	ASSERT(*p == REWIND_DELTA);
+	p++;
+
+	int tracked = m_decoded.size() / 3;
+	const char* mask = p;
+	p += (tracked + 7) / 8;
+	for (int i=0; i<tracked; i++)
+	{
+		if (mask[i/8] & (1 << (i%8)))
+		{
+			m_decoded[3*i] += getVar(p);
+			m_decoded[3*i+1] += getVar(p);
+			m_decoded[3*i+2] += getVar(p);
+		}
+	}
+	return next(p - m_buf);
+}
+
+// Move the stroke bodies to the decoded poses. Only the transforms are
+// touched: contacts and the broad-phase are left as they were, which is
+// fine for drawing and put right by the next resume.
+void Rewind::apply(Scene& scene)
+{
+	Array<Stroke*>& strokes = scene.strokes();
+	for (int i=0; i<m_tracked.size(); i++)
+	{
+		b2Body* b = strokes[m_tracked[i]]->body();
+		if (b)
+		{
+			b2Vec2 origin(m_decoded[3*i] / REWIND_POS_SCALEf, m_decoded[3*i+1] / REWIND_POS_SCALEf);
+			b->m_rotation = m_decoded[3*i+2] / REWIND_ANGLE_SCALEf;
+			b->m_R.Set(b->m_rotation);
+			b->m_position = origin + b2Mul(b->m_R, b->m_center);
+		}
+	}
+}
+
+bool Rewind::show(Scene& scene, int back)
+{
+	if (back < 0 || back >= frames() || m_strokeCount != scene.strokes().size())
+	{
+		return false;
+	}
+
+	int frame = m_last - back;
+	const Segment& s = m_segments[findSegment(frame)];
+	const char* snapshot;
+	int snapshotSize;
+	int offset = decodeKey(s.offset, &snapshot, &snapshotSize);
+	for (int f=s.first+1; f<=frame; f++)
+	{
+		offset = decodeDelta(offset);
+	}
+
+	apply(scene);
+	return true;
+}
+
+bool Rewind::resume(Scene& scene, int back)
+{
+	if (back < 0 || back >= frames() || m_strokeCount != scene.strokes().size())
+	{
+		return false;
+	}
+
+	int frame = m_last - back;
+	int seg = findSegment(frame);
+	const Segment& s = m_segments[seg];
+	const char* snapshot;
+	int snapshotSize;
+	int end = s.offset + sizeof(int) + getInt(m_buf + s.offset);
+	decodeKey(s.offset, &snapshot, &snapshotSize);
+
+	m_snapshot.resize(snapshotSize);
+	memcpy(&m_snapshot[0], snapshot, snapshotSize);
+
+	// Forget everything after the key and carry on recording from it.
+	m_segments.trim(m_segments.size() - 1 - seg);
+	m_segments[seg].count = 1;
+	m_tail = end;
+	m_last = s.first;
+	m_pose = m_decoded;
+	for (int i=0; i<m_raw.size(); i++)
+	{
+		m_raw[i] = NAN;
+	}
+
+	if (!scene.restoreSnapshot(m_snapshot))
+	{
+		clear();
+		return false;
+	}
+
+	for (int f=s.first; f<frame; f++)
+	{
+		scene.step();
+	}
+	return true;
+}
+
+RewindStats Rewind::stats() const
+{
+	RewindStats stats = m_stats;
+	stats.frames = frames();
+	stats.keyFrames = m_segments.size();
+	stats.capacity = m_capacity;
+	if (m_segments.size() == 0)
+	{
+		stats.bytesUsed = 0;
+	}
+	else if (m_tail > m_head)
+	{
+		stats.bytesUsed = m_tail - m_head;
+	}
+	else
+	{
+		stats.bytesUsed = m_capacity - m_head + m_tail;
+	}
+	return stats;
+}
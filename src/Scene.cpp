@@ -21,25 +21,40 @@
 #include "Scene.h"
 
 const Rect BOUNDS_RECT(-CANVAS_WIDTH/4, -CANVAS_HEIGHT,CANVAS_WIDTH*5/4, CANVAS_HEIGHT);
+
+Image *Scene::g_bgImage = NULL;
 			
-Scene::Scene(bool noWorld):m_world(NULL),m_bgImage(NULL),m_protect(0)
+Scene::Scene(bool noWorld):m_world(NULL),m_haveTemplate(false),m_bgImage(NULL),m_protect(0),
+	m_rewind(noWorld ? 0 : REWIND_BYTES, REWIND_KEY_STEPS),
+	m_index(BOUNDS_RECT, STROKE_INDEX_CELL),
+	m_layer(NULL),m_layerStale(true)
 {
 	if (!noWorld)
 	{
-		b2AABB worldAABB;
-		worldAABB.minVertex.Set(-100.0f, -100.0f);
-		worldAABB.maxVertex.Set(100.0f, 100.0f);
-      
-		b2Vec2 gravity(0.0f, 10.0f);
-		bool doSleep = true;
-		m_world = new b2World(worldAABB, gravity, doSleep);
+		m_world = newWorld();
     }
 }
 
+b2World* Scene::newWorld()
+{
+	b2AABB worldAABB;
+	worldAABB.minVertex.Set(-100.0f, -100.0f);
+	worldAABB.maxVertex.Set(100.0f, 100.0f);
+
+	b2Vec2 gravity(0.0f, 10.0f);
+	bool doSleep = true;
+	b2World* world = new b2World(worldAABB, gravity, doSleep, b2_dynamicTree);
+	world->SetListener(this);
+	world->SetContactListener(this);
+	return world;
+}
+
 Scene::~Scene()
 {
 	clear();
+	clearTemplate();
 	delete m_world;
+	delete m_layer;
 }
 
 int Scene::numStrokes()
@@ -51,6 +66,8 @@ Stroke* Scene::newStroke(const Path& p)
 {
 	Stroke *s = new Stroke(p);
 	m_strokes.append(s);
+	m_rewind.clear();
+	m_index.invalidate();
 	return s;
 }
 
@@ -61,8 +78,13 @@ void Scene::deleteStroke(Stroke *s)
 		int i = m_strokes.indexOf(s);
 		if (i >= m_protect)
 		{
+			if (s->isStatic()) m_layerStale = true;
 			reset(s);
 			m_strokes.erase(m_strokes.indexOf(s));
+			m_rewind.clear();
+			m_index.invalidate();
+			if ((i = m_goalHits.indexOf(s)) >= 0) m_goalHits.erase(i);
+			if ((i = m_strayTokens.indexOf(s)) >= 0) m_strayTokens.erase(i);
 		}
 	}
 }
@@ -70,7 +92,10 @@ void Scene::deleteStroke(Stroke *s)
 void Scene::activate( Stroke *s )
 {
 	s->createBodies(*m_world);
+	m_index.invalidate();
+	if (s->isStatic()) m_layerStale = true;
 	createJoints(s);
+	m_rewind.clear();
 }
 
 void Scene::activateAll()
@@ -79,21 +104,34 @@ void Scene::activateAll()
 	{
 		m_strokes[i]->createBodies(*m_world);
 	}
+	m_index.invalidate();
+	m_layerStale = true;
 	
 	for (int i=0; i < m_strokes.size(); i++)
 	{
 		createJoints( m_strokes[i] );
 	}
+	m_rewind.clear();
 }
 
+// Only strokes whose box comes within the joint tolerance of s can join
+// it; they are tried in the same (reverse) order as the full list was.
 void Scene::createJoints(Stroke *s)
 {
-	for (int j=m_strokes.size()-1; j>=0; j--)
+	int tol = (int)JOINT_TOLERANCE + 1;
+	Rect r = s->extent();
+	r.tl -= Vec2(tol, tol);
+	r.br += Vec2(tol, tol);
+	m_index.update(m_strokes);
+	m_index.query(r, m_near);
+
+	for (int k=m_near.size()-1; k>=0; k--)
 	{      
-		if (s != m_strokes[j])
+		Stroke* other = m_strokes[m_near[k]];
+		if (s != other)
 		{
-			s->maybeCreateJoint(*m_world, m_strokes[j]);
-			m_strokes[j]->maybeCreateJoint(*m_world, s);
+			s->maybeCreateJoint(*m_world, other);
+			other->maybeCreateJoint(*m_world, s);
 		}
 	}    
 }
@@ -101,32 +139,66 @@ void Scene::createJoints(Stroke *s)
 void Scene::step()
 {
 	m_world->Step(ITERATION_TIMESTEPf, SOLVER_ITERATIONS);
+	m_index.invalidate();
 
-	for (b2Contact* c = m_world->GetContactList(); c; c = c->GetNext())
+	for (int i=0; i < m_goalHits.size(); i++)
 	{
-		if (c->GetManifoldCount() > 0)
+		m_goalHits[i]->hide();
+	}
+	m_goalHits.empty();
+
+	// Put stray tokens back in stroke order without losing the rewind
+	// history: a snapshot from before copes with the new body.
+	for (int i=0; m_strayTokens.size() > 0 && i < m_strokes.size(); i++)
+	{
+		int j = m_strayTokens.indexOf(m_strokes[i]);
+		if (j >= 0)
 		{
-			Stroke* s1 = (Stroke*)c->GetShape1()->GetBody()->GetUserData();
-			Stroke* s2 = (Stroke*)c->GetShape2()->GetBody()->GetUserData();
-			if (s1 && s2)
-			{
-				if (s2->hasAttribute(Stroke::ATTRIB_TOKEN)) b2Swap(s1, s2);
-			}
-			
-			if (s1->hasAttribute(Stroke::ATTRIB_TOKEN) && s2->hasAttribute(Stroke::ATTRIB_GOAL)) s2->hide();
+			m_strayTokens.erase(j);
+			reset(m_strokes[i]);
+			m_strokes[i]->createBodies(*m_world);
+			m_index.invalidate();
+			createJoints(m_strokes[i]);
 		}
 	}
 
-	for (int i=0; i < m_strokes.size(); i++)
+	m_rewind.record(*this);
+}
+
+void Scene::strayToken(Stroke* s)
+{
+	if (s && s->hasAttribute(Stroke::ATTRIB_TOKEN) && m_strayTokens.indexOf(s) < 0)
 	{
-		if (m_strokes[i]->hasAttribute(Stroke::ATTRIB_TOKEN) && !BOUNDS_RECT.intersects(m_strokes[i]->lastDrawnBbox()))
+		m_strayTokens.append(s);
+	}
+}
+
+void Scene::BeginContact(b2Contact* contact)
+{
+	Stroke* s1 = (Stroke*)contact->GetShape1()->GetBody()->GetUserData();
+	Stroke* s2 = (Stroke*)contact->GetShape2()->GetBody()->GetUserData();
+	if (s1 && s2)
+	{
+		if (s2->hasAttribute(Stroke::ATTRIB_TOKEN)) b2Swap(s1, s2);
+		if (s1->hasAttribute(Stroke::ATTRIB_TOKEN) && s2->hasAttribute(Stroke::ATTRIB_GOAL)
+			&& m_goalHits.indexOf(s2) < 0)
 		{
-			reset(m_strokes[i]);
-			activate(m_strokes[i]);
+			m_goalHits.append(s2);
 		}
 	}
 }
 
+void Scene::NotifyJointDestroyed(b2Joint* joint)
+{
+}
+
+b2BoundaryResponse Scene::NotifyBoundaryViolated(b2Body* body)
+{
+	// Left frozen; step resets it along with the off-screen ones.
+	strayToken((Stroke*)body->GetUserData());
+	return b2_freezeBody;
+}
+
 bool Scene::isCompleted()
 {
 	for (int i=0; i < m_strokes.size(); i++)
@@ -139,35 +211,45 @@ bool Scene::isCompleted()
 
 Rect Scene::dirtyArea()
 {
-	Rect r(0,0,0,0),temp;
+	DirtyRegion region;
+	dirtyRegion(region);
+	return region.size() ? region.bounds() : Rect(0,0,0,0);
+}
+
+static inline void addDirty(DirtyRegion& region, Rect r)
+{
+	r.tl.x--; r.tl.y--;
+	r.br.x++; r.br.y++;
+	region.add(r);
+}
+
+void Scene::dirtyRegion(DirtyRegion& region)
+{
+	Stroke::transformAll(m_strokes);
+
+	region.clear();
+	Rect r;
 	int numDirty = 0;
 	for (int i=0; i<m_strokes.size(); i++)
 	{
 		if (m_strokes[i]->isDirty())
 		{
-			temp = m_strokes[i]->bbox();
-			if (!temp.isEmpty())
+			r = m_strokes[i]->bbox();
+			if (!r.isEmpty())
 			{
-				if (numDirty==0)
-				{	
-					r = temp;
-				}
-				else
+				// Every bbox() call but the first moves the hide animation on,
+				// and games have always been timed with a second call for all
+				// dirty strokes after the first.
+				if (numDirty > 0)
 				{
-					r.expand(m_strokes[i]->bbox());
+					r = m_strokes[i]->bbox();
 				}
-			r.expand(m_strokes[i]->lastDrawnBbox());
-			numDirty++;
+				addDirty(region, r);
+				addDirty(region, m_strokes[i]->lastDrawnBbox());
+				numDirty++;
 			}
 		}
 	}
-	
-	if (!r.isEmpty())
-	{
-		r.tl.x--; r.tl.y--;
-		r.br.x++; r.br.y++;
-	}
-	return r;
 }
 
 void Scene::draw(Canvas* canvas, const Rect& area)
@@ -180,42 +262,77 @@ void Scene::draw(Canvas* canvas, const Rect& area)
 	{
 		canvas->setBackground(0);
     }
+	if (m_layerStale || !m_layer)
+	{
+		drawLayer();
+		canvas->setLayer(m_layer->scale(1));
+	}
+	else if (canvas->layer() != m_layer->scale(1))
+	{
+		canvas->setLayer(m_layer->scale(1));
+	}
     canvas->clear();
 	//canvas->clear(area);
-    Rect clipArea = area;
-    clipArea.tl.x--;
-    clipArea.tl.y--;
-    clipArea.br.x++;
-    clipArea.br.y++;
+	// With the layer down, the static strokes are already on the paper.
+	bool layered = canvas->layered();
     for (int i=0; i<m_strokes.size(); i++)
 	{
-		//if (area.intersects(m_strokes[i]->bbox()))
+		if (!layered || !m_strokes[i]->isStatic())
 		{
 			m_strokes[i]->draw(canvas);
 		}
+		// Only drawing moves lastDrawnBbox, so this is where tokens leave
+		// the screen.
+		if (!BOUNDS_RECT.intersects(m_strokes[i]->lastDrawnBbox())) strayToken(m_strokes[i]);
     }
 	//canvas.drawRect( area, 0xffff0000, false );
 }
 
+// Static strokes are drawn in the software renderer, which is what
+// the layer is made with, so they look the same as in level thumbnails.
+void Scene::drawLayer()
+{
+	if (!m_layer)
+	{
+		m_layer = new CanvasSoft(CANVAS_WIDTH, CANVAS_HEIGHT);
+	}
+	m_layer->clear();
+	for (int i=0; i<m_strokes.size(); i++)
+	{
+		if (m_strokes[i]->isStatic())
+		{
+			m_strokes[i]->draw(m_layer);
+		}
+	}
+	m_layerStale = false;
+}
+
 void Scene::draw(CanvasSoft* canvas, const Rect& area)
 {
+	DirtyRegion region;
+	region.add(area);
+	draw(canvas, region);
+}
 
-	//canvas->setBackground(0);
-    canvas->clear();
-    Rect clipArea = area;
-    clipArea.tl.x--;
-    clipArea.tl.y--;
-    clipArea.br.x++;
-    clipArea.br.y++;
-	//DEBUG("Scene::draw"," ",m_strokes.size());
+void Scene::draw(CanvasSoft* canvas, const DirtyRegion& region)
+{
+	for (int r=0; r<region.size(); r++)
+	{
+		canvas->clear(region.rect(r));
+	}
+	canvas->setClip(region);
+	canvas->beginBands();
+	// Every stroke still goes through draw() to keep its animation and
+	// lastDrawnBbox going; those outside the region paint nothing.
     for (int i=0; i<m_strokes.size(); i++)
 	{
-		//if (area.intersects(m_strokes[i]->bbox()))
-		{
-			m_strokes[i]->draw(canvas);
-		}
+		m_strokes[i]->draw(canvas);
+		// Only drawing moves lastDrawnBbox, so this is where tokens leave
+		// the screen.
+		if (!BOUNDS_RECT.intersects(m_strokes[i]->lastDrawnBbox())) strayToken(m_strokes[i]);
     }
-	//canvas.drawRect( area, 0xffff0000, false );
+	canvas->endBands();
+	canvas->resetClip();
 }
 
 void Scene::reset(Stroke* s)
@@ -224,18 +341,23 @@ void Scene::reset(Stroke* s)
 	{
 		if (s==NULL || s==m_strokes[i]) m_strokes[i]->reset(m_world);
 	}    
+	m_index.invalidate();
 }
 
 Stroke* Scene::strokeAtPoint(const Vec2 pt, float max)
 {
+	int reach = (int)max + 1;
+	m_index.update(m_strokes);
+	m_index.query(Rect(pt - Vec2(reach, reach), pt + Vec2(reach, reach)), m_near);
+
 	Stroke* best = NULL;
-	for (int i=0; i<m_strokes.size(); i++)
+	for (int k=0; k<m_near.size(); k++)
 	{
-		float d = m_strokes[i]->distanceTo(pt);
+		float d = m_strokes[m_near[k]]->distanceTo(pt);
 		if (d < max)
 		{
 			max = d;
-			best = m_strokes[i];
+			best = m_strokes[m_near[k]];
 		}
 	}
 	return best;
@@ -243,26 +365,38 @@ Stroke* Scene::strokeAtPoint(const Vec2 pt, float max)
 
 void Scene::clear()
 {
-	reset();
-	while(m_strokes.size())
+	for (int i=0; i<m_strokes.size(); i++)
 	{
-		delete m_strokes[0];
-		m_strokes.erase(0);
+		delete m_strokes[i];
 	}
+	m_strokes.empty();
+	m_rewind.clear();
+	m_index.invalidate();
+	m_layerStale = true;
+	m_goalHits.empty();
+	m_strayTokens.empty();
+
+	// The strokes' bodies go with everything else in the world.
 	if (m_world)
 	{
-		while(m_world->GetBodyList())
-		{
-			m_world->DestroyBody( m_world->GetBodyList() );	       
-		}
-		m_world->Step(ITERATION_TIMESTEPf, SOLVER_ITERATIONS);
+		m_world->Reset();
 	}
 }
 
+void Scene::clearTemplate()
+{
+	for (int i=0; i<m_template.size(); i++)
+	{
+		delete m_template[i];
+	}
+	m_template.empty();
+	m_haveTemplate = false;
+}
+
 bool Scene::load(const string& file)
 {
 	//DEBUG(__FILE__,__FUNCTION__,__LINE__);
-	clear();
+	clearTemplate();
 	//DEBUG(__FILE__,__FUNCTION__,__LINE__);
 	if (g_bgImage==NULL) g_bgImage = NULL;//!new Image("paper.bmp");
 	//DEBUG(__FILE__,__FUNCTION__,__LINE__);
@@ -304,14 +438,148 @@ bool Scene::load(const string& file)
       case 'T': m_title = line.substr(line.find(':')+1); break;
       case 'B': m_bg = line.substr(line.find(':')+1); break;
       case 'A': m_author = line.substr(line.find(':')+1); break;
-      case 'S': m_strokes.append( new Stroke(line) ); break;
+      case 'S': m_template.append( new Stroke(line) ); break;
       }
     }
     i.close();
+	m_haveTemplate = true;
 	//DEBUG(__FILE__,__FUNCTION__,__LINE__);
+
+	return restart();
+}
+
+bool Scene::restart()
+{
+	if (!m_haveTemplate)
+	{
+		return false;
+	}
+
+	clear();
+	for (int i=0; i<m_template.size(); i++)
+	{
+		m_strokes.append( new Stroke(*m_template[i]) );
+	}
+	m_index.invalidate();
 	protect();
-	//DEBUG(__FILE__,__FUNCTION__,__LINE__);
+	return true;
+}
+
+// Scene snapshots lead with the stroke count, then the hide step and
+// body list position (-1 for none) of each stroke, then the world's.
+void Scene::saveSnapshot(Array<char>& snapshot)
+{
+	int header = (1 + 2 * m_strokes.size()) * sizeof(int);
+	snapshot.resize(header + m_world->GetSnapshotSize());
+
+	int* strokes = (int*)&snapshot[0];
+	strokes[0] = m_strokes.size();
+	for (int i=0; i<m_strokes.size(); i++)
+	{
+		strokes[1+2*i] = m_strokes[i]->hideStep();
+		strokes[2+2*i] = -1;
+	}
+
+	int index = 0;
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext(), index++)
+	{
+		int i = m_strokes.indexOf((Stroke*)b->GetUserData());
+		if (i >= 0)
+		{
+			strokes[2+2*i] = index;
+		}
+	}
+
+	int size = m_world->SaveSnapshot(&snapshot[header], snapshot.size() - header);
+	ASSERT(size > 0);
+	snapshot.resize(header + size);
+}
+
+bool Scene::restoreSnapshot(const Array<char>& snapshot)
+{
+	if (snapshot.size() < (int)sizeof(int))
+	{
+		return false;
+	}
+
+	const int* strokes = (const int*)&snapshot[0];
+	int header = (1 + 2 * strokes[0]) * sizeof(int);
+	if (strokes[0] != m_strokes.size() || snapshot.size() <= header)
+	{
+		return false;
+	}
+
+	const char* world = &snapshot[header];
+	int size = snapshot.size() - header;
+	if (!m_world->RestoreSnapshot(world, size))
+	{
+		// Bodies have come and gone since (a token fell off the world and
+		// was put back, say). Rebuild them in the order the snapshot has
+		// them; the world list is last created first. The rebuild goes
+		// into a new world, so that if the snapshot still does not fit
+		// (joints made against bodies that have since moved) the running
+		// world and strokes can be put back untouched.
+		b2World* running = m_world;
+		Array<Stroke> kept(m_strokes.size());
+		m_world = newWorld();
+		m_world->SetWorkerCount(running->GetWorkerCount());
+		int bodies = 0;
+		for (int i=0; i<m_strokes.size(); i++)
+		{
+			kept.append(*m_strokes[i]);
+			m_strokes[i]->reset();
+			bodies = b2Max(bodies, strokes[2+2*i] + 1);
+		}
+
+		for (int index=bodies-1; index>=0; index--)
+		{
+			for (int i=0; i<m_strokes.size(); i++)
+			{
+				if (strokes[2+2*i] == index)
+				{
+					m_strokes[i]->createBodies(*m_world);
+				}
+			}
+		}
+		m_index.invalidate();
+
+		for (int i=0; i<m_strokes.size(); i++)
+		{
+			if (m_strokes[i]->body())
+			{
+				createJoints(m_strokes[i]);
+			}
+		}
 
+		b2World* discard = running;
+		bool restored = m_world->RestoreSnapshot(world, size);
+		if (!restored)
+		{
+			discard = m_world;
+			m_world = running;
+			for (int i=0; i<m_strokes.size(); i++)
+			{
+				// Drop whatever the rebuild cached for it.
+				m_strokes[i]->reset();
+				*m_strokes[i] = kept[i];
+			}
+			m_index.invalidate();
+		}
+
+		// Reset first: chain shapes own memory the destructor leaves.
+		discard->Reset();
+		delete discard;
+		if (!restored)
+		{
+			return false;
+		}
+	}
+
+	for (int i=0; i<m_strokes.size(); i++)
+	{
+		m_strokes[i]->hideStep(strokes[1+2*i]);
+	}
+	m_index.invalidate();
 	return true;
 }
 
@@ -334,6 +602,8 @@ bool Scene::save(const std::string& file)
 			o << m_strokes[i]->asString();
 		}
 		o.close();
+		// The file no longer matches what was loaded.
+		clearTemplate();
 		return true;
 	} 
 	else 
@@ -346,3 +616,13 @@ Array<Stroke*>& Scene::strokes()
 {
 	return m_strokes;
 }
+
+b2World* Scene::world()
+{
+	return m_world;
+}
+
+Rewind& Scene::rewind()
+{
+	return m_rewind;
+}
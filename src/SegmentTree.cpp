@@ -0,0 +1,131 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include "SegmentTree.h"
+#include "Segment.h"
+
+#define LEAF_SEGMENTS 4
+#define MAX_DEPTH     32
+
+SegmentTree::SegmentTree() : m_points(0)
+{
+}
+
+void SegmentTree::clear()
+{
+	m_nodes.empty();
+	m_points = 0;
+}
+
+bool SegmentTree::covers(int points) const
+{
+	return m_points > 0 && m_points == points;
+}
+
+void SegmentTree::build(const Path& path)
+{
+	m_nodes.empty();
+	m_points = path.numPoints();
+	if (m_points > 1)
+	{
+		build(path, 0, m_points - 1);
+	}
+}
+
+int SegmentTree::build(const Path& path, int first, int count)
+{
+	int index = m_nodes.size();
+	m_nodes.append(Node());
+
+	Rect box(path.point(first), path.point(first));
+	for (int i=first+1; i<=first+count; i++)
+	{
+		box.expand(path.point(i));
+	}
+	Node n;
+	n.x0 = box.tl.x;
+	n.y0 = box.tl.y;
+	n.x1 = box.br.x;
+	n.y1 = box.br.y;
+	n.first = first;
+	n.count = count;
+	n.right = -1;
+
+	if (count > LEAF_SEGMENTS)
+	{
+		int half = count / 2;
+		build(path, first, half);
+		n.right = build(path, first + half, count - half);
+	}
+	m_nodes[index] = n;
+	return index;
+}
+
+float SegmentTree::boxDistanceSq(const Node& n, const b2Vec2& p) const
+{
+	float dx = b2Max(b2Max((float)n.x0 - p.x, p.x - (float)n.x1), 0.0f);
+	float dy = b2Max(b2Max((float)n.y0 - p.y, p.y - (float)n.y1), 0.0f);
+	return dx * dx + dy * dy;
+}
+
+float SegmentTree::distanceTo(const Path& measured, const Vec2& pt, const b2Vec2& local,
+							  float slack, float best) const
+{
+	if (m_nodes.size() == 0)
+	{
+		return best;
+	}
+
+	// Nearer child first, so later boxes are more often beyond best.
+	int stack[MAX_DEPTH];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		int index = stack[--top];
+		const Node& n = m_nodes[index];
+		float reach = best + slack;
+		if (boxDistanceSq(n, local) > reach * reach)
+		{
+			continue;
+		}
+
+		if (n.right < 0)
+		{
+			for (int i=n.first; i<n.first+n.count; i++)
+			{
+				Segment s(measured.point(i), measured.point(i+1));
+				float d = s.distanceTo(pt);
+				if (d < best) best = d;
+			}
+		}
+		else
+		{
+			int left = index + 1;
+			if (boxDistanceSq(m_nodes[left], local) < boxDistanceSq(m_nodes[n.right], local))
+			{
+				stack[top++] = n.right;
+				stack[top++] = left;
+			}
+			else
+			{
+				stack[top++] = left;
+				stack[top++] = n.right;
+			}
+		}
+	}
+	return best;
+}
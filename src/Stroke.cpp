@@ -20,13 +20,59 @@
 
 #include "Stroke.h"
 
-Stroke::Stroke(const Path& path):m_rawPath(path)
+Stroke::FillMode Stroke::s_fillClosed = Stroke::FILL_DRAWN;
+bool Stroke::s_segmentTree = true;
+
+// Transformed points are rounded to the nearest pixel, so each can be
+// out by up to half a pixel on each axis from the exact rotation of the
+// raw path.
+#define XFORM_SLACKf 1.0f
+
+// Transformed paths held for the sleeping, static and unbodied strokes
+// most recently drawn or measured, to start with. transformAll() adds
+// slots until there is one for each such stroke in the scene.
+#define XFORM_SLOTS 32
+
+// Working space shared by all strokes. Only the raw path is kept with
+// each: the shape and convex pieces last from process() until the bodies
+// are made, and transformed paths live in s_xformed until the stroke
+// moves or its slot goes to another. Awake dynamic strokes are moved
+// every step and drawn every frame, so each keeps its own StrokeXform
+// until its body sleeps.
+struct XformSlot
+{
+	Stroke*  owner;
+	Path     path;
+};
+
+struct StrokeXform
+{
+	Path         path;		// transformed, if valid
+	bool         valid;
+	Array<float> localX;	// raw path as floats, padded to whole lanes
+	Array<float> localY;
+};
+
+static Path s_raw;
+static Path s_shape;
+static Path s_convex;
+static Array<XformSlot> s_xformed;
+static int s_xformNext = 0;	// slot to give out next
+static Array<float> s_localX;	// raw path as floats, padded to whole lanes
+static Array<float> s_localY;
+
+Stroke::Stroke(const Path& path)
 {
 //DEBUG(__FILE__,__FUNCTION__,__LINE__);
 	m_colour = COLOUR_BLUE;
 	m_attributes = 0;
-	m_origin = m_rawPath.point(0);
-	m_rawPath.translate( -m_origin );
+	m_origin = path.point(0);
+	m_rawPath.set( path - m_origin );
+	m_folded = 0;
+	m_xformSlot = 0;
+	m_awake = NULL;
+	m_activated = false;
+	m_playerDrawn = true;
 	reset();
 //DEBUG(__FILE__,__FUNCTION__,__LINE__);
 }
@@ -38,7 +84,13 @@ Stroke::Stroke(const string& str)
 	m_colour = brush_colours[2];
 	m_attributes = 0;
 	m_origin = Vec2(400,240);
+	m_folded = 0;
+	m_xformSlot = 0;
+	m_awake = NULL;
+	m_activated = false;
+	m_playerDrawn = false;
 	reset();
+	Path path;
 	const char *s = str.c_str();
 	
 	while (*s && *s!=':' && *s!='\n') 
@@ -66,35 +118,41 @@ Stroke::Stroke(const string& str)
 		{
 			float x1 = x*(CANVAS_WIDTHf/800.0f);
 			float y1 = y*(CANVAS_HEIGHTf/480.0f);
-			m_rawPath.append( Vec2((int)x1,(int)y1) );
+			path.append( Vec2((int)x1,(int)y1) );
 			while ( *s && *s!=' ' && *s!='\t' ) s++;
 			while ( *s==' ' || *s=='\t' ) s++;
 		}
 	}
 	
-	if ( m_rawPath.size() < 2 )
+	if ( path.size() < 2 )
 	{
 		printf("invalid stroke def\n");
 	}
 	
-	m_origin = m_rawPath.point(0);
-	m_rawPath.translate( -m_origin );
+	m_origin = path.point(0);
+	m_rawPath.set( path - m_origin );
 	setAttribute( ATTRIB_DUMMY );
 //DEBUG(__FILE__,__FUNCTION__,__LINE__);
 }
 
+Stroke::~Stroke()
+{
+	releaseAwake();
+}
+
 void Stroke::reset(b2World* world)
 {
 	if (m_body && world) world->DestroyBody(m_body);
 
 	m_body = NULL;
 	m_xformAngle = 7.0f;
+	m_xformStale = true;
 	m_drawnBbox.tl = m_origin;
 	m_drawnBbox.br = m_origin;
 	m_jointed[0] = m_jointed[1] = false;
-	m_shapePath = m_rawPath;
 	m_hide = 0;
 	m_drawn = false;
+	releaseAwake();
 }
 
 string Stroke::asString()
@@ -115,10 +173,11 @@ string Stroke::asString()
 	
 	s << ":";
 	transform();
+	const Path& path = xformed();
 	
-	for (int i=0; i<m_xformedPath.size(); i++)
+	for (int i=0; i<path.size(); i++)
 	{
-		const Vec2& p = m_xformedPath.point(i);
+		const Vec2& p = path.point(i);
 		float x1 = p.x/(CANVAS_WIDTHf/800.0f);
 		float y1 = p.y/(CANVAS_HEIGHTf/480.0f);
 		int x2 = (int)x1;
@@ -150,18 +209,43 @@ void Stroke::setColour(int c)
 void Stroke::createBodies( b2World& world )
 {
 	process();
+	m_activated = true;
 	if (hasAttribute(ATTRIB_DECOR)) return;
 
-	int n = m_shapePath.numPoints();
+	int n = s_shape.numPoints();
 	
 	if ( n > 1 )
 	{
-		BoxDef boxDef[n];
+		ChainDef chainDef;
+		PolyDef polyDef[b2_maxShapesPerBody];
 		b2BodyDef bodyDef;
-		for (int i=1; i<n; i++)
+		if (m_convexCounts.size() > 0)
+		{
+			// Mass of the outline chain over the filled area.
+			float length = 0.0f, area = 0.0f;
+			for (int i=0; i<n; i++)
+			{
+				b2Vec2 a = s_shape.point(i);
+				b2Vec2 b = s_shape.point((i+1)%n);
+				length += (b - a).Length();
+				area += b2Cross(a, b);
+			}
+			length *= 1.0f/PIXELS_PER_METREf;
+			area = b2Abs(0.5f*area) * (1.0f/(PIXELS_PER_METREf*PIXELS_PER_METREf));
+			float scale = length * 2.0f * chainDef.radius / area;
+
+			const Vec2* p = &s_convex.point(0);
+			for (int i=0; i<m_convexCounts.size(); i++)
+			{
+				polyDef[i].init(p, m_convexCounts[i], m_attributes, scale);
+				bodyDef.AddShape(&polyDef[i]);
+				p += m_convexCounts[i];
+			}
+		}
+		else
 		{
-			boxDef[i].init(m_shapePath.point(i-1),m_shapePath.point(i),m_attributes );
-			bodyDef.AddShape(&boxDef[i]);
+			chainDef.init(s_shape, m_attributes);
+			bodyDef.AddShape(&chainDef);
 		}
 		bodyDef.position = m_origin;
 		bodyDef.position *= 1.0f/PIXELS_PER_METREf;
@@ -187,12 +271,14 @@ bool Stroke::maybeCreateJoint(b2World& world, Stroke* other)
 	if (m_body && other->body())
 	{
 		transform();
-		int n = m_xformedPath.numPoints();
+		// Measuring the other stroke takes over the shared path.
+		const Path& path = xformed();
+		Vec2 ends[2] = { path.point(0), path.point(path.numPoints()-1) };
 		for (int end=0; end<2; end++)
 		{
 			if (!m_jointed[end])
 			{
-				const Vec2& p = m_xformedPath.point( end ? n-1 : 0 );
+				const Vec2& p = ends[end];
 				if (other->distanceTo( p ) <= JOINT_TOLERANCE)
 				{
 					b2Vec2 pw = p;
@@ -216,7 +302,7 @@ void Stroke::draw(Canvas* canvas)
 	if (m_hide < HIDE_STEPS)
 	{
 		transform();
-		canvas->drawPath( m_xformedPath, canvas->makeColour(m_colour), true );
+		canvas->drawPath( xformed(), canvas->makeColour(m_colour), true );
 		m_drawn = true;
 	}
 	m_drawnBbox = m_xformBbox;
@@ -228,7 +314,10 @@ void Stroke::draw(CanvasSoft* canvas)
 	{
 		//DEBUG("Stroke::draw"," ",0);
 		transform();
-		canvas->drawPath( m_xformedPath, canvas->makeColour(m_colour), true );
+		if (canvas->visible(m_xformBbox))
+		{
+			canvas->drawPath( xformed(), canvas->makeColour(m_colour), true );
+		}
 		m_drawn = true;
 	}
 	m_drawnBbox = m_xformBbox;
@@ -237,13 +326,26 @@ void Stroke::draw(CanvasSoft* canvas)
 void Stroke::addPoint(const Vec2& pp) 
 {
 	Vec2 p = pp; p -= m_origin;
-	if (p == m_rawPath.point(m_rawPath.numPoints()-1))
+	if (p == m_rawPath.last())
 	{
 	} 
 	else
 	{
 		m_rawPath.append( p );
 		m_drawn = false;
+		m_xformStale = true;
+		releaseAwake();
+		// Folding below can leave the point count unchanged with
+		// different points, so covers() cannot tell the tree is stale.
+		m_tree.clear();
+
+		if (m_rawPath.numPoints() - m_folded > SIMPLIFY_FOLD_POINTS)
+		{
+			m_rawPath.get( s_raw, m_folded );
+			s_raw.simplify( 0.1*SIMPLIFY_THRESHOLDf );
+			m_rawPath.set( s_raw, m_folded );
+			m_folded = m_rawPath.numPoints() - 1;
+		}
 	}
 }
 
@@ -256,6 +358,8 @@ void Stroke::origin(const Vec2& p)
 		m_body->SetOriginPosition(pw, m_body->GetRotation());
 	}
 	m_origin = p;
+	m_xformStale = true;
+	forgetXformed();
 }
 
 b2Body* Stroke::body()
@@ -267,14 +371,35 @@ float Stroke::distanceTo(const Vec2& pt)
 {
 	float best = 100000.0;
 	transform();
+	const Path& path = xformed();
 	
-	for (int i=1; i<m_xformedPath.numPoints(); i++)
-	{    
-		Segment s(m_xformedPath.point(i-1), m_xformedPath.point(i));
-		float d = s.distanceTo( pt );
-		if ( d < best ) best = d;
+	// A hiding stroke shrinks about its centre, away from the raw path.
+	// Short ones are as quick to scan as to search.
+	if (m_hide || !s_segmentTree || path.numPoints() <= 8)
+	{
+		for (int i=1; i<path.numPoints(); i++)
+		{    
+			Segment s(path.point(i-1), path.point(i));
+			float d = s.distanceTo( pt );
+			if ( d < best ) best = d;
+		}
+		return best;
 	}
-	return best;
+
+	// addPoint and process clear the tree whenever the raw path changes.
+	if (!m_tree.covers(m_rawPath.numPoints()))
+	{
+		m_rawPath.get(s_raw);
+		m_tree.build(s_raw);
+	}
+
+	if (m_body)
+	{
+		b2Mat22 rot(m_xformAngle);
+		b2Vec2 local = b2MulT(rot, b2Vec2(pt) - PIXELS_PER_METREf * m_xformPos);
+		return m_tree.distanceTo(path, pt, local, XFORM_SLACKf, best);
+	}
+	return m_tree.distanceTo(path, pt, b2Vec2(pt - m_origin), 0.0f, best);
 }
 
 Rect Stroke::bbox() 
@@ -283,6 +408,12 @@ Rect Stroke::bbox()
 	return m_xformBbox;
 }
 
+Rect Stroke::extent()
+{
+	if (m_hide == 0) transform();
+	return m_xformBbox;
+}
+
 Rect Stroke::lastDrawnBbox() 
 {
 	return m_drawnBbox;
@@ -313,11 +444,34 @@ bool Stroke::hidden()
 	return m_hide >= HIDE_STEPS;
 }
 
+// Until then it may still be being drawn.
+bool Stroke::isStatic()
+{
+	return m_activated && (m_attributes & (ATTRIB_GROUND|ATTRIB_DECOR)) != 0;
+}
+
+int Stroke::hideStep()
+{
+	return m_hide;
+}
+
+void Stroke::hideStep(int n)
+{
+	m_hide = n;
+	m_drawn = false;
+	forgetXformed();
+}
+
 int Stroke::numPoints()
 {
 	return m_rawPath.numPoints();
 }
 
+bool Stroke::filled()
+{
+	return m_convexCounts.size() > 0;
+}
+
 float Stroke::vec2Angle( b2Vec2 v ) 
 {
 	float a=atan(v.y/v.x);
@@ -326,14 +480,47 @@ float Stroke::vec2Angle( b2Vec2 v )
 
 void Stroke::process()
 {
+	// Only the points added since the last fold in addPoint are left.
 	float thresh = 0.1*SIMPLIFY_THRESHOLDf;
-	m_rawPath.simplify( thresh );
-	m_shapePath = m_rawPath;
+	m_rawPath.get( s_raw, m_folded );
+	s_raw.simplify( thresh );
+	m_rawPath.set( s_raw, m_folded );
+	m_rawPath.shrink();
+	m_folded = m_rawPath.numPoints() - 1;
+	m_tree.clear();
+	m_xformStale = true;
+	releaseAwake();
+	m_rawPath.get( s_shape );
 
-	while (m_shapePath.numPoints() > MULTI_VERTEX_LIMIT)
+	if (s_shape.numPoints() > MULTI_VERTEX_LIMIT)
 	{
-		thresh += SIMPLIFY_THRESHOLDf;
-		m_shapePath.simplify(thresh);
+		s_shape.simplifyTo( MULTI_VERTEX_LIMIT, thresh );
+	}
+
+	// A stroke that ends near where it started, relative to its size, is
+	// a closed outline: fill it with convex pieces so nothing can get
+	// inside, though that takes more shapes. Self-crossing loops or
+	// ones that would need more than CLOSED_MAX_PIECES stay a chain, as
+	// does everything read from a level file.
+	s_convex.empty();
+	m_convexCounts.empty();
+	int n = s_shape.numPoints();
+	bool fill = s_fillClosed == FILL_ALL || (s_fillClosed == FILL_DRAWN && m_playerDrawn);
+	if (fill && n > 3)
+	{
+		Rect r = s_shape.bbox();
+		b2Vec2 gap = b2Vec2(s_shape.last()) - b2Vec2(s_shape.first());
+		float size = (float)MIN(r.br.x-r.tl.x, r.br.y-r.tl.y);
+		if (size > 0.0f && gap.Length() <= CLOSED_SHAPE_THREHOLDf*size)
+		{
+			float minWidth = 2.0f*b2_toiSlop*PIXELS_PER_METREf;
+			if (!s_shape.decompose(b2_maxPolyVertices, minWidth, s_convex, m_convexCounts)
+				|| m_convexCounts.size() > CLOSED_MAX_PIECES)
+			{
+				s_convex.empty();
+				m_convexCounts.empty();
+			}
+		}
 	}
 }
 
@@ -343,60 +530,257 @@ bool Stroke::transform()
 	{
 		if (m_hide < HIDE_STEPS)
 		{
-			Vec2 o = m_xformBbox.centroid();
-			m_xformedPath -= o;
-			m_xformedPath.scale( 0.99 );
-			m_xformedPath += o;
-			m_xformBbox = m_xformedPath.bbox();
 			m_hide++;
+			forgetXformed();
+			m_xformBbox = xformed().bbox();
 			return true;
 		}
 	}
 	else 
 	if (m_body)
 	{
-		if (hasAttribute(ATTRIB_DECOR))
+		if (!moved())
 		{
 			return false;
 		}
-		else
-		if (hasAttribute(ATTRIB_GROUND) && (m_xformAngle == m_body->GetRotation()))
+		transformBody();
+	}
+	else
+	{
+		if (m_xformStale)
 		{
-			return false;
+			m_xformStale = false;
+			forgetXformed();
+			m_xformBbox = xformed().bbox();
 		}
-		else
-		if (m_xformAngle != m_body->GetRotation() || !(m_xformPos == m_body->GetOriginPosition()))
+		return false;
+	}
+	return true;
+}
+
+bool Stroke::moved()
+{
+	return m_xformStale || m_xformAngle != m_body->GetRotation()
+		|| !(m_xformPos == m_body->GetOriginPosition());
+}
+
+// Rotate and translate the local points a lane at a time, rounding to whole
+// pixels, and take the box in the same pass. Rounding keeps the order of
+// coordinates so the box of the floats rounds to the box of the pixels.
+static Rect transformLocal(const float* lx, const float* ly, int n,
+						   const b2Mat22& rot, const b2Vec2& orig, Vec2* out)
+{
+	b2FloatW c = b2SplatW(rot.col1.x), s = b2SplatW(rot.col1.y);
+	b2FloatW ox = b2SplatW(orig.x + 0.5f), oy = b2SplatW(orig.y + 0.5f);
+	b2FloatW x0 = b2SplatW(FLT_MAX), y0 = x0;
+	b2FloatW x1 = b2SplatW(-FLT_MAX), y1 = x1;
+	float32 x[b2_simdWidth], y[b2_simdWidth];
+
+	for (int i=0; i<n; i+=b2_simdWidth)
+	{
+		b2FloatW px = b2LoadW(lx + i), py = b2LoadW(ly + i);
+		b2FloatW wx = b2AddW(b2SubW(b2MulW(c, px), b2MulW(s, py)), ox);
+		b2FloatW wy = b2AddW(b2AddW(b2MulW(s, px), b2MulW(c, py)), oy);
+		x0 = b2MinW(x0, wx); y0 = b2MinW(y0, wy);
+		x1 = b2MaxW(x1, wx); y1 = b2MaxW(y1, wy);
+
+		b2StoreW(x, wx);
+		b2StoreW(y, wy);
+		for (int k=0; k<b2_simdWidth && i+k<n; k++)
 		{
-			b2Mat22 rot(m_body->GetRotation());
-			b2Vec2 orig = PIXELS_PER_METREf * m_body->GetOriginPosition();
-			m_xformedPath = m_rawPath;
-			m_xformedPath.rotate( rot );
-			m_xformedPath.translate( Vec2(orig) );
-			m_xformAngle = m_body->GetRotation();
-			m_xformPos = m_body->GetOriginPosition();
-			m_xformBbox = m_xformedPath.bbox();
+			out[i+k] = Vec2((int)floorf(x[k]), (int)floorf(y[k]));
 		}
-		else
-		if (!(m_xformPos == m_body->GetOriginPosition()))
+	}
+
+	float32 l[b2_simdWidth], t[b2_simdWidth], r[b2_simdWidth], b[b2_simdWidth];
+	b2StoreW(l, x0); b2StoreW(t, y0);
+	b2StoreW(r, x1); b2StoreW(b, y1);
+	for (int k=1; k<b2_simdWidth; k++)
+	{
+		l[0] = b2Min(l[0], l[k]); t[0] = b2Min(t[0], t[k]);
+		r[0] = b2Max(r[0], r[k]); b[0] = b2Max(b[0], b[k]);
+	}
+	return Rect((int)floorf(l[0]), (int)floorf(t[0]), (int)floorf(r[0]), (int)floorf(b[0]));
+}
+
+// The raw path as floats. The lanes past the last point repeat it, so
+// whole lanes can be loaded without changing the box.
+static void unpackLocal(const PackedPath& raw, Array<float>& lx, Array<float>& ly)
+{
+	int n = raw.numPoints();
+	int padded = (n + b2_simdWidth - 1) / b2_simdWidth * b2_simdWidth;
+	lx.resize(padded);
+	ly.resize(padded);
+	for (int i=0; i<padded; i++)
+	{
+		Vec2 p = raw.point(MIN(i, n-1));
+		lx[i] = (float)p.x;
+		ly[i] = (float)p.y;
+	}
+}
+
+// Transform into out from the stroke's own float lanes when it has them,
+// or else from ones unpacked into the shared s_localX and s_localY.
+Rect Stroke::transformRaw(Path& out)
+{
+	Array<float>* lx = &s_localX;
+	Array<float>* ly = &s_localY;
+	if (m_awake)
+	{
+		lx = &m_awake->localX;
+		ly = &m_awake->localY;
+	}
+	else
+	{
+		unpackLocal(m_rawPath, s_localX, s_localY);
+	}
+	int n = m_rawPath.numPoints();
+	out.resize(n);
+	return transformLocal(&(*lx)[0], &(*ly)[0], n, b2Mat22(m_xformAngle),
+						  PIXELS_PER_METREf * m_xformPos, &out[0]);
+}
+
+void Stroke::transformBody()
+{
+	m_xformStale = false;
+	m_xformAngle = m_body->GetRotation();
+	m_xformPos = m_body->GetOriginPosition();
+	if (!m_body->IsStatic() && !m_body->IsSleeping())
+	{
+		if (!m_awake)
 		{
-			//NOT WORKING printf("transform stroke - pos\n");
-			b2Vec2 move = m_body->GetOriginPosition() - m_xformPos;
-			move *= PIXELS_PER_METREf;
-			m_xformedPath.translate( Vec2(move) );
-			m_xformPos = m_body->GetOriginPosition();
-			m_xformBbox = m_xformedPath.bbox();
+			m_awake = new StrokeXform;
+			unpackLocal(m_rawPath, m_awake->localX, m_awake->localY);
+			forgetXformed();
+		}
+		m_xformBbox = transformRaw(m_awake->path);
+		m_awake->valid = true;
+	}
+	else
+	{
+		if (m_awake)
+		{
+			m_awake->valid = false;
+		}
+		bool held;
+		Path& path = xformSlot(held);
+		m_xformBbox = transformRaw(path);
+	}
+	m_drawn = false;
+}
+
+// The slot holding this stroke's transformed path, or the next free one
+// round, or failing that the next one round taken over for it.
+Path& Stroke::xformSlot(bool& held)
+{
+	growXformSlots(XFORM_SLOTS);
+	XformSlot* slot = &s_xformed[m_xformSlot];
+	held = slot->owner == this;
+	if (!held)
+	{
+		int n = s_xformed.size();
+		int next = s_xformNext;
+		for (int i=0; i<n && s_xformed[next].owner; i++)
+		{
+			next = (next + 1) % n;
+		}
+		if (s_xformed[next].owner)
+		{
+			next = s_xformNext;
+		}
+		m_xformSlot = next;
+		s_xformNext = (next + 1) % n;
+		slot = &s_xformed[m_xformSlot];
+		slot->owner = this;
+	}
+	return slot->path;
+}
+
+// The raw path where the body or origin last put it, shrunk about its
+// centre for each step of the hide animation so far. It holds until any
+// other stroke's is asked for.
+const Path& Stroke::xformed()
+{
+	if (m_awake && m_awake->valid)
+	{
+		return m_awake->path;
+	}
+	bool held;
+	Path& path = xformSlot(held);
+	if (!held)
+	{
+		if (m_body)
+		{
+			transformRaw(path);
 		}
 		else
 		{
-			return false;
+			m_rawPath.get(path);
+			path.translate(m_origin);
+		}
+		for (int i=1; i<m_hide; i++)
+		{
+			Vec2 o = path.bbox().centroid();
+			path -= o;
+			path.scale( 0.99 );
+			path += o;
 		}
 	}
-	else
+	return path;
+}
+
+void Stroke::forgetXformed()
+{
+	if (m_xformSlot < s_xformed.size() && s_xformed[m_xformSlot].owner == this)
 	{
-		m_xformedPath = m_rawPath;
-		m_xformedPath.translate( m_origin );
-		m_xformBbox = m_xformedPath.bbox();      
-		return false;
+		s_xformed[m_xformSlot].owner = NULL;
 	}
-	return true;
+	if (m_awake)
+	{
+		m_awake->valid = false;
+	}
+}
+
+void Stroke::releaseAwake()
+{
+	forgetXformed();
+	delete m_awake;
+	m_awake = NULL;
+}
+
+// Slots are only added, so the ones strokes hold stay theirs.
+void Stroke::growXformSlots(int n)
+{
+	int old = s_xformed.size();
+	if (n > old)
+	{
+		s_xformed.resize(n);
+		for (int i=old; i<n; i++)
+		{
+			s_xformed[i].owner = NULL;
+		}
+	}
+}
+
+void Stroke::transformAll(Array<Stroke*>& strokes)
+{
+	int shared = 0;
+	for (int i=0; i<strokes.size(); i++)
+	{
+		Stroke* s = strokes[i];
+		if (s->m_hide == 0 && s->m_body && !s->m_body->IsSleeping() && s->moved())
+		{
+			s->transformBody();
+		}
+		else if (s->m_awake && (s->m_hide || s->m_body->IsSleeping()))
+		{
+			// Back to the shared slots until it wakes.
+			s->releaseAwake();
+		}
+		if (!s->m_awake)
+		{
+			shared++;
+		}
+	}
+	growXformSlots(shared);
 }
@@ -0,0 +1,131 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <algorithm>
+
+#include "StrokeIndex.h"
+#include "Stroke.h"
+
+StrokeIndex::StrokeIndex(const Rect& bounds, int cellSize)
+	: m_bounds(bounds), m_cell(cellSize), m_valid(false), m_query(0)
+{
+	m_cols = (bounds.br.x - bounds.tl.x) / cellSize + 1;
+	m_rows = (bounds.br.y - bounds.tl.y) / cellSize + 1;
+}
+
+void StrokeIndex::invalidate()
+{
+	m_valid = false;
+}
+
+void StrokeIndex::cellRange(const Rect& r, int& x0, int& y0, int& x1, int& y1) const
+{
+	x0 = MIN(MAX((r.tl.x - m_bounds.tl.x) / m_cell, 0), m_cols - 1);
+	y0 = MIN(MAX((r.tl.y - m_bounds.tl.y) / m_cell, 0), m_rows - 1);
+	x1 = MIN(MAX((r.br.x - m_bounds.tl.x) / m_cell, 0), m_cols - 1);
+	y1 = MIN(MAX((r.br.y - m_bounds.tl.y) / m_cell, 0), m_rows - 1);
+}
+
+void StrokeIndex::update(Array<Stroke*>& strokes)
+{
+	if (m_valid && m_boxes.size() == strokes.size())
+	{
+		return;
+	}
+
+	int n = strokes.size();
+	m_boxes.resize(n);
+	m_stamp.resize(n);
+	m_start.resize(m_cols * m_rows + 1);
+	memset(&m_start[0], 0, m_start.size() * sizeof(int));
+
+	// Count the entries per cell, then place them: entries for a cell end
+	// up in stroke order.
+	int x0, y0, x1, y1;
+	for (int i=0; i<n; i++)
+	{
+		m_boxes[i] = strokes[i]->extent();
+		m_stamp[i] = 0;
+		cellRange(m_boxes[i], x0, y0, x1, y1);
+		for (int y=y0; y<=y1; y++)
+		{
+			for (int x=x0; x<=x1; x++)
+			{
+				m_start[y * m_cols + x + 1]++;
+			}
+		}
+	}
+	for (int c=0; c<m_cols * m_rows; c++)
+	{
+		m_start[c + 1] += m_start[c];
+	}
+
+	m_entries.resize(m_start[m_cols * m_rows]);
+	for (int i=0; i<n; i++)
+	{
+		cellRange(m_boxes[i], x0, y0, x1, y1);
+		for (int y=y0; y<=y1; y++)
+		{
+			for (int x=x0; x<=x1; x++)
+			{
+				m_entries[m_start[y * m_cols + x]++] = i;
+			}
+		}
+	}
+	// Placing advanced each start to the next cell's; shift them back.
+	for (int c=m_cols * m_rows; c>0; c--)
+	{
+		m_start[c] = m_start[c - 1];
+	}
+	m_start[0] = 0;
+
+	m_query = 0;
+	m_valid = true;
+}
+
+void StrokeIndex::query(const Rect& r, Array<int>& found)
+{
+	found.empty();
+	if (!m_valid)
+	{
+		return;
+	}
+
+	int x0, y0, x1, y1;
+	cellRange(r, x0, y0, x1, y1);
+	m_query++;
+	for (int y=y0; y<=y1; y++)
+	{
+		for (int x=x0; x<=x1; x++)
+		{
+			int c = y * m_cols + x;
+			for (int e=m_start[c]; e<m_start[c + 1]; e++)
+			{
+				int i = m_entries[e];
+				if (m_stamp[i] != m_query && r.intersects(m_boxes[i]))
+				{
+					m_stamp[i] = m_query;
+					found.append(i);
+				}
+			}
+		}
+	}
+
+	if (found.size() > 1)
+	{
+		std::sort(&found[0], &found[0] + found.size());
+	}
+}
@@ -0,0 +1,223 @@
+/*
+ * This file is part of NumptyPhysics
+ * Copyright (C) 2008 Tim Edmonds
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of the
+ * License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __vita__
+#include <psp2/io/stat.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "Scene.h"
+#include "ThumbnailCache.h"
+
+// A thumbnail on disk: this header, the level file's name, the pixels.
+struct ThumbnailHeader
+{
+	char      magic[4];
+	int       width;
+	int       height;
+	long long modified;
+	int       nameLength;
+};
+
+static const char THUMB_MAGIC[4] = { 'N', 'P', 'T', 'H' };
+
+// When the level file last changed, in whatever units the platform keeps;
+// -1 if it isn't there.
+static long long modifiedTime(const std::string& file)
+{
+#ifdef __vita__
+	SceIoStat st;
+	if (sceIoGetstat(file.c_str(), &st) < 0)
+	{
+		return -1;
+	}
+	const SceDateTime& t = st.st_mtime;
+	return (((((long long)t.year * 12 + t.month) * 31 + t.day) * 24 + t.hour) * 60
+			+ t.minute) * 60 * 1000000LL + t.second * 1000000LL + t.microsecond;
+#else
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0)
+	{
+		return -1;
+	}
+	return (long long)st.st_mtime;
+#endif
+}
+
+static void makeDir(const std::string& dir)
+{
+#ifdef __vita__
+	sceIoMkdir(dir.c_str(), 0777);
+#else
+	mkdir(dir.c_str(), 0777);
+#endif
+}
+
+ThumbnailCache::ThumbnailCache(const char* dir)
+	: m_dir(dir), m_canvas(THUMB_WIDTH, THUMB_HEIGHT), m_clock(0),
+	  m_hits(0), m_loads(0), m_renders(0)
+{
+	m_canvas.setScale((float)THUMB_WIDTH / CANVAS_WIDTH, (float)THUMB_HEIGHT / CANVAS_HEIGHT);
+	m_canvas.setThreads(RENDER_THREADS);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	for (int i=0; i<m_entries.size(); i++)
+	{
+		delete m_entries[i];
+	}
+}
+
+const Uint16* ThumbnailCache::get(const std::string& file)
+{
+	long long modified = modifiedTime(file);
+	if (modified < 0)
+	{
+		return NULL;
+	}
+
+	// The level's own entry if it has one, else a free or the least
+	// recently used.
+	Entry* e = NULL;
+	for (int i=0; i<m_entries.size(); i++)
+	{
+		if (m_entries[i]->file == file)
+		{
+			e = m_entries[i];
+			break;
+		}
+	}
+	if (e && e->modified == modified)
+	{
+		e->used = ++m_clock;
+		m_hits++;
+		return e->pixels;
+	}
+	if (!e && m_entries.size() < THUMB_CACHE)
+	{
+		e = new Entry;
+		m_entries.append(e);
+	}
+	if (!e)
+	{
+		e = m_entries[0];
+		for (int i=1; i<m_entries.size(); i++)
+		{
+			if (m_entries[i]->used < e->used) e = m_entries[i];
+		}
+	}
+
+	e->file = file;
+	e->modified = modified;
+	e->used = ++m_clock;
+	if (load(e))
+	{
+		m_loads++;
+		return e->pixels;
+	}
+	if (!render(file, e->pixels))
+	{
+		e->modified = -1;
+		return NULL;
+	}
+	m_renders++;
+	save(e);
+	return e->pixels;
+}
+
+bool ThumbnailCache::render(const std::string& file, Uint16* pixels)
+{
+	Scene scene(true);
+	if (!scene.load(file))
+	{
+		return false;
+	}
+	scene.draw(&m_canvas, Rect(0, 0, THUMB_WIDTH-1, THUMB_HEIGHT-1));
+	memcpy(pixels, m_canvas.scale(1), THUMB_WIDTH * THUMB_HEIGHT * 2);
+	return true;
+}
+
+// Named for a hash of the level's path; the path itself is kept inside
+// to tell apart two that hash the same.
+std::string ThumbnailCache::diskFile(const std::string& file) const
+{
+	unsigned long long h = 14695981039346656037ULL;
+	for (size_t i=0; i<file.size(); i++)
+	{
+		h = (h ^ (unsigned char)file[i]) * 1099511628211ULL;
+	}
+	char name[32];
+	sprintf(name, "/%016llx.thumb", h);
+	return m_dir + name;
+}
+
+bool ThumbnailCache::load(Entry* e) const
+{
+	FILE* fp = fopen(diskFile(e->file).c_str(), "rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	ThumbnailHeader header;
+	bool ok = fread(&header, sizeof(header), 1, fp) == 1
+		&& memcmp(header.magic, THUMB_MAGIC, 4) == 0
+		&& header.width == THUMB_WIDTH && header.height == THUMB_HEIGHT
+		&& header.modified == e->modified
+		&& header.nameLength == (int)e->file.size();
+	if (ok)
+	{
+		std::string name(header.nameLength, '\0');
+		ok = fread(&name[0], 1, name.size(), fp) == name.size() && name == e->file
+			&& fread(e->pixels, sizeof(e->pixels), 1, fp) == 1;
+	}
+	fclose(fp);
+	return ok;
+}
+
+// Failing to save only costs drawing the thumbnail again next time.
+void ThumbnailCache::save(const Entry* e) const
+{
+	makeDir(m_dir);
+	std::string path = diskFile(e->file);
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!fp)
+	{
+		return;
+	}
+
+	ThumbnailHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, THUMB_MAGIC, 4);
+	header.width = THUMB_WIDTH;
+	header.height = THUMB_HEIGHT;
+	header.modified = e->modified;
+	header.nameLength = (int)e->file.size();
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(e->file.data(), 1, e->file.size(), fp) == e->file.size()
+		&& fwrite(e->pixels, sizeof(e->pixels), 1, fp) == 1;
+	fclose(fp);
+	if (!ok)
+	{
+		remove(path.c_str());
+	}
+}